@@ -0,0 +1,286 @@
+
+/*-------------------------------------------------------------*/
+/*--- Block sorting machinery                               ---*/
+/*---                                           blocksort.c ---*/
+/*-------------------------------------------------------------*/
+
+/* ------------------------------------------------------------------
+   This file is part of bzip2/libbzip2, a program and library for
+   lossless, block-sorting data compression.
+
+   bzip2/libbzip2 version 1.0.6 of 6 September 2010
+   Copyright (C) 1996-2010 Julian Seward <jseward@bzip.org>
+
+   Please read the WARNING, DISCLAIMER and PATENTS sections in the
+   README file.
+
+   This program is released under the terms of the license contained
+   in the file LICENSE.
+   ------------------------------------------------------------------ */
+
+/* This is not the upstream blocksort.c, which was missing from this
+   tree.  The rotations of the block are sorted by building the suffix
+   array of the block written out twice, with SA-IS (Nong, Zhang and
+   Chan, "Two efficient algorithms for linear time suffix array
+   construction").  Any two rotations that differ do so within their
+   first nblock bytes, so the suffixes starting in the first copy come
+   out in rotation order; rotations that are equal all the way round
+   give the same output byte whichever way they are ordered.  Linear in
+   nblock however repetitive the block is, so workFactor is ignored.
+*/
+
+#include "bzlib_private.h"
+
+/*---------------------------------------------*/
+/*--- Fallback: no memory for the suffix    ---*/
+/*--- array, heap sort comparing rotations  ---*/
+/*---------------------------------------------*/
+
+static
+Int32 rotCmp ( UChar* block, Int32 nblock, UInt32 i1, UInt32 i2 )
+{
+   Int32 k;
+   for (k = 0; k < nblock; k++) {
+      if (block[i1] != block[i2])
+         return (block[i1] > block[i2]) ? 1 : -1;
+      if (++i1 == nblock) i1 = 0;
+      if (++i2 == nblock) i2 = 0;
+   }
+   return 0;
+}
+
+static
+void rotSift ( UInt32* ptr, UChar* block, Int32 nblock,
+               Int32 root, Int32 n )
+{
+   Int32  child;
+   UInt32 tmp = ptr[root];
+   while ((child = 2 * root + 1) < n) {
+      if (child + 1 < n &&
+          rotCmp ( block, nblock, ptr[child + 1], ptr[child] ) > 0)
+         child++;
+      if (rotCmp ( block, nblock, ptr[child], tmp ) <= 0) break;
+      ptr[root] = ptr[child];
+      root = child;
+   }
+   ptr[root] = tmp;
+}
+
+static
+void heapSort ( UInt32* ptr, UChar* block, Int32 nblock )
+{
+   Int32  i;
+   UInt32 tmp;
+   for (i = 0; i < nblock; i++) ptr[i] = i;
+   for (i = nblock / 2 - 1; i >= 0; i--)
+      rotSift ( ptr, block, nblock, i, nblock );
+   for (i = nblock - 1; i > 0; i--) {
+      tmp = ptr[0]; ptr[0] = ptr[i]; ptr[i] = tmp;
+      rotSift ( ptr, block, nblock, 0, i );
+   }
+}
+
+
+/*---------------------------------------------*/
+/*--- SA-IS                                 ---*/
+/*---------------------------------------------*/
+
+/*-- The text is n symbols from [0 .. k-1], bytes at the top level
+     (cs == 1) and Int32 names in the recursion (cs == 4), followed by
+     a virtual sentinel at position n that is smaller than every
+     symbol.  SA has room for n+1 entries and SA[0] is always the
+     sentinel.
+--*/
+
+#define SA_L 0
+#define SA_S 1
+
+#define chr(i)    ((cs == 1) ? (Int32)((UChar*)T)[i] : ((Int32*)T)[i])
+
+#define isLMS(i)    ((i) > 0 && t[i] == SA_S && t[(i)-1] == SA_L)
+
+static
+void saBuckets ( Int32* cnt, Int32* bkt, Int32 k, Bool end )
+{
+   Int32 i, sum = 1;
+   for (i = 0; i < k; i++) {
+      sum += cnt[i];
+      bkt[i] = end ? sum : sum - cnt[i];
+   }
+}
+
+static
+void saInduce ( void* T, Int32* SA, UChar* t, Int32 n,
+                Int32* cnt, Int32* bkt, Int32 k, Int32 cs )
+{
+   Int32 i, j;
+
+   saBuckets ( cnt, bkt, k, False );
+   for (i = 0; i <= n; i++) {
+      j = SA[i] - 1;
+      if (j >= 0 && t[j] == SA_L) SA[bkt[chr(j)]++] = j;
+   }
+   saBuckets ( cnt, bkt, k, True );
+   for (i = n; i >= 0; i--) {
+      j = SA[i] - 1;
+      if (j >= 0 && t[j] == SA_S) SA[--bkt[chr(j)]] = j;
+   }
+}
+
+static
+Bool saSort ( bz_stream* strm, void* T, Int32* SA, Int32 n, Int32 k,
+              Int32 cs, Int32 depth, Int32 verb )
+{
+   UChar* t;
+   Int32* cnt;
+   Int32* bkt;
+   Int32* s1;
+   Int32  i, j, d, n1, name, pos, prev;
+   Bool   diff, ok = True;
+
+   t   = BZALLOC( n + 1 );
+   cnt = BZALLOC( 2 * k * sizeof(Int32) );
+   if (t == NULL || cnt == NULL) {
+      if (t != NULL) BZFREE(t);
+      if (cnt != NULL) BZFREE(cnt);
+      return False;
+   }
+   bkt = cnt + k;
+
+   /*-- classify: S if smaller than the next suffix, else L --*/
+   t[n] = SA_S;
+   if (n > 0) t[n-1] = SA_L;
+   for (i = n - 2; i >= 0; i--)
+      t[i] = (chr(i) < chr(i+1) ||
+              (chr(i) == chr(i+1) && t[i+1] == SA_S)) ? SA_S : SA_L;
+
+   for (i = 0; i < k; i++) cnt[i] = 0;
+   for (i = 0; i < n; i++) cnt[chr(i)]++;
+
+   /*-- stage 1: induce the order of the LMS substrings --*/
+   saBuckets ( cnt, bkt, k, True );
+   for (i = 0; i <= n; i++) SA[i] = -1;
+   SA[0] = n;
+   for (i = n - 1; i > 0; i--)
+      if (isLMS(i)) SA[--bkt[chr(i)]] = i;
+   saInduce ( T, SA, t, n, cnt, bkt, k, cs );
+
+   /*-- pack the sorted LMS positions into the front of SA --*/
+   n1 = 0;
+   for (i = 0; i <= n; i++)
+      if (SA[i] == n || isLMS(SA[i])) SA[n1++] = SA[i];
+
+   /*-- name them; equal substrings share a name.  LMS positions
+        are at least 2 apart, so pos/2 is a free slot behind them --*/
+   for (i = n1; i <= n; i++) SA[i] = -1;
+   name = 0;
+   prev = -1;
+   for (i = 0; i < n1; i++) {
+      pos  = SA[i];
+      diff = False;
+      for (d = 0; ; d++) {
+         if (prev == -1 || pos + d == n || prev + d == n ||
+             chr(pos+d) != chr(prev+d) || t[pos+d] != t[prev+d]) {
+            diff = True;
+            break;
+         }
+         if (d > 0 && (isLMS(pos+d) || isLMS(prev+d))) break;
+      }
+      if (diff) { name++; prev = pos; }
+      SA[n1 + pos / 2] = name - 1;
+   }
+   for (i = n, j = n; i >= n1; i--)
+      if (SA[i] >= 0) SA[j--] = SA[i];
+
+   /*-- stage 2: sort the reduced string, its last name is the
+        sentinel's 0, the recursion supplies that virtually --*/
+   s1 = SA + n + 1 - n1;
+   if (name < n1) {
+      if (verb >= 4)
+         VPrintf3 ( "        depth %d: %d LMS suffixes, %d names\n",
+                    depth, n1, name );
+      ok = saSort ( strm, s1, SA, n1 - 1, name, 4, depth + 1, verb );
+   } else {
+      for (i = 0; i < n1; i++) SA[s1[i]] = i;
+   }
+
+   if (ok) {
+      /*-- stage 3: LMS suffixes in order, then induce the rest --*/
+      for (i = 1, j = 0; i <= n; i++)
+         if (isLMS(i)) s1[j++] = i;
+      for (i = 0; i < n1; i++) SA[i] = s1[SA[i]];
+      for (i = n1; i <= n; i++) SA[i] = -1;
+      saBuckets ( cnt, bkt, k, True );
+      for (i = n1 - 1; i > 0; i--) {
+         j = SA[i];
+         SA[i] = -1;
+         SA[--bkt[chr(j)]] = j;
+      }
+      saInduce ( T, SA, t, n, cnt, bkt, k, cs );
+   }
+
+   BZFREE(cnt);
+   BZFREE(t);
+   return ok;
+}
+
+#undef chr
+#undef isLMS
+
+
+/*---------------------------------------------*/
+/* Pre:
+      nblock > 0
+      arr2 exists for [0 .. nblock-1 +N_OVERSHOOT]
+      ((UChar*)arr2)  [0 .. nblock-1] holds block
+      arr1 exists for [0 .. nblock-1]
+
+   Post:
+      ((UChar*)arr2) [0 .. nblock-1] holds block
+      arr1 [0 .. nblock-1] holds sorted order
+*/
+void BZ2_blockSort ( EState* s )
+{
+   bz_stream* strm  = s->strm;
+   UInt32*    ptr   = s->ptr;
+   UChar*     block = s->block;
+   Int32      nblock = s->nblock;
+   UChar*     text;
+   Int32*     sa;
+   Int32      i, j;
+   Bool       ok = False;
+
+   if (s->verbosity >= 3)
+      VPrintf1 ( "      suffix sort of %d rotations\n", nblock );
+
+   text = BZALLOC( 2 * nblock );
+   sa   = BZALLOC( (2 * nblock + 1) * sizeof(Int32) );
+   if (text != NULL && sa != NULL) {
+      memcpy ( text, block, nblock );
+      memcpy ( text + nblock, block, nblock );
+      ok = saSort ( strm, text, sa, 2 * nblock, 256, 1, 0, s->verbosity );
+      if (ok)
+         for (i = 1, j = 0; i <= 2 * nblock; i++)
+            if (sa[i] < nblock) ptr[j++] = sa[i];
+   }
+   if (text != NULL) BZFREE(text);
+   if (sa != NULL) BZFREE(sa);
+
+   if (!ok) {
+      if (s->verbosity >= 3)
+         VPrintf0 ( "      no memory for the suffix array, using heap sort\n" );
+      heapSort ( ptr, block, nblock );
+   }
+
+   s->origPtr = -1;
+   for (i = 0; i < s->nblock; i++)
+      if (ptr[i] == 0)
+         { s->origPtr = i; break; };
+
+   AssertH( s->origPtr != -1, 1003 );
+}
+
+
+/*-------------------------------------------------------------*/
+/*--- end                                       blocksort.c ---*/
+/*-------------------------------------------------------------*/
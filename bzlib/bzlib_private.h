@@ -114,6 +114,7 @@ extern void bz_internal_error ( int errcode );
 
 #define BZ_MAX_ALPHA_SIZE 258
 #define BZ_MAX_CODE_LEN    23
+#define BZ_HUFF_LOOKUP     10
 
 #define BZ_RUNA 0
 #define BZ_RUNB 1
@@ -407,6 +408,7 @@ typedef
       Int32    base   [BZ_N_GROUPS][BZ_MAX_ALPHA_SIZE];
       Int32    perm   [BZ_N_GROUPS][BZ_MAX_ALPHA_SIZE];
       Int32    minLens[BZ_N_GROUPS];
+      UInt16   lookup [BZ_N_GROUPS][1 << BZ_HUFF_LOOKUP];
 
       /* save area for scalars in the main decompress code */
       Int32    save_i;
@@ -491,6 +493,9 @@ extern void
 BZ2_hbCreateDecodeTables ( Int32*, Int32*, Int32*, UChar*,
                            Int32,  Int32, Int32 );
 
+extern void
+BZ2_hbCreateLookup ( UInt16*, Int32*, Int32*, Int32*, Int32 );
+
 
 #endif
 
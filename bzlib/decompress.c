@@ -40,6 +40,20 @@ void makeMaps_d ( DState* s )
 #define RETURN(rrr)                               \
    { retVal = rrr; goto save_state_and_return; };
 
+#define BZ_PULL_BYTE                              \
+   {                                              \
+      s->bsBuff                                   \
+         = (s->bsBuff << 8) |                     \
+           ((UInt32)                              \
+              (*((UChar*)(s->strm->next_in))));   \
+      s->bsLive += 8;                             \
+      s->strm->next_in++;                         \
+      s->strm->avail_in--;                        \
+      s->strm->total_in_lo32++;                   \
+      if (s->strm->total_in_lo32 == 0)            \
+         s->strm->total_in_hi32++;                \
+   }
+
 #define GET_BITS(lll,vvv,nnn)                     \
    case lll: s->state = lll;                      \
    while (True) {                                 \
@@ -52,16 +66,7 @@ void makeMaps_d ( DState* s )
          break;                                   \
       }                                           \
       if (s->strm->avail_in == 0) RETURN(BZ_OK);  \
-      s->bsBuff                                   \
-         = (s->bsBuff << 8) |                     \
-           ((UInt32)                              \
-              (*((UChar*)(s->strm->next_in))));   \
-      s->bsLive += 8;                             \
-      s->strm->next_in++;                         \
-      s->strm->avail_in--;                        \
-      s->strm->total_in_lo32++;                   \
-      if (s->strm->total_in_lo32 == 0)            \
-         s->strm->total_in_hi32++;                \
+      BZ_PULL_BYTE;                               \
    }
 
 #define GET_UCHAR(lll,uuu)                        \
@@ -85,6 +90,22 @@ void makeMaps_d ( DState* s )
       gBase = &(s->base[gSel][0]);                \
    }                                              \
    groupPos--;                                    \
+   /* short codes: one table probe.  every symbol \
+      has 80 bits of trailer behind it, so the    \
+      look-ahead never reads past the stream */   \
+   while (s->bsLive < BZ_HUFF_LOOKUP &&           \
+          s->strm->avail_in > 0) {                \
+      BZ_PULL_BYTE;                               \
+   }                                              \
+   zt = 0;                                        \
+   if (s->bsLive >= BZ_HUFF_LOOKUP)               \
+      zt = s->lookup[gSel][(s->bsBuff >>          \
+              (s->bsLive - BZ_HUFF_LOOKUP))       \
+              & ((1 << BZ_HUFF_LOOKUP) - 1)];     \
+   if (zt != 0) {                                 \
+      s->bsLive -= zt & 0xf;                      \
+      lval = zt >> 4;                             \
+   } else {                                       \
    zn = gMinlen;                                  \
    GET_BITS(label1, zvec, zn);                    \
    while (1) {                                    \
@@ -99,6 +120,7 @@ void makeMaps_d ( DState* s )
        || zvec - gBase[zn] >= BZ_MAX_ALPHA_SIZE)  \
       RETURN(BZ_DATA_ERROR);                      \
    lval = gPerm[zvec - gBase[zn]];                \
+   }                                              \
 }
 
 
@@ -343,6 +365,13 @@ Int32 BZ2_decompress ( DState* s )
             &(s->len[t][0]),
             minLen, maxLen, alphaSize
          );
+         BZ2_hbCreateLookup (
+            &(s->lookup[t][0]),
+            &(s->limit[t][0]),
+            &(s->base[t][0]),
+            &(s->perm[t][0]),
+            minLen
+         );
          s->minLens[t] = minLen;
       }
 
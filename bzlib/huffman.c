@@ -200,6 +200,38 @@ void BZ2_hbCreateDecodeTables ( Int32 *limit,
 }
 
 
+/*---------------------------------------------------*/
+/* One probe resolves any code of up to BZ_HUFF_LOOKUP
+   bits: each entry is (symbol << 4) | code length, 0 for
+   prefixes of longer codes.  Filled by running the
+   limit/base search on every prefix, so a hit decodes
+   exactly what the bit-at-a-time path would, corrupt
+   tables included; anything the search rejects is left
+   0 for that path to report.
+*/
+void BZ2_hbCreateLookup ( UInt16 *lookup,
+                          Int32 *limit,
+                          Int32 *base,
+                          Int32 *perm,
+                          Int32 minLen )
+{
+   Int32 i, zn, zvec;
+
+   for (i = 0; i < (1 << BZ_HUFF_LOOKUP); i++) {
+      lookup[i] = 0;
+      for (zn = minLen; zn <= BZ_HUFF_LOOKUP; zn++) {
+         zvec = i >> (BZ_HUFF_LOOKUP - zn);
+         if (zvec <= limit[zn]) {
+            if (zvec - base[zn] >= 0 &&
+                zvec - base[zn] < BZ_MAX_ALPHA_SIZE)
+               lookup[i] = (UInt16)((perm[zvec - base[zn]] << 4) | zn);
+            break;
+         }
+      }
+   }
+}
+
+
 /*-------------------------------------------------------------*/
 /*--- end                                         huffman.c ---*/
 /*-------------------------------------------------------------*/
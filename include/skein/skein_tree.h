@@ -0,0 +1,67 @@
+#ifndef _SKEIN_TREE_H_
+#define _SKEIN_TREE_H_     1
+/**************************************************************************
+**
+** Interface declarations for incremental Skein-512 tree hashing.
+**
+** The tree is the one in the Skein spec (and Skein_TreeHash() in
+** skein_test.c): leaves of 2**leaf blocks of message, nodes of 2**node
+** child results, and a last level (maxLevel) that takes whatever is left
+** as one node. The result is the same as the all-in-one reference.
+**
+** Leaves don't depend on each other, so Skein_512_Tree_Leaf() only reads
+** the tree context and may run on any number of threads at once. Their
+** results go to Skein_512_Tree_Add() in message order, which builds the
+** upper levels as they arrive: memory is bounded by the tree height, not
+** the message length.
+**
+***************************************************************************/
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "skein.h"
+
+#define  SKEIN_TREE_MAX_HEIGHT (64)          /* more levels need more than 2**64 bytes */
+
+typedef struct
+    {
+    Skein_512_Ctxt_t s;                      /* the node being filled */
+    u64b_t  offs;                            /* bytes fed to this level so far */
+    u64b_t  nodeCnt;                         /* nodes finished on this level */
+    size_t  fill;                            /* bytes in the open node, 0 if none */
+    u08b_t  last[SKEIN_512_STATE_BYTES];     /* result of the last node finished */
+    } Skein_512_Tree_Level_t;
+
+typedef struct
+    {
+    Skein_512_Ctxt_t G;                      /* config done, every node starts here */
+    uint_t  leaf,node,maxLevel;              /* log2 leaf blocks, log2 fan-out, height limit */
+    u64b_t  msgOffs;                         /* message bytes covered by the leaves added */
+    Skein_512_Tree_Level_t L[SKEIN_TREE_MAX_HEIGHT+1];   /* L[1] are the leaves */
+    } Skein_512_Tree_Ctxt_t;
+
+/* leaf, node as in SKEIN_CFG_TREE_INFO, both > 0. maxLevel >= 2, 0xFF for no limit */
+int  Skein_512_Tree_Init (Skein_512_Tree_Ctxt_t *ctx, size_t hashBitLen, uint_t leaf, uint_t node,
+                          uint_t maxLevel, const u08b_t *key, size_t keyBytes);
+
+/* message bytes in a full leaf */
+size_t Skein_512_Tree_Leaf_Bytes(const Skein_512_Tree_Ctxt_t *ctx);
+
+/* hash the leaf at message offset offs (a multiple of the leaf size), msgByteCnt */
+/* bytes of it, at most a full leaf. reentrant. the result goes to Tree_Add */
+int  Skein_512_Tree_Leaf (const Skein_512_Tree_Ctxt_t *ctx, const u08b_t *msg, size_t msgByteCnt,
+                          u64b_t offs, u08b_t *leafRes);
+
+/* add the next leaf result, msgByteCnt is what went into that leaf */
+int  Skein_512_Tree_Add  (Skein_512_Tree_Ctxt_t *ctx, const u08b_t *leafRes, size_t msgByteCnt);
+
+/* close every level and output the hash. an empty message is one empty leaf */
+int  Skein_512_Tree_Final(Skein_512_Tree_Ctxt_t *ctx, u08b_t *hashVal);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* ifndef _SKEIN_TREE_H_ */
@@ -73,6 +73,15 @@ typedef enum {
 	YESCRYPT_SHARED_PREALLOCATED = 0x100
 } yescrypt_init_shared_flags_t;
 
+/**
+ * Possible values for yescrypt_reserve_local()'s flags argument.
+ */
+typedef enum {
+	YESCRYPT_LOCAL_DEFAULTS = 0,
+	YESCRYPT_LOCAL_PREFAULT = 1,
+	YESCRYPT_LOCAL_MLOCK = 2
+} yescrypt_local_flags_t;
+
 /**
  * Possible values for the flags argument of yescrypt_kdf(),
  * yescrypt_gensalt_r(), yescrypt_gensalt().  These may be OR'ed together,
@@ -153,6 +162,31 @@ extern int yescrypt_init_local(yescrypt_local_t * __local);
  */
 extern int yescrypt_free_local(yescrypt_local_t * __local);
 
+/**
+ * yescrypt_reserve_local(local, size, flags):
+ * Allocate the thread-local (RAM) data structure up front, at least size
+ * bytes (see yescrypt_local_size()), instead of on the first yescrypt_kdf()
+ * call.  With YESCRYPT_LOCAL_PREFAULT every page is touched right away, and
+ * with YESCRYPT_LOCAL_MLOCK the region is also locked into RAM, so that any
+ * number of later yescrypt_kdf() calls reusing local run without page faults.
+ * A region that is already large enough is kept as is.
+ *
+ * Return 0 on success; or -1 on error, in which case local is left empty.
+ *
+ * MT-safe as long as local is local to the thread.
+ */
+extern int yescrypt_reserve_local(yescrypt_local_t * __local, size_t __size,
+    yescrypt_local_flags_t __flags);
+
+/**
+ * yescrypt_local_size(N, r, p, g, flags):
+ * Return the number of bytes of thread-local (RAM) data structure that
+ * yescrypt_kdf() with these parameters will need, taking hash upgrades into
+ * account; or 0 if the parameters are out of range.
+ */
+extern size_t yescrypt_local_size(uint64_t __N, uint32_t __r, uint32_t __p,
+    uint32_t __g, yescrypt_flags_t __flags);
+
 /**
  * yescrypt_kdf(shared, local, passwd, passwdlen, salt, saltlen,
  *     N, r, p, t, g, flags, buf, buflen):
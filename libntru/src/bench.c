@@ -1,10 +1,36 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include "ntru.h"
+#include "poly.h"
+#include "hash.h"
+#include "mgf.h"
+#include "idxgen.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
 #define NUM_ITER_KEYGEN 50
 #define NUM_ITER_ENCDEC 10000
+#define NUM_ITER_KERNEL 1000
+#define NUM_ITER_INVERT 50
+#define SHA_INPUT_LEN 64
+#define SPARSE_MAX_ONES 13   /* below NTRU_SPARSE_THRESH in poly.c */
+
+/* kernels that are in the library but not in its headers */
+void ntru_mod3_standard(NtruIntPoly *p);
+#ifdef __SSSE3__
+void ntru_mod3_sse(NtruIntPoly *p);
+uint8_t ntru_mult_tern_sse_sparse(NtruIntPoly *a, NtruTernPoly *b, NtruIntPoly *c, uint16_t mod_mask);
+uint8_t ntru_mult_tern_sse_dense(NtruIntPoly *a, NtruTernPoly *b, NtruIntPoly *c, uint16_t mod_mask);
+#endif
+#ifdef __AVX2__
+void ntru_mod3_avx2(NtruIntPoly *p);
+uint8_t ntru_mult_tern_avx2_sparse(NtruIntPoly *a, NtruTernPoly *b, NtruIntPoly *c, uint16_t mod_mask);
+uint8_t ntru_mult_tern_avx2_dense(NtruIntPoly *a, NtruTernPoly *b, NtruIntPoly *c, uint16_t mod_mask);
+#endif
+void ntru_gen_blind_poly(uint8_t *seed, uint16_t seed_len, const NtruEncParams *params, NtruPrivPoly *r);
 
 /*
  * The __MACH__ and __MINGW32__ code below is from
@@ -144,15 +170,191 @@ void print_time(char *label, double *samples, int num_samples) {
     fflush(stdout);
 }
 
-int main(int argc, char **argv) {
-    printf("Please wait...\n");
+/*
+ * Per-kernel timing. Every variant compiled into this build is timed on its
+ * own, not just the one the dispatchers pick, so a -mavx2 build covers the
+ * portable, SSSE3 and AVX2 code. Times are in TSC cycles on x86, ns elsewhere.
+ */
 
-    NtruEncParams param_arr[] = ALL_PARAM_SETS;
+#if defined(__x86_64__) || defined(__i386__)
+#define TICK_UNIT "cycles"
+static uint64_t ticks() {
+    return __rdtsc();
+}
+#else
+#define TICK_UNIT "ns"
+static uint64_t ticks() {
+    struct timespec t;
+    clock_gettime(CLOCK_REALTIME, &t);
+    return (uint64_t)t.tv_sec*1000000000 + t.tv_nsec;
+}
+#endif
+
+double samples_kernel[NUM_ITER_KERNEL];
+
+#define TIME_KERNEL(label, iter, call) do {                     \
+    uint32_t k;                                                 \
+    for (k=0; k<(iter); k++) {                                  \
+        uint64_t c1 = ticks();                                  \
+        call;                                                   \
+        samples_kernel[k] = ticks() - c1;                       \
+    }                                                           \
+    printf("  %-24s %12.0f\n", label, median(samples_kernel, iter)); \
+    fflush(stdout);                                             \
+} while (0)
+
+void rand_int_poly(uint16_t N, uint16_t q, NtruIntPoly *p, NtruRandContext *rand_ctx) {
+    uint16_t i;
+    p->N = N;
+    ntru_rand_generate((uint8_t*)p->coeffs, N*sizeof(p->coeffs[0]), rand_ctx);
+    for (i=0; i<N; i++)
+        p->coeffs[i] &= q - 1;
+}
+
+uint8_t bench_kernels(NtruEncParams *params) {
+    uint16_t N = params->N;
+    uint16_t q = params->q;
     uint8_t success = 1;
+    NtruRandGen rng = NTRU_RNG_DEFAULT;
+    NtruRandContext rand_ctx;
+    NtruEncKeyPair kp;
+    NtruIntPoly a, b, c;
+    NtruTernPoly sparse, dense;
+    NtruPrivPoly r;
+    uint8_t arr[ntru_enc_len(params)];
+    uint16_t seed_len = (N*2+7) / 8;
+    uint8_t seed[seed_len];
+    uint8_t sha_in[8][SHA_INPUT_LEN], sha_out[8][32];
+    uint8_t *sha_inp[8], *sha_outp[8];
+    uint8_t i;
+
+    success &= ntru_rand_init(&rand_ctx, &rng) == NTRU_SUCCESS;
+    success &= ntru_gen_key_pair(params, &kp, &rand_ctx) == NTRU_SUCCESS;
+    rand_int_poly(N, q, &a, &rand_ctx);
+    rand_int_poly(N, q, &b, &rand_ctx);
+    /* sparse like the factors of a product-form key, dense like g */
+    uint16_t sparse_ones = params->df1<SPARSE_MAX_ONES ? params->df1 : SPARSE_MAX_ONES;
+    success &= ntru_rand_tern(N, sparse_ones, sparse_ones, &sparse, &rand_ctx);
+    success &= ntru_rand_tern(N, params->dg, params->dg, &dense, &rand_ctx);
+    success &= ntru_rand_generate(seed, seed_len, &rand_ctx) == NTRU_SUCCESS;
+    for (i=0; i<8; i++) {
+        success &= ntru_rand_generate(sha_in[i], SHA_INPUT_LEN, &rand_ctx) == NTRU_SUCCESS;
+        sha_inp[i] = sha_in[i];
+        sha_outp[i] = sha_out[i];
+    }
+
+    printf("%-10s   N=%d q=%d df1=%d dg=%d%s, " TICK_UNIT "/call\n", params->name, N, q,
+           params->df1, params->dg, params->prod_flag ? " product form" : "");
+    TIME_KERNEL("mult_int", NUM_ITER_KERNEL, ntru_mult_int(&a, &b, &c, q-1));
+    TIME_KERNEL("mult_int_16", NUM_ITER_KERNEL, ntru_mult_int_16(&a, &b, &c, q-1));
+    TIME_KERNEL("mult_int_64", NUM_ITER_KERNEL, ntru_mult_int_64(&a, &b, &c, q-1));
+#ifdef __SSSE3__
+    TIME_KERNEL("mult_int_sse", NUM_ITER_KERNEL, ntru_mult_int_sse(&a, &b, &c, q-1));
+#endif
+#ifdef __AVX2__
+    TIME_KERNEL("mult_int_avx2", NUM_ITER_KERNEL, ntru_mult_int_avx2(&a, &b, &c, q-1));
+#endif
+
+    TIME_KERNEL("mult_tern sparse", NUM_ITER_KERNEL, ntru_mult_tern(&a, &sparse, &c, q-1));
+    TIME_KERNEL("mult_tern_32 sparse", NUM_ITER_KERNEL, ntru_mult_tern_32(&a, &sparse, &c, q-1));
+    TIME_KERNEL("mult_tern_64 sparse", NUM_ITER_KERNEL, ntru_mult_tern_64(&a, &sparse, &c, q-1));
+#ifdef __SSSE3__
+    TIME_KERNEL("mult_tern_sse_sparse", NUM_ITER_KERNEL, ntru_mult_tern_sse_sparse(&a, &sparse, &c, q-1));
+#endif
+#ifdef __AVX2__
+    TIME_KERNEL("mult_tern_avx2_sparse", NUM_ITER_KERNEL, ntru_mult_tern_avx2_sparse(&a, &sparse, &c, q-1));
+#endif
+    TIME_KERNEL("mult_tern dense", NUM_ITER_KERNEL, ntru_mult_tern(&a, &dense, &c, q-1));
+    TIME_KERNEL("mult_tern_32 dense", NUM_ITER_KERNEL, ntru_mult_tern_32(&a, &dense, &c, q-1));
+    TIME_KERNEL("mult_tern_64 dense", NUM_ITER_KERNEL, ntru_mult_tern_64(&a, &dense, &c, q-1));
+#ifdef __SSSE3__
+    TIME_KERNEL("mult_tern_sse_dense", NUM_ITER_KERNEL, ntru_mult_tern_sse_dense(&a, &dense, &c, q-1));
+#endif
+#ifdef __AVX2__
+    TIME_KERNEL("mult_tern_avx2_dense", NUM_ITER_KERNEL, ntru_mult_tern_avx2_dense(&a, &dense, &c, q-1));
+#endif
+#ifndef NTRU_AVOID_HAMMING_WT_PATENT
+    if (kp.priv.t.prod_flag)
+        TIME_KERNEL("mult_prod", NUM_ITER_KERNEL, ntru_mult_prod(&a, &kp.priv.t.poly.prod, &c, q-1));
+#endif
+
+    /* mod3 works in place; once reduced it does the same work again */
+    memcpy(&c, &a, sizeof c);
+    TIME_KERNEL("mod3", NUM_ITER_KERNEL, ntru_mod3(&c));
+    TIME_KERNEL("mod3_standard", NUM_ITER_KERNEL, ntru_mod3_standard(&c));
+#ifdef __SSSE3__
+    TIME_KERNEL("mod3_sse", NUM_ITER_KERNEL, ntru_mod3_sse(&c));
+#endif
+#ifdef __AVX2__
+    TIME_KERNEL("mod3_avx2", NUM_ITER_KERNEL, ntru_mod3_avx2(&c));
+#endif
+
+    TIME_KERNEL("to_arr", NUM_ITER_KERNEL, ntru_to_arr(&a, q, arr));
+    TIME_KERNEL("to_arr_32", NUM_ITER_KERNEL, ntru_to_arr_32(&a, q, arr));
+    TIME_KERNEL("to_arr_64", NUM_ITER_KERNEL, ntru_to_arr_64(&a, q, arr));
+#ifdef __SSSE3__
+    if (q == 2048)
+        TIME_KERNEL("to_arr_sse_2048", NUM_ITER_KERNEL, ntru_to_arr_sse_2048(&a, arr));
+#endif
+    TIME_KERNEL("from_arr", NUM_ITER_KERNEL, ntru_from_arr(arr, N, q, &c));
+
+    TIME_KERNEL("invert", NUM_ITER_INVERT, ntru_invert(&kp.priv.t, q-1, &c));
+    TIME_KERNEL("invert_32", NUM_ITER_INVERT, ntru_invert_32(&kp.priv.t, q-1, &c));
+    TIME_KERNEL("invert_64", NUM_ITER_INVERT, ntru_invert_64(&kp.priv.t, q-1, &c));
 
+    TIME_KERNEL("MGF", NUM_ITER_KERNEL, ntru_MGF(seed, seed_len, params, &c));
+    TIME_KERNEL("IGF blinding poly", NUM_ITER_KERNEL, ntru_gen_blind_poly(seed, seed_len, params, &r));
+
+    TIME_KERNEL("sha256", NUM_ITER_KERNEL, ntru_sha256(sha_in[0], SHA_INPUT_LEN, sha_out[0]));
+    TIME_KERNEL("sha256_4way", NUM_ITER_KERNEL, ntru_sha256_4way(sha_inp, SHA_INPUT_LEN, sha_outp));
+    TIME_KERNEL("sha256_8way", NUM_ITER_KERNEL, ntru_sha256_8way(sha_inp, SHA_INPUT_LEN, sha_outp));
+
+    success &= ntru_rand_release(&rand_ctx) == NTRU_SUCCESS;
+    return success;
+}
+
+void usage() {
+    printf("usage: bench [ops|kernels] [param set ...]\n");
+    printf("  ops      whole keygen/encrypt/decrypt only\n");
+    printf("  kernels  " TICK_UNIT " per call of each kernel only\n");
+    printf("  both, for every parameter set, if nothing is given\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    NtruEncParams param_arr[] = ALL_PARAM_SETS;
+    uint8_t success = 1;
+    uint8_t do_ops = 1, do_kernels = 1;
     uint8_t param_idx;
-    for (param_idx=0; param_idx<sizeof(param_arr)/sizeof(param_arr[0]); param_idx++) {
+    int argi, first_set = 1;
+
+    if (argc>1 && strcmp(argv[1], "ops")==0) {
+        do_kernels = 0;
+        first_set = 2;
+    }
+    else if (argc>1 && strcmp(argv[1], "kernels")==0) {
+        do_ops = 0;
+        first_set = 2;
+    }
+    for (argi=first_set; argi<argc; argi++) {
+        for (param_idx=0; param_idx<sizeof(param_arr)/sizeof(param_arr[0]); param_idx++)
+            if (strcmp(argv[argi], param_arr[param_idx].name) == 0)
+                break;
+        if (param_idx == sizeof(param_arr)/sizeof(param_arr[0]))
+            usage();
+    }
+
+    printf("Please wait...\n");
+
+    for (param_idx=0; do_ops && param_idx<sizeof(param_arr)/sizeof(param_arr[0]); param_idx++) {
         NtruEncParams params = param_arr[param_idx];
+        if (first_set < argc) {
+            for (argi=first_set; argi<argc; argi++)
+                if (strcmp(argv[argi], params.name) == 0)
+                    break;
+            if (argi == argc)
+                continue;
+        }
         NtruEncKeyPair kp;
         uint32_t i;
         struct timespec t1, t2;
@@ -201,6 +403,18 @@ int main(int argc, char **argv) {
         printf("\n");
     }
 
+    for (param_idx=0; do_kernels && param_idx<sizeof(param_arr)/sizeof(param_arr[0]); param_idx++) {
+        if (first_set < argc) {
+            for (argi=first_set; argi<argc; argi++)
+                if (strcmp(argv[argi], param_arr[param_idx].name) == 0)
+                    break;
+            if (argi == argc)
+                continue;
+        }
+        printf("\n");
+        success &= bench_kernels(&param_arr[param_idx]);
+    }
+
     if (!success)
         printf("Error!\n");
     return success ? 0 : 1;
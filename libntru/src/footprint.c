@@ -0,0 +1,259 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "ntru.h"
+#include "poly.h"
+#include "mgf.h"
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+/*
+ * Reports how much stack and heap each operation needs, per parameter set.
+ *
+ * Stack: every operation runs on a thread of its own, and the stack below
+ * the caller's frame is filled with a known byte just before the call;
+ * whatever is no longer that byte afterwards was used. That counts the bytes
+ * an operation touches, so a buffer it declares but never writes doesn't
+ * show. The same measurement of an empty function is subtracted.
+ *
+ * Heap: on glibc, malloc and friends are wrapped while an operation runs
+ * and the peak of live bytes is recorded. Elsewhere the heap columns are
+ * left empty.
+ */
+
+#define FP_STACK_SIZE (4*1024*1024)
+#define FP_PAINT 0xA5
+#define FP_SLACK 64   /* left alone below the caller's frame, for memset's own */
+
+void ntru_gen_blind_poly(uint8_t *seed, uint16_t seed_len, const NtruEncParams *params, NtruPrivPoly *r);
+
+typedef struct FpArgs {
+    NtruEncParams *params;
+    NtruEncKeyPair kp;
+    NtruRandContext rand_ctx;
+    uint8_t plain[256];
+    uint16_t plain_len;
+    uint8_t enc[4096];
+    uint8_t dec[256];
+    NtruIntPoly c;
+    NtruPrivPoly r;
+    uint8_t seed[64];
+    uint8_t ok;
+    void (*op)(struct FpArgs *args);
+    uint8_t *stack;
+    size_t stack_used;
+} FpArgs;
+
+#ifdef __GLIBC__
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t nmemb, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void __libc_free(void *ptr);
+
+static int fp_heap_on;
+static long long fp_heap_live, fp_heap_peak, fp_heap_allocs;
+
+static void fp_heap_add(void *p, long long n) {
+    if (!fp_heap_on || !p)
+        return;
+    fp_heap_live += n;
+    if (n > 0)
+        fp_heap_allocs++;
+    if (fp_heap_live > fp_heap_peak)
+        fp_heap_peak = fp_heap_live;
+}
+
+void *malloc(size_t size) {
+    void *p = __libc_malloc(size);
+    fp_heap_add(p, p ? malloc_usable_size(p) : 0);
+    return p;
+}
+
+void *calloc(size_t nmemb, size_t size) {
+    void *p = __libc_calloc(nmemb, size);
+    fp_heap_add(p, p ? malloc_usable_size(p) : 0);
+    return p;
+}
+
+void *realloc(void *ptr, size_t size) {
+    long long old = ptr ? malloc_usable_size(ptr) : 0;
+    void *p = __libc_realloc(ptr, size);
+    if (p) {
+        fp_heap_add(p, -old);
+        fp_heap_add(p, malloc_usable_size(p));
+    }
+    return p;
+}
+
+void free(void *ptr) {
+    if (ptr)
+        fp_heap_add(ptr, -(long long)malloc_usable_size(ptr));
+    __libc_free(ptr);
+}
+#endif   /* __GLIBC__ */
+
+void fp_nothing(FpArgs *a) {
+}
+
+void fp_keygen(FpArgs *a) {
+    a->ok &= ntru_gen_key_pair(a->params, &a->kp, &a->rand_ctx) == NTRU_SUCCESS;
+}
+
+void fp_encrypt(FpArgs *a) {
+    a->ok &= ntru_encrypt(a->plain, a->plain_len, &a->kp.pub, a->params, &a->rand_ctx, a->enc) == NTRU_SUCCESS;
+}
+
+void fp_decrypt(FpArgs *a) {
+    uint16_t dec_len;
+    a->ok &= ntru_decrypt(a->enc, &a->kp, a->params, a->dec, &dec_len) == NTRU_SUCCESS;
+}
+
+void fp_mult_int(FpArgs *a) {
+    ntru_mult_int(&a->kp.pub.h, &a->kp.pub.h, &a->c, a->params->q-1);
+}
+
+void fp_mult_priv(FpArgs *a) {
+    ntru_mult_priv(&a->kp.priv.t, &a->kp.pub.h, &a->c, a->params->q-1);
+}
+
+void fp_invert(FpArgs *a) {
+    ntru_invert(&a->kp.priv.t, a->params->q-1, &a->c);
+}
+
+void fp_mgf(FpArgs *a) {
+    ntru_MGF(a->seed, sizeof a->seed, a->params, &a->c);
+}
+
+void fp_blind_poly(FpArgs *a) {
+    ntru_gen_blind_poly(a->seed, sizeof a->seed, a->params, &a->r);
+}
+
+void *fp_thread(void *arg) {
+    FpArgs *a = arg;
+    uint8_t *sp = __builtin_frame_address(0);
+    size_t i;
+
+    /* thread startup may have gone deeper than this frame, paint over it */
+    memset(a->stack, FP_PAINT, sp - FP_SLACK - a->stack);
+#ifdef __GLIBC__
+    fp_heap_live = fp_heap_peak = fp_heap_allocs = 0;
+    fp_heap_on = 1;
+#endif
+    a->op(a);
+#ifdef __GLIBC__
+    fp_heap_on = 0;
+#endif
+    for (i=0; a->stack+i<sp && a->stack[i]==FP_PAINT; i++);   /* the stack grows down */
+    a->stack_used = sp - (a->stack+i);
+    return NULL;
+}
+
+/** Runs op on a thread of its own and returns the number of stack bytes it touched */
+size_t fp_stack(FpArgs *a, void (*op)(FpArgs *a)) {
+    pthread_attr_t attr;
+    pthread_t thread;
+
+    if (posix_memalign((void**)&a->stack, 4096, FP_STACK_SIZE) != 0)
+        return 0;
+    a->op = op;
+    a->stack_used = 0;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, a->stack, FP_STACK_SIZE);
+    if (pthread_create(&thread, &attr, fp_thread, a) == 0)
+        pthread_join(thread, NULL);
+    else
+        a->ok = 0;
+    pthread_attr_destroy(&attr);
+    free(a->stack);
+    return a->stack_used;
+}
+
+uint8_t fp_params(NtruEncParams *params) {
+    static struct {
+        const char *name;
+        void (*op)(FpArgs *a);
+    } ops[] = {
+        {"keygen", fp_keygen},
+        {"encrypt", fp_encrypt},
+        {"decrypt", fp_decrypt},
+        {"mult_int", fp_mult_int},
+        {"mult_priv", fp_mult_priv},
+        {"invert", fp_invert},
+        {"MGF", fp_mgf},
+        {"IGF blinding poly", fp_blind_poly},
+    };
+    NtruRandGen rng = NTRU_RNG_DEFAULT;
+    FpArgs *a = calloc(1, sizeof *a);
+    size_t base, used;
+    uint8_t i;
+
+    if (!a)
+        return 0;
+    a->params = params;
+    a->ok = ntru_rand_init(&a->rand_ctx, &rng) == NTRU_SUCCESS;
+    a->ok &= ntru_gen_key_pair(params, &a->kp, &a->rand_ctx) == NTRU_SUCCESS;
+    a->plain_len = ntru_max_msg_len(params);
+    a->ok &= ntru_rand_generate(a->plain, a->plain_len, &a->rand_ctx) == NTRU_SUCCESS;
+    a->ok &= ntru_rand_generate(a->seed, sizeof a->seed, &a->rand_ctx) == NTRU_SUCCESS;
+    a->ok &= ntru_encrypt(a->plain, a->plain_len, &a->kp.pub, params, &a->rand_ctx, a->enc) == NTRU_SUCCESS;
+
+    printf("%s (N=%d)\n", params->name, params->N);
+    printf("  %-20s %12s %12s %8s\n", "operation", "stack bytes", "heap peak", "allocs");
+    base = fp_stack(a, fp_nothing);
+    for (i=0; i<sizeof(ops)/sizeof(ops[0]); i++) {
+        used = fp_stack(a, ops[i].op);
+        used = used>base ? used-base : 0;
+#ifdef __GLIBC__
+        printf("  %-20s %12zu %12lld %8lld\n", ops[i].name, used, fp_heap_peak, fp_heap_allocs);
+#else
+        printf("  %-20s %12zu %12s %8s\n", ops[i].name, used, "", "");
+#endif
+    }
+    printf("\n");
+
+    uint8_t ok = a->ok;
+    ntru_rand_release(&a->rand_ctx);
+    free(a);
+    return ok;
+}
+
+void usage() {
+    printf("usage: footprint [param set ...]\n");
+    printf("  peak stack and heap of each operation, every parameter set if none is given\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    NtruEncParams param_arr[] = ALL_PARAM_SETS;
+    uint8_t success = 1;
+    uint8_t param_idx;
+    int argi;
+
+    for (argi=1; argi<argc; argi++) {
+        for (param_idx=0; param_idx<sizeof(param_arr)/sizeof(param_arr[0]); param_idx++)
+            if (strcmp(argv[argi], param_arr[param_idx].name) == 0)
+                break;
+        if (param_idx == sizeof(param_arr)/sizeof(param_arr[0]))
+            usage();
+    }
+
+    printf("sizeof NtruIntPoly %zu, NtruTernPoly %zu, NtruPrivPoly %zu, NtruEncKeyPair %zu\n\n",
+           sizeof(NtruIntPoly), sizeof(NtruTernPoly), sizeof(NtruPrivPoly), sizeof(NtruEncKeyPair));
+
+    for (param_idx=0; param_idx<sizeof(param_arr)/sizeof(param_arr[0]); param_idx++) {
+        if (argc > 1) {
+            for (argi=1; argi<argc; argi++)
+                if (strcmp(argv[argi], param_arr[param_idx].name) == 0)
+                    break;
+            if (argi == argc)
+                continue;
+        }
+        success &= fp_params(&param_arr[param_idx]);
+    }
+
+    if (!success)
+        printf("Error!\n");
+    return success ? 0 : 1;
+}
@@ -451,6 +451,10 @@ uint8_t ntru_decrypt(uint8_t *enc, NtruEncKeyPair *kp, const NtruEncParams *para
     uint16_t blen = db / 8;
     uint8_t retcode = NTRU_SUCCESS;
 
+    /*
+     * Three polynomials are enough: cR is computed over e, cmtrin over ci and
+     * cR_prime over mask, each once the former is no longer needed.
+     */
     NtruIntPoly e;
     ntru_from_arr(enc, N, q, &e);
     NtruIntPoly ci;
@@ -459,23 +463,23 @@ uint8_t ntru_decrypt(uint8_t *enc, NtruEncKeyPair *kp, const NtruEncParams *para
     if (!ntru_check_rep_weight(&ci, dm0) && retcode==NTRU_SUCCESS)
         retcode = NTRU_ERR_DM0_VIOLATION;
 
-    NtruIntPoly cR = e;
-    ntru_sub(&cR, &ci);
-    ntru_mod_mask(&cR, q-1);
+    NtruIntPoly *cR = &e;
+    ntru_sub(cR, &ci);
+    ntru_mod_mask(cR, q-1);
 
     uint16_t coR4_len = (N*2+7) / 8;
     uint8_t coR4[coR4_len];
-    ntru_to_arr4(&cR, (uint8_t*)&coR4);
+    ntru_to_arr4(cR, (uint8_t*)&coR4);
 
     NtruIntPoly mask;
     ntru_MGF((uint8_t*)&coR4, coR4_len, params, &mask);
-    NtruIntPoly cmtrin = ci;
-    ntru_sub(&cmtrin, &mask);
-    ntru_mod3(&cmtrin);
+    NtruIntPoly *cmtrin = &ci;
+    ntru_sub(cmtrin, &mask);
+    ntru_mod3(cmtrin);
     uint16_t cM_len_bits = (N*3+1) / 2;
     uint16_t cM_len_bytes = (cM_len_bits+7) / 8;
     uint8_t cM[cM_len_bytes+3];   /* 3 extra bytes for ntru_to_sves() */
-    if (!ntru_to_sves(&cmtrin, (uint8_t*)&cM) && retcode==NTRU_SUCCESS)
+    if (!ntru_to_sves(cmtrin, (uint8_t*)&cM) && retcode==NTRU_SUCCESS)
         retcode = NTRU_ERR_INVALID_ENCODING;
 
     uint8_t cb[blen];
@@ -504,9 +508,9 @@ uint8_t ntru_decrypt(uint8_t *enc, NtruEncKeyPair *kp, const NtruEncParams *para
 
     NtruPrivPoly cr;
     ntru_gen_blind_poly((uint8_t*)&sdata, sdata_len, params, &cr);
-    NtruIntPoly cR_prime;
-    ntru_mult_priv(&cr, &kp->pub.h, &cR_prime, q-1);
-    if (!ntru_equals_int(&cR_prime, &cR) && retcode==NTRU_SUCCESS)
+    NtruIntPoly *cR_prime = &mask;
+    ntru_mult_priv(&cr, &kp->pub.h, cR_prime, q-1);
+    if (!ntru_equals_int(cR_prime, cR) && retcode==NTRU_SUCCESS)
         retcode = NTRU_ERR_INVALID_ENCODING;
 
     *dec_len = cl;
@@ -160,17 +160,21 @@ void ntru_mult_karatsuba_16(int16_t *a, int16_t *b, int16_t *c, uint16_t len, ui
         ntru_mult_int_16_base(a, b, c, len, N, -1);
     else {
         uint16_t len2 = len / 2;
-        int16_t z0[NTRU_INT_POLY_SIZE];
-        int16_t z1[NTRU_INT_POLY_SIZE];
-        int16_t z2[NTRU_INT_POLY_SIZE];
+        /*
+         * products of the halves have at most len-len2 coefficients, but the
+         * base case writes up to index 2*(len-len2)+1 <= len+2
+         */
+        int16_t z0[len+3];
+        int16_t z1[len+3];
+        int16_t z2[len+3];
 
         /* z0, z2 */
         ntru_mult_karatsuba_16(a, b, z0, len2, N);
         ntru_mult_karatsuba_16(a+len2, b+len2, z2, len-len2, N);
 
         /* z1 */
-        int16_t lh1[NTRU_INT_POLY_SIZE];
-        int16_t lh2[NTRU_INT_POLY_SIZE];
+        int16_t lh1[len-len2];
+        int16_t lh2[len-len2];
         uint16_t i;
         for (i=0; i<len2; i++) {
             lh1[i] = a[i] + a[len2+i];
@@ -188,7 +192,8 @@ void ntru_mult_karatsuba_16(int16_t *a, int16_t *b, int16_t *c, uint16_t len, ui
             z1[i] -= z2[i];
 
         /* c */
-        memset(c, 0, NTRU_INT_POLY_SIZE*2);
+        /* all of c at the top, else the 2*len-1 coefficients of the product */
+        memset(c, 0, 2*(len==N ? NTRU_INT_POLY_SIZE : 2*len-1));
         memcpy(c, z0, 2*(2*len2-1));   /* 2*len2-1 coefficients */
         uint16_t c_idx = len2;
         for (i=0; i<2*(len-len2)-1; i++) {
@@ -278,17 +283,21 @@ void ntru_mult_karatsuba_64(int16_t *a, int16_t *b, int16_t *c, uint16_t len, ui
         ntru_mult_int_64_base(a, b, c, len, N, mod_mask);
     else {
         uint16_t len2 = len / 2;
-        int16_t z0[NTRU_INT_POLY_SIZE];
-        int16_t z1[NTRU_INT_POLY_SIZE];
-        int16_t z2[NTRU_INT_POLY_SIZE];
+        /*
+         * products of the halves have at most len-len2 coefficients, but the
+         * base case writes up to index 2*(len-len2)+1 <= len+2
+         */
+        int16_t z0[len+3];
+        int16_t z1[len+3];
+        int16_t z2[len+3];
 
         /* z0, z2 */
         ntru_mult_karatsuba_64(a, b, z0, len2, N, mod_mask);
         ntru_mult_karatsuba_64(a+len2, b+len2, z2, len-len2, N, mod_mask);
 
         /* z1 */
-        int16_t lh1[NTRU_INT_POLY_SIZE];
-        int16_t lh2[NTRU_INT_POLY_SIZE];
+        int16_t lh1[len-len2];
+        int16_t lh2[len-len2];
         uint16_t i;
         for (i=0; i<len2; i++) {
             lh1[i] = a[i] + a[len2+i];
@@ -306,7 +315,8 @@ void ntru_mult_karatsuba_64(int16_t *a, int16_t *b, int16_t *c, uint16_t len, ui
             z1[i] -= z2[i];
 
         /* c */
-        memset(c, 0, NTRU_INT_POLY_SIZE*2);
+        /* all of c at the top, else the 2*len-1 coefficients of the product */
+        memset(c, 0, 2*(len==N ? NTRU_INT_POLY_SIZE : 2*len-1));
         memcpy(c, z0, 2*(2*len2-1));   /* 2*len2-1 coefficients */
         uint16_t c_idx = len2;
         for (i=0; i<2*(len-len2)-1; i++) {
@@ -345,7 +355,8 @@ uint8_t ntru_mult_int_sse(NtruIntPoly *a, NtruIntPoly *b, NtruIntPoly *c, uint16
     if (N != b->N)
         return 0;
     c->N = N;
-    int16_t c_coeffs[2*NTRU_INT_POLY_SIZE];   /* double capacity for intermediate result */
+    /* double capacity for intermediate result, the last stores reach index 2*N+21 */
+    int16_t c_coeffs[2*N+32];
     memset(&c_coeffs, 0, sizeof(c_coeffs));
 
     uint16_t k;
@@ -402,7 +413,8 @@ uint8_t ntru_mult_int_avx2(NtruIntPoly *a, NtruIntPoly *b, NtruIntPoly *c, uint1
     if (N != b->N)
         return 0;
     c->N = N;
-    int16_t c_coeffs[2*NTRU_INT_POLY_SIZE];   /* double capacity for intermediate result */
+    /* double capacity for intermediate result, the last stores reach index 2*N+21 */
+    int16_t c_coeffs[2*N+32];
     memset(&c_coeffs, 0, sizeof(c_coeffs));
 
     uint16_t k;
@@ -959,9 +971,9 @@ uint8_t ntru_mult_prod(NtruIntPoly *a, NtruProdPoly *b, NtruIntPoly *c, uint16_t
     NtruIntPoly temp;
     ntru_mult_tern(a, &b->f1, &temp, mod_mask);
     ntru_mult_tern(&temp, &b->f2, c, mod_mask);
-    NtruIntPoly f3a;
-    ntru_mult_tern(a, &b->f3, &f3a, mod_mask);
-    ntru_add(c, &f3a);
+    NtruIntPoly *f3a = &temp;   /* temp is free again */
+    ntru_mult_tern(a, &b->f3, f3a, mod_mask);
+    ntru_add(c, f3a);
 
     ntru_mod_mask(c, mod_mask);
     return 1;
@@ -0,0 +1,122 @@
+/***********************************************************************
+**
+** Incremental Skein-512 tree hashing, see skein_tree.h.
+**
+** Every node of level k starts from the config result G with T[0] set to
+** the byte offset of its input within level k and the tree level in T[1],
+** exactly as Skein_TreeHash() in skein_test.c does it level by level.
+**
+************************************************************************/
+
+#include <string.h>      /* get the memcpy/memset functions */
+#include "skein_tree.h"  /* get the Skein tree API definitions */
+
+/* start a node of the given level at input offset offs */
+static void Skein_512_Tree_Start(const Skein_512_Tree_Ctxt_t *ctx,Skein_512_Ctxt_t *s,uint_t level,u64b_t offs)
+    {
+    *s = ctx->G;
+    s->h.T[0] = offs;                           /* nonzero initial offset in tweak! */
+    Skein_Set_Tree_Level(s->h,level);
+    }
+
+static void Skein_512_Tree_Push(Skein_512_Tree_Ctxt_t *ctx,uint_t level,const u08b_t *res);
+
+/* finish the open node of a level, its result goes up a level */
+static void Skein_512_Tree_Close(Skein_512_Tree_Ctxt_t *ctx,uint_t level)
+    {
+    Skein_512_Tree_Level_t *L = &ctx->L[level];
+
+    Skein_512_Final_Pad(&L->s,L->last);
+    L->nodeCnt++;
+    L->fill = 0;
+    if (level < ctx->maxLevel)
+        Skein_512_Tree_Push(ctx,level+1,L->last);
+    }
+
+/* feed one child result to the open node of a level (level >= 2) */
+static void Skein_512_Tree_Push(Skein_512_Tree_Ctxt_t *ctx,uint_t level,const u08b_t *res)
+    {
+    Skein_512_Tree_Level_t *L = &ctx->L[level];
+
+    if (L->fill == 0)
+        Skein_512_Tree_Start(ctx,&L->s,level,L->offs);
+    Skein_512_Update(&L->s,res,SKEIN_512_STATE_BYTES);
+    L->fill += SKEIN_512_STATE_BYTES;
+    L->offs += SKEIN_512_STATE_BYTES;
+    if ((level < ctx->maxLevel) && (L->fill == ((size_t) SKEIN_512_BLOCK_BYTES << ctx->node)))
+        Skein_512_Tree_Close(ctx,level);
+    }
+
+int Skein_512_Tree_Init(Skein_512_Tree_Ctxt_t *ctx,size_t hashBitLen,uint_t leaf,uint_t node,
+                        uint_t maxLevel,const u08b_t *key,size_t keyBytes)
+    {
+    int r;
+
+    if (leaf == 0 || node == 0 || leaf > 32 || node > 32 || maxLevel < 2 || maxLevel > 0xFF)
+        return SKEIN_FAIL;
+    memset(ctx,0,sizeof(*ctx));
+    r = Skein_512_InitExt(&ctx->G,hashBitLen,SKEIN_CFG_TREE_INFO(leaf,node,maxLevel),key,keyBytes);
+    if (r != SKEIN_SUCCESS)
+        return r;
+    ctx->leaf     = leaf;
+    ctx->node     = node;
+    ctx->maxLevel = (maxLevel > SKEIN_TREE_MAX_HEIGHT) ? SKEIN_TREE_MAX_HEIGHT : maxLevel;
+    return SKEIN_SUCCESS;
+    }
+
+size_t Skein_512_Tree_Leaf_Bytes(const Skein_512_Tree_Ctxt_t *ctx)
+    {
+    return (size_t) SKEIN_512_BLOCK_BYTES << ctx->leaf;
+    }
+
+int Skein_512_Tree_Leaf(const Skein_512_Tree_Ctxt_t *ctx,const u08b_t *msg,size_t msgByteCnt,
+                        u64b_t offs,u08b_t *leafRes)
+    {
+    Skein_512_Ctxt_t s;
+
+    if (msgByteCnt > Skein_512_Tree_Leaf_Bytes(ctx))
+        return SKEIN_FAIL;
+    Skein_512_Tree_Start(ctx,&s,1,offs);
+    if (msgByteCnt)
+        Skein_512_Update(&s,msg,msgByteCnt);
+    Skein_512_Final_Pad(&s,leafRes);
+    return SKEIN_SUCCESS;
+    }
+
+int Skein_512_Tree_Add(Skein_512_Tree_Ctxt_t *ctx,const u08b_t *leafRes,size_t msgByteCnt)
+    {
+    size_t leafBytes = Skein_512_Tree_Leaf_Bytes(ctx);
+
+    if (ctx->msgOffs % leafBytes)               /* only the last leaf can be short */
+        return SKEIN_FAIL;
+    ctx->msgOffs += msgByteCnt;
+    ctx->L[1].nodeCnt++;
+    memcpy(ctx->L[1].last,leafRes,SKEIN_512_STATE_BYTES);
+    Skein_512_Tree_Push(ctx,2,leafRes);
+    return SKEIN_SUCCESS;
+    }
+
+int Skein_512_Tree_Final(Skein_512_Tree_Ctxt_t *ctx,u08b_t *hashVal)
+    {
+    Skein_512_Ctxt_t s;
+    u08b_t res[SKEIN_512_STATE_BYTES];
+    uint_t level;
+
+    if (ctx->L[1].nodeCnt == 0)                 /* (msgBytes == 0) is still one leaf */
+        {
+        Skein_512_Tree_Leaf(ctx,NULL,0,0,res);
+        Skein_512_Tree_Add(ctx,res,0);
+        }
+    for (level=1;;level++)                      /* walk up the tree */
+        {
+        if (ctx->L[level].fill)
+            Skein_512_Tree_Close(ctx,level);
+        if (ctx->L[level].nodeCnt == 1 || level == ctx->maxLevel)
+            break;                              /* one node: this is the root */
+        }
+
+    /* the output stage only needs the root's chaining value */
+    s = ctx->G;
+    Skein_Get64_LSB_First(s.X,ctx->L[level].last,SKEIN_512_STATE_WORDS);
+    return Skein_512_Output(&s,hashVal);
+    }
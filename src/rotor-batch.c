@@ -0,0 +1,165 @@
+/*****************************************************************************
+ * (c) 2016 BSD 2 clause adouble42/mrn@sdf                                   *
+ * rotor - "If knowledge can create problems, it is not through ignorance    *
+ * that we can solve them." -- isaac asimov                                  *
+ *                                                                           *
+ * rotor-batch.c - many files per run on one unlocked key                    *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "ntru.h"
+#include "rotor.h"
+#include "rotor-crypt.h"
+#include "rotor-batch.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+static double rotor_batch_secs(const struct timespec *a, const struct timespec *b) {
+  return (b->tv_sec - a->tv_sec) + (b->tv_nsec - a->tv_nsec) / 1e9;
+}
+
+static int rotor_batch_suffix(const char *s, const char *suffix) {
+  size_t sl = strlen(s), xl = strlen(suffix);
+
+  return (sl > xl) && (strcmp(s + sl - xl, suffix) == 0);
+}
+
+void rotor_batch_add(rotor_batch *b, const char *fname) {
+  char **files;
+
+  if (b->count == b->size) {
+    b->size = b->size ? b->size * 2 : 64;
+    files = (char **)realloc(b->files, b->size * sizeof(char *));
+    if (!files) {
+      printf("rotor_batch_add: out of memory\n");
+      exit(1);
+    }
+    b->files = files;
+  }
+  if ((b->files[b->count] = strdup(fname)) == NULL) {
+    printf("rotor_batch_add: out of memory\n");
+    exit(1);
+  }
+  b->count++;
+}
+
+int rotor_batch_manifest(rotor_batch *b, char *manifest) {
+  char line[PATH_MAX + 2];
+  size_t len;
+  FILE *f;
+
+  if ((f = fopen(manifest, "r")) == NULL) {
+    printf("rotor_batch_manifest: can't open %s\n", manifest);
+    return 1;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    len = strcspn(line, "\r\n");
+    line[len] = '\0';
+    if ((len == 0) || (line[0] == '#'))
+      continue;
+    rotor_batch_add(b, line);
+  }
+  fclose(f);
+  return 0;
+}
+
+int rotor_batch_recurse(rotor_batch *b, char *dir, int dec) {
+  char path[PATH_MAX];
+  struct dirent *de;
+  struct stat st;
+  DIR *d;
+  int rc = 0;
+
+  if ((d = opendir(dir)) == NULL) {
+    printf("rotor_batch_recurse: can't open %s\n", dir);
+    return 1;
+  }
+  while ((de = readdir(d)) != NULL) {
+    if ((strcmp(de->d_name, ".") == 0) || (strcmp(de->d_name, "..") == 0))
+      continue;
+    if (snprintf(path, sizeof(path), "%s/%s", dir, de->d_name) >= sizeof(path)) {
+      printf("rotor_batch_recurse: path too long under %s\n", dir);
+      rc = 1;
+      continue;
+    }
+    if (lstat(path, &st))
+      continue;
+    if (S_ISDIR(st.st_mode)) {
+      rc |= rotor_batch_recurse(b, path, dec);
+    } else if (S_ISREG(st.st_mode)) {
+      if (dec ? rotor_batch_suffix(path, ".enc") :
+	  !(rotor_batch_suffix(path, ".enc") || rotor_batch_suffix(path, ".enc.key")))
+	rotor_batch_add(b, path);
+    }
+  }
+  closedir(d);
+  return rc;
+}
+
+int rotor_batch_run(rotor_batch *b, NtruEncKeyPair *kr, int mode, int dec, int compress) {
+  struct timespec t_start, t_end;
+  uint64_t total = 0;
+  double busy = 0, wall;
+  int threads = 1;
+  int failed = 0;
+  int i;
+
+  if (b->count == 0) {
+    printf("rotor_batch_run: no files\n");
+    return 0;
+  }
+#ifdef _OPENMP
+  threads = omp_get_max_threads();
+  if (threads > b->count)
+    threads = b->count;
+#endif
+  printf("%s %i file(s) on %i thread(s)\n", dec ? "decrypting" : "encrypting", b->count, threads);
+  clock_gettime(CLOCK_MONOTONIC, &t_start);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(threads) reduction(+:total,busy,failed)
+#endif
+  for (i=0; i<b->count; i++) {
+    struct timespec t0, t1;
+    uint64_t len;
+    double secs;
+    int rc;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    rc = rotor_crypt_file_batch(kr, mode, dec, compress, b->files[i], &len);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    secs = rotor_batch_secs(&t0, &t1);
+    if (rc) {
+      printf("  %s: failed after %.3fs\n", b->files[i], secs);
+      failed++;
+      continue;
+    }
+    printf("  %s: %llu bytes in %.3fs, %.2f MB/s\n", b->files[i], (unsigned long long)len,
+	   secs, (secs > 0) ? len / secs / 1e6 : 0);
+    total += len;
+    busy += secs;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t_end);
+  wall = rotor_batch_secs(&t_start, &t_end);
+  printf("%i of %i file(s) done, %llu bytes in %.3fs wall (%.3fs in workers), %.2f MB/s\n",
+	 b->count - failed, b->count, (unsigned long long)total, wall, busy,
+	 (wall > 0) ? total / wall / 1e6 : 0);
+  return failed;
+}
+
+void rotor_batch_free(rotor_batch *b) {
+  int i;
+
+  for (i=0; i<b->count; i++)
+    free(b->files[i]);
+  free(b->files);
+  b->files = NULL;
+  b->count = b->size = 0;
+}
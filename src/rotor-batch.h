@@ -0,0 +1,76 @@
+/*
+ *rotor
+ *Copyright (c) 2016, adouble42/mrn@sdf
+ *All rights reserved.
+ *
+ *Redistribution and use in source and binary forms, with or without
+ *modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ *THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __ROTOR_BATCH_H
+#define __ROTOR_BATCH_H
+
+/*
+ * rotor_batch: list of files for --batch, grown as names are added
+ */
+
+typedef struct rotor_batch {
+  char **files;
+  int count;
+  int size;
+} rotor_batch;
+
+/*
+ * rotor_batch_add: append a copy of fname
+ */
+
+void rotor_batch_add(rotor_batch *b, const char *fname);
+
+/*
+ * rotor_batch_manifest: add the files named in manifest, one per line.
+ * blank lines and lines starting with # are skipped. returns 0 on success
+ */
+
+int rotor_batch_manifest(rotor_batch *b, char *manifest);
+
+/*
+ * rotor_batch_recurse: add every regular file under dir, .enc files for
+ * dec, everything but rotor's own output otherwise. symlinks are not
+ * followed. returns 0 on success
+ */
+
+int rotor_batch_recurse(rotor_batch *b, char *dir, int dec);
+
+/*
+ * rotor_batch_run: encrypt or decrypt (dec) every file in the batch on a
+ * worker pool, one thread per core unless OMP_NUM_THREADS says otherwise.
+ * prints per file timing and the total throughput, returns failure count
+ */
+
+int rotor_batch_run(rotor_batch *b, NtruEncKeyPair *kr, int mode, int dec, int compress);
+
+/*
+ * rotor_batch_free: release the list
+ */
+
+void rotor_batch_free(rotor_batch *b);
+
+#endif
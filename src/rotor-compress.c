@@ -0,0 +1,476 @@
+/*****************************************************************************
+ * (c) 2016 BSD 2 clause adouble42/mrn@sdf                                   *
+ * rotor - "If knowledge can create problems, it is not through ignorance    *
+ * that we can solve them." -- isaac asimov                                  *
+ *                                                                           *
+ * rotor-compress.c - bzip2 stage in front of the cipher                     *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "ntru.h"
+#include "bzlib.h"
+#include "rotor.h"
+#include "rotor-ctx.h"
+#include "rotor-compress.h"
+#include "rotor-stats.h"
+#include "rotor-probe.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __ROTOR_MLOCK
+#include <sys/mman.h>
+#endif
+
+struct rotor_bz_dec {
+  bz_stream bz;
+  int done;        // last bzip2 stream is complete
+  int framed;      // ROTOR_FLAG_FRAMES
+  uint8_t head[ROTOR_BZ_FRAME];
+  int head_len;
+  uint32_t left;   // payload bytes to go in this frame
+  int raw;
+};
+
+/*
+ * rotor_bz_alloc: bzlib's block buffers hold plaintext, keep them out of
+ * swap and burn them on the way out like everything else
+ */
+
+static void *rotor_bz_alloc(void *opaque, int items, int size) {
+  size_t *mem;
+  size_t len = (size_t)items * size;
+
+  mem = (size_t *)malloc(len + sizeof(size_t) * 2); // keeps 16 byte alignment
+  if (!mem)
+    return NULL;
+  mem[0] = len;
+#ifdef __ROTOR_MLOCK
+  mlock(mem, len + sizeof(size_t) * 2);
+#endif
+  return mem + 2;
+}
+
+static void rotor_bz_free(void *opaque, void *p) {
+  size_t *mem = (size_t *)p - 2;
+  size_t len = mem[0] + sizeof(size_t) * 2;
+
+  if (!p)
+    return;
+  burn(mem, len);
+#ifdef __ROTOR_MLOCK
+  munlock(mem, len);
+#endif
+  free(mem);
+}
+
+static void rotor_bz_init(bz_stream *bz) {
+  memset(bz, 0, sizeof(bz_stream));
+  bz->bzalloc = rotor_bz_alloc;
+  bz->bzfree = rotor_bz_free;
+}
+
+/*
+ * rotor_bz_buffers: read buffer, bzip2 side buffer and a cipher buffer that
+ * takes whatever the bzip2 side can hand rotor_ctx_update, plus final
+ */
+
+static void rotor_bz_buffers(rotor_ctx *ctx, uint8_t **inbuf, uint8_t **zbuf, uint8_t **outbuf, size_t *out_size, const char *fn) {
+  *out_size = rotor_ctx_out_max(ctx, ROTOR_BZ_CHUNK) + NTRU_ENCLEN + ROTOR_FINAL_MAX;
+  *inbuf = (uint8_t *)malloc(ROTOR_BZ_CHUNK);
+  *zbuf = (uint8_t *)malloc(ROTOR_BZ_CHUNK);
+  *outbuf = (uint8_t *)malloc(*out_size);
+  if ((!*inbuf) || (!*zbuf) || (!*outbuf)) {
+    printf("%s: out of memory\n", fn);
+    exit(1);
+  }
+#ifdef __ROTOR_MLOCK
+  mlock(*inbuf, ROTOR_BZ_CHUNK);
+  mlock(*zbuf, ROTOR_BZ_CHUNK);
+  mlock(*outbuf, *out_size);
+#endif
+}
+
+static void rotor_bz_release(uint8_t *inbuf, uint8_t *zbuf, uint8_t *outbuf, size_t out_size) {
+  burn(inbuf, ROTOR_BZ_CHUNK);
+  burn(zbuf, ROTOR_BZ_CHUNK);
+  burn(outbuf, out_size);
+#ifdef __ROTOR_MLOCK
+  munlock(inbuf, ROTOR_BZ_CHUNK);
+  munlock(zbuf, ROTOR_BZ_CHUNK);
+  munlock(outbuf, out_size);
+#endif
+  free(inbuf);
+  free(zbuf);
+  free(outbuf);
+}
+
+/*
+ * rotor_bz_compress_block: in as one complete bzip2 stream. *out_len is
+ * the room at out going in, the stream length coming out
+ */
+
+static int rotor_bz_compress_block(const uint8_t *in, size_t len, uint8_t *out, size_t *out_len) {
+  bz_stream bz;
+  int bzrc;
+
+  rotor_bz_init(&bz);
+  if (BZ2_bzCompressInit(&bz, ROTOR_BZ_LEVEL, 0, 0) != BZ_OK)
+    return ROTOR_ERR_COMPRESS;
+  bz.next_in = (char *)in;
+  bz.avail_in = len;
+  bz.next_out = (char *)out;
+  bz.avail_out = *out_len;
+  do {
+    bzrc = BZ2_bzCompress(&bz, BZ_FINISH);
+  } while ((bzrc == BZ_FINISH_OK) && (bz.avail_out));
+  *out_len -= bz.avail_out;
+  BZ2_bzCompressEnd(&bz);
+  return (bzrc == BZ_STREAM_END) ? ROTOR_SUCCESS : ROTOR_ERR_COMPRESS;
+}
+
+/*
+ * rotor_bz_entropy: order 0 entropy in bits per byte, from ROTOR_BZ_SAMPLES
+ * spans spread over the block. jpg, gz, video and the like sit close to 8
+ */
+
+static double rotor_bz_entropy(const uint8_t *in, size_t len) {
+  uint32_t hist[256];
+  size_t span = ROTOR_BZ_SAMPLE_LEN, step, n = 0, i, j;
+  double h = 0, p;
+
+  memset(hist, 0, sizeof(hist));
+  if (len <= ROTOR_BZ_SAMPLES * span) {
+    span = len;
+    step = len + 1;
+  } else {
+    step = (len - span) / (ROTOR_BZ_SAMPLES - 1);
+  }
+  for (i=0; i + span <= len; i += step)
+    for (j=0; j<span; j++)
+      hist[in[i+j]]++;
+  for (i=0; i<256; i++)
+    n += hist[i];
+  for (i=0; i<256; i++) {
+    if (hist[i]) {
+      p = (double)hist[i] / n;
+      h -= p * log2(p);
+    }
+  }
+  return h;
+}
+
+static double rotor_bz_cpu() {
+  struct timespec t;
+
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void rotor_put_frame(uint8_t *p, uint32_t v) {
+  p[0] = v;
+  p[1] = v >> 8;
+  p[2] = v >> 16;
+  p[3] = v >> 24;
+}
+
+/*
+ * rotor_bz_threads: one per core, but only one inside a --batch worker,
+ * the workers have the cores already
+ */
+
+static int rotor_bz_threads() {
+#ifdef _OPENMP
+  return omp_in_parallel() ? 1 : omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+size_t rotor_compress_bound(size_t len) {
+  return ((len + ROTOR_BZ_BLOCK - 1) / ROTOR_BZ_BLOCK) * ROTOR_BZ_STRIDE;
+}
+
+int rotor_compress_blocks(const uint8_t *in, size_t len, uint8_t *out, size_t *out_len, int threads,
+			  struct rotor_compress_stats *stats) {
+  size_t zlen[ROTOR_BZ_MAX_BLOCKS];
+  double cpu[ROTOR_BZ_MAX_BLOCKS];
+  int kind[ROTOR_BZ_MAX_BLOCKS]; // 0 compressed, 1 raw on entropy, 2 raw after trial
+  int blocks, i, fail = 0;
+
+  *out_len = 0;
+  blocks = (len + ROTOR_BZ_BLOCK - 1) / ROTOR_BZ_BLOCK;
+  if (blocks > ROTOR_BZ_MAX_BLOCKS)
+    return ROTOR_ERR_PARAM;
+  if (threads > blocks)
+    threads = blocks;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(threads) reduction(|:fail) if(threads > 1)
+#endif
+  for (i=0; i<blocks; i++) {
+    const uint8_t *src = in + (size_t)i * ROTOR_BZ_BLOCK;
+    uint8_t *dst = out + (size_t)i * ROTOR_BZ_STRIDE;
+    size_t n = len - (size_t)i * ROTOR_BZ_BLOCK;
+    double t0;
+
+    if (n > ROTOR_BZ_BLOCK)
+      n = ROTOR_BZ_BLOCK;
+    kind[i] = 1;
+    cpu[i] = 0;
+    if (rotor_bz_entropy(src, n) < ROTOR_BZ_SKIP_BITS) {
+      t0 = rotor_bz_cpu();
+      zlen[i] = ROTOR_BZ_STRIDE - ROTOR_BZ_FRAME;
+      fail |= rotor_bz_compress_block(src, n, dst + ROTOR_BZ_FRAME, &zlen[i]);
+      cpu[i] = rotor_bz_cpu() - t0;
+      kind[i] = (zlen[i] < n - n / ROTOR_BZ_MIN_GAIN) ? 0 : 2;
+    }
+    if (kind[i]) {
+      memcpy(dst + ROTOR_BZ_FRAME, src, n);
+      zlen[i] = n;
+    }
+    rotor_put_frame(dst, zlen[i] | ((kind[i]) ? 0 : ROTOR_BZ_FRAME_BZIP2));
+  }
+  if (fail)
+    return ROTOR_ERR_COMPRESS;
+  for (i=0; i<blocks; i++) { // pack the frames back to back
+    memmove(out + *out_len, out + (size_t)i * ROTOR_BZ_STRIDE, ROTOR_BZ_FRAME + zlen[i]);
+    *out_len += ROTOR_BZ_FRAME + zlen[i];
+    if (stats) {
+      size_t n = (i == blocks - 1) ? len - (size_t)i * ROTOR_BZ_BLOCK : ROTOR_BZ_BLOCK;
+
+      if (kind[i] == 0) {
+	stats->bz_segs++;
+	stats->bz_bytes += n;
+      } else if (kind[i] == 1) {
+	stats->skip_segs++;
+	stats->skip_bytes += n;
+      } else {
+	stats->trial_segs++;
+	stats->trial_bytes += n;
+      }
+      stats->bz_cpu += cpu[i];
+    }
+  }
+  if (stats) {
+    stats->in_bytes += len;
+    stats->out_bytes += *out_len;
+  }
+  return ROTOR_SUCCESS;
+}
+
+double rotor_compress_saved(const struct rotor_compress_stats *stats) {
+  if (stats->bz_bytes + stats->trial_bytes == 0)
+    return -1;
+  return stats->skip_bytes * stats->bz_cpu / (stats->bz_bytes + stats->trial_bytes);
+}
+
+int rotor_compress_stream(rotor_ctx *ctx, FILE *input, FILE *output, const char *fn) {
+  struct rotor_compress_stats stats;
+  uint8_t *inbuf, *zbuf, *outbuf;
+  size_t nt, in_size, z_size, out_size, z_len, out_len;
+  uint64_t off = 0;
+  double saved;
+  int threads, rc = ROTOR_SUCCESS, werr = 0;
+
+  memset(&stats, 0, sizeof(stats));
+  threads = rotor_bz_threads();
+  if (threads > ROTOR_BZ_MAX_BLOCKS)
+    threads = ROTOR_BZ_MAX_BLOCKS;
+  in_size = (size_t)threads * ROTOR_BZ_BLOCK;
+  z_size = rotor_compress_bound(in_size);
+  out_size = rotor_ctx_out_max(ctx, z_size) + NTRU_ENCLEN + ROTOR_FINAL_MAX;
+  inbuf = (uint8_t *)malloc(in_size);
+  zbuf = (uint8_t *)malloc(z_size);
+  outbuf = (uint8_t *)malloc(out_size);
+  if ((!inbuf) || (!zbuf) || (!outbuf)) {
+    printf("%s: out of memory\n", fn);
+    exit(1);
+  }
+#ifdef __ROTOR_MLOCK
+  mlock(inbuf, in_size);
+  mlock(zbuf, z_size);
+#endif
+  // one frame per block, so blocks compress on their own threads
+  while ((nt = rotor_stats_fread(inbuf, in_size, input))) {
+    if ((rc = rotor_compress_blocks(inbuf, nt, zbuf, &z_len, threads, &stats)))
+      break;
+    ROTOR_PROBE2(chunk_start, off, z_len); // offset into the compressed stream
+    rc = rotor_ctx_update(ctx, zbuf, z_len, outbuf, &out_len);
+    ROTOR_PROBE3(chunk_done, off, z_len, out_len);
+    off += z_len;
+    if (rc)
+      break;
+    if (rotor_stats_fwrite(outbuf, out_len, output) != out_len) {
+      werr = 1;
+      break;
+    }
+  }
+  if (werr) {
+    printf("%s: write error\n", fn);
+    rotor_ctx_final(ctx, outbuf, &out_len);
+    rc = ROTOR_ERR_PARAM;
+  } else if ((rc == ROTOR_SUCCESS) && (ferror(input))) { // not the whole file, don't seal it as if it were
+    printf("%s: read error\n", fn);
+    rotor_ctx_final(ctx, outbuf, &out_len);
+    rc = ROTOR_ERR_LENGTH;
+  } else {
+    if (rc == ROTOR_SUCCESS)
+      rc = rotor_ctx_final(ctx, outbuf, &out_len);
+    if (rc) {
+      printf("%s: %s\n", fn, rotor_ctx_strerror(rc));
+    } else if (rotor_stats_fwrite(outbuf, out_len, output) != out_len) {
+      printf("%s: write error\n", fn);
+      rc = ROTOR_ERR_PARAM;
+    }
+  }
+  if (rc == ROTOR_SUCCESS) {
+    printf("%s: %u segment(s) compressed, %u raw by entropy, %u raw after trial, %llu -> %llu bytes",
+	   fn, stats.bz_segs, stats.skip_segs, stats.trial_segs,
+	   (unsigned long long)stats.in_bytes, (unsigned long long)stats.out_bytes);
+    if ((saved = rotor_compress_saved(&stats)) >= 0)
+      printf(", ~%.2fs CPU saved", saved);
+    printf("\n");
+  }
+  burn(inbuf, in_size);
+  burn(zbuf, z_size);
+  burn(outbuf, out_size);
+#ifdef __ROTOR_MLOCK
+  munlock(inbuf, in_size);
+  munlock(zbuf, z_size);
+#endif
+  free(inbuf);
+  free(zbuf);
+  free(outbuf);
+  return rc;
+}
+
+/*
+ * rotor_bz_drain: decompress plain[0..len) to output. *done is set while
+ * the last bzip2 stream seen is complete, a new one is started if more
+ * follows. a short write is ROTOR_ERR_PARAM with ferror(output) set
+ */
+
+static int rotor_bz_drain(bz_stream *bz, uint8_t *plain, size_t len, uint8_t *zbuf, int *done, FILE *output) {
+  int bzrc;
+
+  bz->next_in = (char *)plain;
+  bz->avail_in = len;
+  while (bz->avail_in) {
+    if (*done) {
+      BZ2_bzDecompressEnd(bz);
+      if (BZ2_bzDecompressInit(bz, 0, 0) != BZ_OK)
+	return ROTOR_ERR_COMPRESS;
+      *done = 0;
+    }
+    do { // a full zbuf may leave output behind in bzlib even with no input left
+      bz->next_out = (char *)zbuf;
+      bz->avail_out = ROTOR_BZ_CHUNK;
+      bzrc = BZ2_bzDecompress(bz);
+      if ((bzrc != BZ_OK) && (bzrc != BZ_STREAM_END))
+	return ROTOR_ERR_COMPRESS;
+      if (rotor_stats_fwrite(zbuf, ROTOR_BZ_CHUNK - bz->avail_out, output) != ROTOR_BZ_CHUNK - bz->avail_out)
+	return ROTOR_ERR_PARAM;
+      if (bzrc == BZ_STREAM_END) {
+	*done = 1;
+	break;
+      }
+    } while ((bz->avail_in) || (bz->avail_out == 0));
+  }
+  return ROTOR_SUCCESS;
+}
+
+/*
+ * rotor_bz_frames: split plain[0..len) into frames, raw ones straight to
+ * output, compressed ones through rotor_bz_drain. frame headers may be cut
+ * anywhere by the caller's buffers. write errors as rotor_bz_drain
+ */
+
+static int rotor_bz_frames(struct rotor_bz_dec *d, uint8_t *plain, size_t len, uint8_t *zbuf, FILE *output) {
+  uint32_t v;
+  size_t n;
+  int rc;
+
+  while (len) {
+    if (d->left == 0) {
+      d->head[d->head_len++] = *plain++;
+      len--;
+      if (d->head_len < ROTOR_BZ_FRAME)
+	continue;
+      d->head_len = 0;
+      v = d->head[0] | (d->head[1] << 8) | (d->head[2] << 16) | ((uint32_t)d->head[3] << 24);
+      d->raw = !(v & ROTOR_BZ_FRAME_BZIP2);
+      d->left = v & ~ROTOR_BZ_FRAME_BZIP2;
+      if ((d->left == 0) || (d->left > ROTOR_BZ_STRIDE - ROTOR_BZ_FRAME))
+	return ROTOR_ERR_COMPRESS;
+      continue;
+    }
+    n = (len < d->left) ? len : d->left;
+    if (d->raw) {
+      if (rotor_stats_fwrite(plain, n, output) != n)
+	return ROTOR_ERR_PARAM;
+    } else if ((rc = rotor_bz_drain(&d->bz, plain, n, zbuf, &d->done, output))) {
+      return rc;
+    }
+    plain += n;
+    len -= n;
+    d->left -= n;
+    if ((d->left == 0) && (!d->raw) && (!d->done)) // stream must end with its frame
+      return ROTOR_ERR_COMPRESS;
+  }
+  return ROTOR_SUCCESS;
+}
+
+int rotor_decompress_stream(rotor_ctx *ctx, FILE *input, uint64_t in_len, FILE *output, const char *fn) {
+  struct rotor_bz_dec d;
+  uint8_t *inbuf, *zbuf, *outbuf;
+  size_t nt, out_size, out_len;
+  uint64_t off = 0;
+  int rc = ROTOR_SUCCESS;
+
+  rotor_bz_buffers(ctx, &inbuf, &zbuf, &outbuf, &out_size, fn);
+  memset(&d, 0, sizeof(d));
+  rotor_bz_init(&d.bz);
+  if (BZ2_bzDecompressInit(&d.bz, 0, 0) != BZ_OK) {
+    printf("%s: out of memory\n", fn);
+    exit(1);
+  }
+  // framed (segments may be raw) unless the file predates them, then it's
+  // bare bzip2 streams back to back
+  d.framed = (rotor_ctx_flags(ctx) & ROTOR_FLAG_FRAMES) ? 1 : 0;
+  d.done = d.framed;
+  while ((nt = rotor_stats_fread(inbuf, (in_len < ROTOR_BZ_CHUNK) ? in_len : ROTOR_BZ_CHUNK, input))) {
+    in_len -= (in_len == ROTOR_LEN_STREAM) ? 0 : nt;
+    ROTOR_PROBE2(chunk_start, off, nt);
+    rc = rotor_ctx_update(ctx, inbuf, nt, outbuf, &out_len);
+    ROTOR_PROBE3(chunk_done, off, nt, out_len);
+    off += nt;
+    if (rc)
+      break;
+    if ((rc = (d.framed) ? rotor_bz_frames(&d, outbuf, out_len, zbuf, output) :
+	 rotor_bz_drain(&d.bz, outbuf, out_len, zbuf, &d.done, output)))
+      break;
+  }
+  if ((rc == ROTOR_SUCCESS) && (ferror(input))) { // fread stopped short of the end, not final's call
+    printf("%s: read error\n", fn);
+    rotor_ctx_final(ctx, outbuf, &out_len);
+    rc = ROTOR_ERR_LENGTH;
+  } else {
+    if ((rc == ROTOR_SUCCESS) && ((rc = rotor_ctx_final(ctx, outbuf, &out_len)) == ROTOR_SUCCESS))
+      rc = (d.framed) ? rotor_bz_frames(&d, outbuf, out_len, zbuf, output) :
+	rotor_bz_drain(&d.bz, outbuf, out_len, zbuf, &d.done, output);
+    if ((rc == ROTOR_SUCCESS) && ((!d.done) || (d.left) || (d.head_len)))
+      rc = ROTOR_ERR_COMPRESS; // cut short
+    if ((rc) && (output) && (ferror(output)))
+      printf("%s: write error\n", fn);
+    else if (rc)
+      printf("%s: %s\n", fn, rotor_ctx_strerror(rc));
+  }
+  BZ2_bzDecompressEnd(&d.bz);
+  rotor_bz_release(inbuf, zbuf, outbuf, out_size);
+  return rc;
+}
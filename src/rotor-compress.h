@@ -0,0 +1,108 @@
+/*
+ *rotor
+ *Copyright (c) 2016, adouble42/mrn@sdf
+ *All rights reserved.
+ *
+ *Redistribution and use in source and binary forms, with or without
+ *modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ *THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __ROTOR_COMPRESS_H
+#define __ROTOR_COMPRESS_H
+
+// --compress: plaintext goes through bzip2 before the cipher, the header
+// gets ROTOR_COMPRESS_FLAGS. the compressed length isn't known up front, so
+// these files are always in the streamed format
+
+#define ROTOR_COMPRESS_FLAGS (ROTOR_FLAG_BZIP2 | ROTOR_FLAG_FRAMES)
+
+#define ROTOR_BZ_LEVEL 9        // 900k blocks
+#define ROTOR_BZ_CHUNK 65536    // bytes per read, decompressing
+
+// compressing, the input is cut into ROTOR_BZ_BLOCK segments that are
+// compressed in parallel, one bzip2 stream each. every segment goes out in
+// a frame: 4 byte little endian length, top bit set if the payload is a
+// bzip2 stream, clear if it's the plaintext as is. segments that look
+// compressed already (order 0 entropy of a sample at or over
+// ROTOR_BZ_SKIP_BITS) are never run through bzip2, ones that don't shrink
+// by at least 1/ROTOR_BZ_MIN_GAIN are stored raw after the trial
+
+#define ROTOR_BZ_BLOCK 900000
+#define ROTOR_BZ_FRAME 4
+#define ROTOR_BZ_FRAME_BZIP2 0x80000000U
+#define ROTOR_BZ_STRIDE (ROTOR_BZ_FRAME + ROTOR_BZ_BLOCK + ROTOR_BZ_BLOCK / 100 + 600)  // worst case frame
+#define ROTOR_BZ_MAX_BLOCKS 256                                         // per rotor_compress_blocks
+#define ROTOR_BZ_SAMPLES 16         // spans sampled per segment
+#define ROTOR_BZ_SAMPLE_LEN 4096
+#define ROTOR_BZ_SKIP_BITS 7.9      // bits per byte
+#define ROTOR_BZ_MIN_GAIN 32        // ~3%
+
+struct rotor_compress_stats {
+  uint64_t in_bytes;
+  uint64_t out_bytes;      // frames included
+  uint64_t bz_bytes;       // plaintext of segments stored compressed
+  uint64_t skip_bytes;     // stored raw on entropy, bzip2 never ran
+  uint64_t trial_bytes;    // stored raw after bzip2 didn't help
+  uint32_t bz_segs;
+  uint32_t skip_segs;
+  uint32_t trial_segs;
+  double bz_cpu;           // thread CPU seconds in bzip2, trials included
+};
+
+/*
+ * rotor_compress_bound: room rotor_compress_blocks needs for len bytes
+ */
+
+size_t rotor_compress_bound(size_t len);
+
+/*
+ * rotor_compress_blocks: frame len bytes (at most ROTOR_BZ_MAX_BLOCKS
+ * segments) on up to threads threads, frames packed into out. stats, if
+ * not NULL, is added to. nonzero on error
+ */
+
+int rotor_compress_blocks(const uint8_t *in, size_t len, uint8_t *out, size_t *out_len, int threads,
+			  struct rotor_compress_stats *stats);
+
+/*
+ * rotor_compress_saved: CPU seconds the entropy skip saved, estimated from
+ * what bzip2 cost per byte on the rest. negative if nothing was compressed
+ */
+
+double rotor_compress_saved(const struct rotor_compress_stats *stats);
+
+/*
+ * rotor_compress_stream: bzip2 input into ctx, already set up with
+ * rotor_ctx_encrypt_init, ciphertext to output. one thread per core, one
+ * inside a parallel region. nonzero on error
+ */
+
+int rotor_compress_stream(rotor_ctx *ctx, FILE *input, FILE *output, const char *fn);
+
+/*
+ * rotor_decompress_stream: the other way, for a ctx whose header has
+ * ROTOR_FLAG_BZIP2. files without ROTOR_FLAG_FRAMES are bare bzip2 streams.
+ * reads in_len bytes of input, ROTOR_LEN_STREAM for all of it
+ */
+
+int rotor_decompress_stream(rotor_ctx *ctx, FILE *input, uint64_t in_len, FILE *output, const char *fn);
+
+#endif
@@ -12,252 +12,342 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <string.h>
-#include <math.h>
 #include <termios.h>
+#include <limits.h>
 #include "ntru.h"
 #include "shake.h"
 #include "salsa20.h"
+#include "yescrypt.h"
 #include "rotor.h"
 #include "rotor-crypt.h"
 #include "rotor-keys.h"
+#include "rotor-ctx.h"
+#include "rotor-compress.h"
+#include "rotor-stats.h"
+#include "rotor-probe.h"
 #include "progressbar.h"
 
 #ifdef __ROTOR_MLOCK
 #include <sys/mman.h>
 #endif
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// file I/O goes through librotor in chunks of this many NTRU blocks
+
+#define ROTOR_IO_BLOCKS 64
+
 /*
- * rotor-crypt.c - encryption and decryption functions
- * 
- * rotor-decrypt-file: decrypt a file given KeyPair kr, src, dst
+ * rotor_crypt_stream: push in_len bytes of input (ROTOR_LEN_STREAM for all
+ * of it) through ctx into output, nonzero on error. output is NULL for
+ * rotor_ctx_verify_init, which writes nothing
  *
  */
 
-void rotor_decrypt_file(NtruEncKeyPair kr, char *sfname, char *ofname, char *keyfname) {
-  NtruRandGen rng_sk = NTRU_RNG_DEFAULT;
-  NtruRandContext rand_sk_ctx;
-  uint8_t decp[NTRU_ENCLEN];
-  uint8_t dec[NTRU_ENCLEN];
-  uint8_t salsa_seed[170];
-  uint8_t salsa_key[32];
-  uint8_t salsa_nonce[8];
-  uint8_t shake_key[170];
-  uint8_t stream_block[170];
-  uint8_t stream_in[170];
-  uint8_t stream_final[170];
-  uint8_t c;
-  struct fileHeader myInfo;
-  const void *decptr = (void *) decp;
-  int offset, xx,  blocks, remainder;
-  uint16_t dec_len;
-  FILE *input, *output;
+static int rotor_crypt_stream(rotor_ctx *ctx, FILE *input, uint64_t in_len, FILE *output, const char *fn) {
+  uint8_t *inbuf, *outbuf;
+  size_t in_size, nt, out_len;
+  uint64_t off = 0;
+  int rc = ROTOR_SUCCESS, werr = 0;
 
+  in_size = ROTOR_IO_BLOCKS * NTRU_ENCLEN;
+  inbuf = (uint8_t *)malloc(in_size);
+  outbuf = (uint8_t *)malloc(rotor_ctx_out_max(ctx, in_size) + ROTOR_FINAL_MAX);
+  if ((!inbuf) || (!outbuf)) {
+    printf("%s: out of memory\n", fn);
+    exit(1);
+  }
 #ifdef __ROTOR_MLOCK
-  mlock(&kr, sizeof(NtruEncKeyPair));
-  mlock(&rng_sk, sizeof(NtruRandGen));
-  mlock(&rand_sk_ctx, sizeof(NtruRandContext));
-  mlock(&decp, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&dec, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&shake_key, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&stream_block, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&stream_in, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&stream_final, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&myInfo, sizeof(struct fileHeader));
+  mlock(outbuf, rotor_ctx_out_max(ctx, in_size) + ROTOR_FINAL_MAX);
 #endif
-
-  if (ntru_rand_init(&rand_sk_ctx, &rng_sk) != NTRU_SUCCESS)
-      printf("rotor_decrypt_file: rng_sk fail\n");
-  input = fopen(keyfname, "rb");
-  output = fopen(ofname, "wb");
-  fread(&myInfo,sizeof(struct fileHeader),1,input);
-  fread((void *)decptr,sizeof(char),1495,input);
-  ntru_decrypt((void *)decptr, &kr, &EES1087EP2,(uint8_t *)shake_key, (uint16_t *) &dec_len);
-  fread((void *)decptr,sizeof(char),1495,input);
-  fclose(input);
-  input = fopen(sfname, "rb");
-
-  ntru_decrypt((void *)decptr, &kr, &EES1087EP2,(uint8_t *)salsa_seed, (uint16_t *) &dec_len);
-  printf("decrypting: source -  %s | target - %s\n",sfname, ofname);
-  FIPS202_SHAKE256(shake_key, 170, (unsigned char *) &stream_block, 170);
-  FIPS202_SHAKE256(shake_key, 170, (uint8_t *) salsa_nonce, 8);
-  FIPS202_SHAKE256(salsa_seed, 170, (uint8_t *) salsa_key, 32);
-  blocks = myInfo.fileSize;
-  remainder = (int) shake_key[1];
-  int blockCount = 0;
-  while ((fread((void *)decptr,sizeof(char),1495, input)) == 1495) {
-    blockCount++;
-    for(xx=0;xx<NTRU_ENCLEN;xx++) {
-      c = decp[xx];
-      s20_crypt(salsa_key, S20_KEYLEN_256, salsa_nonce, xx, &c, 1);
-      decp[xx] = c;
+  while ((nt = rotor_stats_fread(inbuf, (in_len < in_size) ? in_len : in_size, input))) {
+    in_len -= (in_len == ROTOR_LEN_STREAM) ? 0 : nt;
+    ROTOR_PROBE2(chunk_start, off, nt);
+    rc = rotor_ctx_update(ctx, inbuf, nt, outbuf, &out_len);
+    ROTOR_PROBE3(chunk_done, off, nt, out_len);
+    off += nt;
+    if (rc)
+      break;
+    if ((output) && (rotor_stats_fwrite(outbuf, out_len, output) != out_len)) {
+      werr = 1; // disk full or worse, no use going on
+      break;
     }
-    ntru_decrypt((uint8_t *)decptr, &kr, &EES1087EP2, (uint8_t *) &dec, &dec_len);
-    strncpy((void *)decp, dec, 165);
-    FIPS202_SHAKE256(decp, NTRU_ENCLEN, (uint8_t *) salsa_key, 32);
-    if ((myInfo.fileSize + 1) == blockCount)
-      dec_len = remainder;
-    for (xx=0;xx<dec_len;xx++)
-      stream_final[xx] = dec[xx] ^ stream_block[xx];	
-    FIPS202_SHAKE256(stream_final, dec_len, (unsigned char *) &stream_block, dec_len);
-    fwrite((uint8_t *)stream_final, sizeof(char) * dec_len,1,output);
-  }
-  ntru_rand_release(&rand_sk_ctx);
-  burn(&kr, sizeof(NtruEncKeyPair));
-  burn(&rng_sk, sizeof(NtruRandGen));
-  burn(&rand_sk_ctx, sizeof(NtruRandContext));
-  burn(&decp, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  burn(&dec, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  burn(&shake_key, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  burn(&stream_block, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  burn(&stream_in, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  burn(&stream_final, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  burn(&myInfo, sizeof(struct fileHeader));
+  }
+  if (werr) {
+    printf("%s: write error\n", fn);
+    rotor_ctx_final(ctx, outbuf, &out_len);
+    rc = ROTOR_ERR_PARAM;
+  } else if ((rc == ROTOR_SUCCESS) && (ferror(input))) { // fread stopped short of the end, not final's call
+    printf("%s: read error\n", fn);
+    rotor_ctx_final(ctx, outbuf, &out_len);
+    rc = ROTOR_ERR_LENGTH;
+  } else {
+    if (rc == ROTOR_SUCCESS)
+      rc = rotor_ctx_final(ctx, outbuf, &out_len);
+    if (rc) {
+      printf("%s: %s\n", fn, rotor_ctx_strerror(rc));
+    } else if ((output) && (rotor_stats_fwrite(outbuf, out_len, output) != out_len)) {
+      printf("%s: write error\n", fn);
+      rc = ROTOR_ERR_PARAM;
+    }
+  }
+  burn(outbuf, rotor_ctx_out_max(ctx, in_size) + ROTOR_FINAL_MAX);
 #ifdef __ROTOR_MLOCK
-  munlock(&kr, sizeof(NtruEncKeyPair));
-  munlock(&rng_sk, sizeof(NtruRandGen));
-  munlock(&rand_sk_ctx, sizeof(NtruRandContext));
-  munlock(&decp, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  munlock(&dec, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  munlock(&shake_key, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  munlock(&stream_block, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  munlock(&stream_in, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  munlock(&stream_final, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  munlock(&myInfo, sizeof(struct fileHeader));
+  munlock(outbuf, rotor_ctx_out_max(ctx, in_size) + ROTOR_FINAL_MAX);
 #endif
+  free(inbuf);
+  free(outbuf);
+  return rc;
+}
 
-  fclose(input);
-  fclose(output);
+/*
+ * rotor_load_header: the raw header from the keyfile (--ext) or start of
+ * the file into head, ROTOR_HEADER_LEN bytes
+ *
+ */
+
+static int rotor_load_header(FILE *input, uint8_t *head, const char *fn) {
+  size_t hlen = ROTOR_HEADER_LEN + 1;
+
+  if (rotor_stats_fread(head, ROTOR_HEADER_PROBE, input) == ROTOR_HEADER_PROBE)
+    hlen = rotor_ctx_header_len(head);
+  if ((hlen > ROTOR_HEADER_LEN) ||
+      (rotor_stats_fread(head + ROTOR_HEADER_PROBE, hlen - ROTOR_HEADER_PROBE, input) != hlen - ROTOR_HEADER_PROBE)) {
+    printf("%s: %s\n", fn, rotor_ctx_strerror(ROTOR_ERR_FORMAT));
+    return ROTOR_ERR_FORMAT;
+  }
+  return ROTOR_SUCCESS;
 }
 
-/* 
- * rotor_encrypt_file: encrypt a file given KeyPair kr, src, dst
+/*
+ * rotor_read_header: header from the keyfile (--ext) or start of the file,
+ * set up to decrypt
  *
  */
 
-void rotor_encrypt_file(NtruEncKeyPair kr, char *sfname, char *ofname, char *keyfname){
-    NtruRandGen rng_sk = NTRU_RNG_DEFAULT;
-    NtruRandContext rand_sk_ctx;
-    uint8_t shake_key[170];
-    uint8_t salsa_seed[170];
-    uint8_t salsa_key[32];
-    uint8_t salsa_nonce[8];
-    uint8_t stream_block[170];
-    uint8_t stream_in[170];
-    uint8_t stream_final[170];
-    uint8_t enc[NTRU_ENCLEN];
-    uint8_t enc_b[NTRU_ENCLEN];
-    uint8_t c;
-    uint8_t fbuf[171];
-    const void *fptr = (void *) fbuf;
-    struct fileHeader myInfo;
-    int nt;
-    int remainder, xx;
-    float blocks;    
-    struct stat in_info;
-    FILE *input, *output;
+static int rotor_read_header(rotor_ctx *ctx, FILE *input, const char *fn) {
+  uint8_t head[ROTOR_HEADER_LEN];
+  double t0;
+  int rc;
 
-#ifdef __ROTOR_MLOCK
-  mlock(&kr, sizeof(NtruEncKeyPair));
-  // mlock(&rng_sk, sizeof(NtruRandGen));
-  //mlock(&rand_sk_ctx, sizeof(NtruRandContext));
-  mlock(&enc, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&fbuf, (sizeof(char)*171));
-  mlock(&shake_key, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&stream_block, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&stream_in, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&stream_final, (sizeof(uint8_t)*NTRU_PRIVLEN));
-#endif
-    
-    stat(sfname, &in_info);
-    input = fopen(sfname, "rb");
-    output = fopen(keyfname, "wb");
-    myInfo.fileSize=in_info.st_size;
-    lseek((int)input,0, SEEK_SET);
-    blocks = floor((myInfo.fileSize / 170));
-    remainder = (myInfo.fileSize - (170 * blocks));
-    myInfo.fileSize=blocks;
-    fwrite(&myInfo, sizeof(struct fileHeader), 1, output);
-    if (ntru_rand_init(&rand_sk_ctx, &rng_sk) != NTRU_SUCCESS)
-        printf("rng_sk fail\n");
-    if (ntru_rand_generate(shake_key, 170, &rand_sk_ctx) != NTRU_SUCCESS) {
-      exit(NTRU_ERR_PRNG);
-    } else {
-      printf("generated 170 byte random key for SHAKE-256 inner stream\n");
-    }
-    if (ntru_rand_generate(salsa_seed, 170, &rand_sk_ctx) != NTRU_SUCCESS) {
-      exit(NTRU_ERR_PRNG);
-    } else {
-      printf("generated 170 byte random seed for Salsa20 outer stream\n");
-    }
-    shake_key[1] = (uint8_t) remainder; // encode actual size of final block
-    printf("encrypting: source -  %s | target - %s\n",sfname, ofname);
-    if (ntru_encrypt(shake_key, 170, &kr.pub, &EES1087EP2, &rand_sk_ctx, enc) == NTRU_SUCCESS)
-	fwrite(enc, sizeof(enc),1, output);
-    FIPS202_SHAKE256(shake_key, 170, (uint8_t *) stream_block, 170);
-    if (ntru_encrypt(salsa_seed, 170, &kr.pub, &EES1087EP2, &rand_sk_ctx, enc) == NTRU_SUCCESS)
-	fwrite(enc, sizeof(enc),1, output);
-    fclose(output);
-    output=fopen(ofname, "wb");
-    FIPS202_SHAKE256(shake_key, 170, (uint8_t *) salsa_nonce, 8);
-    FIPS202_SHAKE256(salsa_seed, 170, (uint8_t *) salsa_key, 32);    
-    while ((nt=fread((void *)fptr,sizeof(char), 170, input))) {
-      for (xx=0;xx<nt;xx++) {
-	stream_final[xx] = fbuf[xx] ^ stream_block[xx];
-      }
-      FIPS202_SHAKE256(fptr, nt, (uint8_t *) stream_block, 170);
-      if (ntru_encrypt(stream_final, 170, &kr.pub, &EES1087EP2, &rand_sk_ctx, enc) == NTRU_SUCCESS) {
-	for(xx=0;xx<NTRU_ENCLEN;xx++) {
-	  c = enc[xx];
-	  s20_crypt(salsa_key, S20_KEYLEN_256, salsa_nonce, xx, &c, 1);
-	  enc_b[xx] = c;
-	}
-		fwrite(enc_b, sizeof(enc),1,output);
-		strncpy(enc, stream_final, 165);
-		FIPS202_SHAKE256(enc, NTRU_ENCLEN, (uint8_t *) salsa_key, 32);    
-      }
-    }
+  if ((rc = rotor_load_header(input, head, fn)))
+    return rc;
+  t0 = rotor_stats_now();
+  rc = rotor_ctx_decrypt_init(ctx, head);
+  rotor_stats_time(ROTOR_STAT_HEADER, t0);
+  rotor_stats_count(ROTOR_COUNT_NTRU, 2);
+  rotor_stats_count(ROTOR_COUNT_FILES, 1);
+  if (rc)
+    printf("%s: %s\n", fn, rotor_ctx_strerror(rc));
+  return rc;
+}
 
-    rewind(input);
-    fseek(input, (0-nt), SEEK_END);
-    memset((void *)fptr,0,sizeof(fptr));
-    fread((void *)fptr,sizeof(char), nt, input);
-    fbuf[nt] = '\0';
-    for (xx=0;xx<nt;xx++) {
-      stream_final[xx] = fbuf[xx] ^ stream_block[xx];
-    }
-    ntru_encrypt(stream_final, nt, &kr.pub, &EES1087EP2, &rand_sk_ctx, enc);
-    for(xx=0;xx<NTRU_ENCLEN;xx++) {
-      c = enc[xx];
-      s20_crypt(salsa_key, S20_KEYLEN_256, salsa_nonce, xx, &c, 1);
-      enc[xx] = c;
+/*
+ * rotor_write_header: new header for a file of sfname's size, streamed
+ * format if sfname is NULL. quiet skips the key generation chatter
+ *
+ */
+
+static int rotor_write_header(rotor_ctx *ctx, char *sfname, FILE *output, int quiet, const char *fn) {
+  uint8_t head[ROTOR_HEADER_LEN];
+  struct stat in_info;
+  uint64_t total_len = ROTOR_LEN_STREAM;
+  double t0;
+  int rc;
+
+  if (sfname) {
+    if (stat(sfname, &in_info)) {
+      perror(fn);
+      return ROTOR_ERR_PARAM;
     }
+    total_len = in_info.st_size;
+  }
+  t0 = rotor_stats_now();
+  rc = rotor_ctx_encrypt_init(ctx, total_len, head);
+  rotor_stats_time(ROTOR_STAT_HEADER, t0);
+  rotor_stats_count(ROTOR_COUNT_NTRU, 2);
+  rotor_stats_count(ROTOR_COUNT_FILES, 1);
+  if (rc) {
+    printf("%s: %s\n", fn, rotor_ctx_strerror(rc));
+    return rc;
+  }
+  if (!quiet) {
+    printf("generated 170 byte random key for SHAKE-256 inner stream\n");
+    printf("generated 170 byte random seed for Salsa20 outer stream\n");
+  }
+  if (rotor_stats_fwrite(head, ROTOR_HEADER_LEN, output) != ROTOR_HEADER_LEN) {
+    printf("%s: write error\n", fn);
+    return ROTOR_ERR_PARAM;
+  }
+  return rc;
+}
 
-    fwrite(enc, sizeof(enc),1,output);   
-    
-    ntru_rand_release(&rand_sk_ctx);
-
-    burn(&kr, sizeof(NtruEncKeyPair));
-    burn(&rng_sk, sizeof(NtruRandGen));
-    burn(&rand_sk_ctx, sizeof(NtruRandContext));
-    burn(&enc, (sizeof(uint8_t)*NTRU_PRIVLEN));
-    burn(&fbuf, (sizeof(char)*171));
-    burn(&stream_block, (sizeof(uint8_t)*NTRU_PRIVLEN));
-    burn(&stream_in, (sizeof(uint8_t)*NTRU_PRIVLEN));
-    burn(&stream_final, (sizeof(uint8_t)*NTRU_PRIVLEN));
-#ifdef __ROTOR_MLOCK
-    munlock(&kr, sizeof(NtruEncKeyPair));
-    munlock(&rng_sk, sizeof(NtruRandGen));
-    munlock(&rand_sk_ctx, sizeof(NtruRandContext));
-    munlock(&enc, (sizeof(uint8_t)*NTRU_PRIVLEN));
-    munlock(&fbuf, (sizeof(char)*171));
-    munlock(&shake_key, (sizeof(uint8_t)*NTRU_PRIVLEN));
-    munlock(&stream_block, (sizeof(uint8_t)*NTRU_PRIVLEN));
-    munlock(&stream_in, (sizeof(uint8_t)*NTRU_PRIVLEN));
-    munlock(&stream_final, (sizeof(uint8_t)*NTRU_PRIVLEN));
-#endif
+static rotor_ctx *rotor_open_ctx(NtruEncKeyPair *kr, int mode, const char *fn) {
+  rotor_ctx *ctx = rotor_ctx_new(kr, mode);
 
-    fclose(input);
-    fclose(output);
+  if (ctx == NULL) {
+    printf("%s: out of memory\n", fn);
+    exit(1);
+  }
+  return ctx;
+}
+
+static FILE *rotor_open(char *fname, char *fmode, const char *fn) {
+  FILE *f = fopen(fname, fmode);
+
+  if (f == NULL) {
+    printf("%s: can't open %s\n", fn, fname);
+    exit(1);
+  }
+  return f;
+}
+
+/*
+ * rotor_close: close a file we wrote, the last of it only gets to disk
+ * here. on failure it's unlinked and nonzero returned
+ *
+ */
+
+static int rotor_close(FILE *f, char *fname, const char *fn) {
+  if (fclose(f) == 0)
+    return ROTOR_SUCCESS;
+  printf("%s: write to %s failed\n", fn, fname);
+  unlink(fname);
+  return ROTOR_ERR_PARAM;
+}
+
+/*
+ * rotor_pread: all of len at off, or nonzero
+ *
+ */
+
+static int rotor_pread(int fd, uint8_t *buf, size_t len, uint64_t off) {
+  double t0 = rotor_stats_now();
+  ssize_t n;
+
+  rotor_stats_count(ROTOR_COUNT_READ, len);
+  while (len > 0) {
+    n = pread(fd, buf, len, off);
+    if (n <= 0)
+      return 1;
+    buf += n;
+    len -= n;
+    off += n;
+  }
+  rotor_stats_time(ROTOR_STAT_READ, t0);
+  return 0;
+}
+
+/*
+ * rotor_find_index: for a file with ROTOR_FLAG_INDEX, the index at the end
+ * of input, whose body starts at body_off. *index is malloc()ed. the file
+ * has to be seekable, a pipe can't be read from the end
+ *
+ */
+
+static int rotor_find_index(rotor_ctx *ctx, FILE *input, uint64_t body_off, uint8_t **index, size_t *index_len,
+			    uint64_t *body_len, const char *fn) {
+  uint8_t foot[ROTOR_IDX_FOOT];
+  struct stat st;
+  int fd = fileno(input);
+
+  *index = NULL;
+  if ((fstat(fd, &st) != 0) || (!S_ISREG(st.st_mode))) {
+    printf("%s: indexed file, needs to be read from a file, not a pipe\n", fn);
+    return ROTOR_ERR_PARAM;
+  }
+  if (((uint64_t)st.st_size < body_off + ROTOR_IDX_FOOT) ||
+      (rotor_pread(fd, foot, ROTOR_IDX_FOOT, st.st_size - ROTOR_IDX_FOOT)) ||
+      ((*index_len = rotor_ctx_index_len(ctx, foot, body_len)) == 0) ||
+      ((uint64_t)st.st_size - body_off != *body_len + *index_len)) {
+    printf("%s: index %s\n", fn, rotor_ctx_strerror(ROTOR_ERR_LENGTH));
+    return ROTOR_ERR_LENGTH;
+  }
+  if ((*index = (uint8_t *)malloc(*index_len)) == NULL) {
+    printf("%s: out of memory\n", fn);
+    exit(1);
+  }
+  if (rotor_pread(fd, *index, *index_len, st.st_size - *index_len)) {
+    printf("%s: read error\n", fn);
+    return ROTOR_ERR_LENGTH;
+  }
+  return ROTOR_SUCCESS;
+}
+
+/*
+ * rotor_write_index: the index behind the rest of the file, if ctx made one
+ *
+ */
+
+static int rotor_write_index(rotor_ctx *ctx, FILE *output, const char *fn) {
+  const uint8_t *index;
+  size_t len;
+
+  if ((index = rotor_ctx_index(ctx, &len)) && (rotor_stats_fwrite(index, len, output) != len)) {
+    printf("%s: write error\n", fn);
+    return ROTOR_ERR_PARAM;
+  }
+  return ROTOR_SUCCESS;
+}
+
+/*
+ * rotor_encrypt_body, rotor_decrypt_body: the file body, through bzip2 if
+ * the header says so. the index isn't part of what decrypt reads
+ *
+ */
+
+static int rotor_encrypt_body(rotor_ctx *ctx, FILE *input, FILE *output, const char *fn) {
+  int rc;
+
+  if (rotor_ctx_flags(ctx) & ROTOR_FLAG_BZIP2)
+    rc = rotor_compress_stream(ctx, input, output, fn);
+  else
+    rc = rotor_crypt_stream(ctx, input, ROTOR_LEN_STREAM, output, fn);
+  return (rc) ? rc : rotor_write_index(ctx, output, fn);
+}
+
+/*
+ * rotor_check_body: a file, as opposed to a pipe, has to be as long as its
+ * header says, in_len if the index already told us. caught here it costs a
+ * stat() instead of decrypting a truncated or padded file to the end
+ *
+ */
+
+static int rotor_check_body(rotor_ctx *ctx, FILE *input, uint64_t in_len, const char *fn) {
+  struct stat st;
+  off_t off;
+
+  if (rotor_ctx_body_len(ctx) == ROTOR_LEN_STREAM)
+    return ROTOR_SUCCESS;
+  if ((in_len == ROTOR_LEN_STREAM) && (fstat(fileno(input), &st) == 0) && (S_ISREG(st.st_mode)) &&
+      ((off = ftello(input)) >= 0) && (off <= st.st_size))
+    in_len = st.st_size - off;
+  if ((in_len != ROTOR_LEN_STREAM) && (in_len != rotor_ctx_body_len(ctx))) {
+    printf("%s: %s\n", fn, rotor_ctx_strerror(ROTOR_ERR_LENGTH));
+    return ROTOR_ERR_LENGTH;
+  }
+  return ROTOR_SUCCESS;
+}
+
+static int rotor_decrypt_body(rotor_ctx *ctx, FILE *input, FILE *output, const char *fn) {
+  uint64_t in_len = ROTOR_LEN_STREAM;
+  uint8_t *index;
+  size_t index_len;
+  int rc;
+
+  if (rotor_ctx_flags(ctx) & ROTOR_FLAG_INDEX) {
+    rc = rotor_find_index(ctx, input, ftello(input), &index, &index_len, &in_len, fn);
+    free(index);
+    if (rc)
+      return rc;
+  }
+  if ((rc = rotor_check_body(ctx, input, in_len, fn)))
+    return rc;
+  if (rotor_ctx_flags(ctx) & ROTOR_FLAG_BZIP2)
+    return rotor_decompress_stream(ctx, input, in_len, output, fn);
+  return rotor_crypt_stream(ctx, input, in_len, output, fn);
 }
 
 /*
@@ -267,95 +357,89 @@ void rotor_encrypt_file(NtruEncKeyPair kr, char *sfname, char *ofname, char *key
  *
  */
 
-void rotor_decrypt_file_sym(NtruEncKeyPair kr, char *sfname, char *ofname) {
-  NtruRandGen rng_sk = NTRU_RNG_DEFAULT;
-  NtruRandContext rand_sk_ctx;
-  uint8_t decp[NTRU_ENCLEN];
-  uint8_t dec[NTRU_ENCLEN];
-  uint8_t salsa_seed[170];
-  uint8_t salsa_key[32];
-  uint8_t salsa_nonce[8];
-  uint8_t shake_key[170];
-  uint8_t stream_block[170];
-  uint8_t stream_in[170];
-  uint8_t stream_final[170];
-  uint8_t c;
-  struct fileHeader myInfo;
-  const void *decptr = (void *) decp;
-  int offset, xx,  blocks, remainder;
-  uint16_t dec_len;
+void rotor_decrypt_file(NtruEncKeyPair *kr, char *sfname, char *ofname, char *keyfname) {
+  rotor_ctx *ctx;
   FILE *input, *output;
 
-#ifdef __ROTOR_MLOCK
-  mlock(&kr, sizeof(NtruEncKeyPair));
-  mlock(&rng_sk, sizeof(NtruRandGen));
-  mlock(&rand_sk_ctx, sizeof(NtruRandContext));
-  mlock(&decp, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&dec, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&shake_key, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&stream_block, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&stream_in, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&stream_final, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&myInfo, sizeof(struct fileHeader));
-#endif
-
-  if (ntru_rand_init(&rand_sk_ctx, &rng_sk) != NTRU_SUCCESS)
-      printf("rotor_decrypt_file_sym: rng_sk fail\n");
-  input = fopen(sfname, "rb");
-  output = fopen(ofname, "wb");
-  fread(&myInfo,sizeof(struct fileHeader),1,input);
-  fread((void *)decptr,sizeof(char),1495,input);
-  ntru_decrypt((void *)decptr, &kr, &EES1087EP2,(uint8_t *)shake_key, (uint16_t *) &dec_len);
-  fread((void *)decptr,sizeof(char),1495,input);
-  ntru_decrypt((void *)decptr, &kr, &EES1087EP2,(uint8_t *)salsa_seed, (uint16_t *) &dec_len);
+  ctx = rotor_open_ctx(kr, ROTOR_MODE_EXT, "rotor_decrypt_file");
+  input = rotor_open(keyfname, "rb", "rotor_decrypt_file");
+  if (rotor_read_header(ctx, input, "rotor_decrypt_file"))
+    exit(1);
+  fclose(input);
+  input = rotor_open(sfname, "rb", "rotor_decrypt_file");
+  output = rotor_open(ofname, "wb", "rotor_decrypt_file");
   printf("decrypting: source -  %s | target - %s\n",sfname, ofname);
-  FIPS202_SHAKE256(shake_key, 170, (unsigned char *) &stream_block, 170);
-  FIPS202_SHAKE256(shake_key, 170, (uint8_t *) salsa_nonce, 8);
-  FIPS202_SHAKE256(salsa_seed, 170, (uint8_t *) salsa_key, 32);
-  blocks = myInfo.fileSize;
-  remainder = (int) shake_key[1];
-  int blockCount = 0;
-  while ((fread((void *)decptr,sizeof(char),170, input)) == 170) {
-    blockCount++;
-    for(xx=0;xx<170;xx++) {
-      c = decp[xx];
-      s20_crypt(salsa_key, S20_KEYLEN_256, salsa_nonce, xx, &c, 1);
-      decp[xx] = c;
-    }
-    FIPS202_SHAKE256(decp, 170, (uint8_t *) salsa_key, 32);
-    if ((myInfo.fileSize + 1) == blockCount)
-      dec_len = remainder;
-    for (xx=0;xx<dec_len;xx++)
-      stream_final[xx] = decp[xx] ^ stream_block[xx];	
-    FIPS202_SHAKE256(stream_final, dec_len, (unsigned char *) &stream_block, dec_len);
-    fwrite((uint8_t *)stream_final, sizeof(char) * dec_len,1,output);
-  }
-  ntru_rand_release(&rand_sk_ctx);
-  burn(&kr, sizeof(NtruEncKeyPair));
-  burn(&rng_sk, sizeof(NtruRandGen));
-  burn(&rand_sk_ctx, sizeof(NtruRandContext));
-  burn(&decp, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  burn(&dec, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  burn(&shake_key, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  burn(&stream_block, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  burn(&stream_in, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  burn(&stream_final, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  burn(&myInfo, sizeof(struct fileHeader));
-#ifdef __ROTOR_MLOCK
-  munlock(&kr, sizeof(NtruEncKeyPair));
-  munlock(&rng_sk, sizeof(NtruRandGen));
-  munlock(&rand_sk_ctx, sizeof(NtruRandContext));
-  munlock(&decp, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  munlock(&dec, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  munlock(&shake_key, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  munlock(&stream_block, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  munlock(&stream_in, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  munlock(&stream_final, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  munlock(&myInfo, sizeof(struct fileHeader));
-#endif
+  if (rotor_decrypt_body(ctx, input, output, "rotor_decrypt_file")) {
+    unlink(ofname); // nothing unauthenticated left behind
+    exit(1);
+  }
+  rotor_ctx_free(ctx);
+  fclose(input);
+  if (rotor_close(output, ofname, "rotor_decrypt_file"))
+    exit(1);
+}
 
+/* 
+ * rotor_encrypt_file: encrypt a file given KeyPair kr, src, dst
+ *
+ */
+
+void rotor_encrypt_file(NtruEncKeyPair *kr, char *sfname, char *ofname, char *keyfname, int compress){
+  rotor_ctx *ctx;
+  FILE *input, *output;
+
+  ctx = rotor_open_ctx(kr, ROTOR_MODE_EXT, "rotor_encrypt_file");
+  rotor_ctx_set_flags(ctx, ((compress) ? ROTOR_COMPRESS_FLAGS : 0) | ROTOR_FLAG_MAC | ROTOR_FLAG_INDEX);
+  input = rotor_open(sfname, "rb", "rotor_encrypt_file");
+  output = rotor_open(keyfname, "wb", "rotor_encrypt_file");
+  if (rotor_write_header(ctx, (compress) ? NULL : sfname, output, 0, "rotor_encrypt_file")) {
+    unlink(keyfname);
+    exit(1);
+  }
+  if (rotor_close(output, keyfname, "rotor_encrypt_file"))
+    exit(1);
+  output = rotor_open(ofname, "wb", "rotor_encrypt_file");
+  printf("encrypting: source -  %s | target - %s\n",sfname, ofname);
+  if (rotor_encrypt_body(ctx, input, output, "rotor_encrypt_file")) {
+    unlink(ofname); // a key for half a file is no use either
+    unlink(keyfname);
+    exit(1);
+  }
+  rotor_ctx_free(ctx);
   fclose(input);
-  fclose(output);
+  if (rotor_close(output, ofname, "rotor_encrypt_file")) {
+    unlink(keyfname);
+    exit(1);
+  }
+}
+
+/*
+ * rotor-crypt.c - encryption and decryption functions
+ * 
+ * rotor-decrypt-file: decrypt a file given KeyPair kr, src, dst
+ *
+ */
+
+void rotor_decrypt_file_sym(NtruEncKeyPair *kr, char *sfname, char *ofname) {
+  rotor_ctx *ctx;
+  FILE *input, *output;
+
+  ctx = rotor_open_ctx(kr, ROTOR_MODE_SYM, "rotor_decrypt_file_sym");
+  input = rotor_open(sfname, "rb", "rotor_decrypt_file_sym");
+  output = rotor_open(ofname, "wb", "rotor_decrypt_file_sym");
+  if (rotor_read_header(ctx, input, "rotor_decrypt_file_sym")) {
+    unlink(ofname);
+    exit(1);
+  }
+  printf("decrypting: source -  %s | target - %s\n",sfname, ofname);
+  if (rotor_decrypt_body(ctx, input, output, "rotor_decrypt_file_sym")) {
+    unlink(ofname); // nothing unauthenticated left behind
+    exit(1);
+  }
+  rotor_ctx_free(ctx);
+  fclose(input);
+  if (rotor_close(output, ofname, "rotor_decrypt_file_sym"))
+    exit(1);
 }
 
 /* 
@@ -363,107 +447,253 @@ void rotor_decrypt_file_sym(NtruEncKeyPair kr, char *sfname, char *ofname) {
  *
  */
 
-void rotor_encrypt_file_sym(NtruEncKeyPair kr, char *sfname, char *ofname){
-    NtruRandGen rng_sk = NTRU_RNG_DEFAULT;
-    NtruRandContext rand_sk_ctx;
-    uint8_t shake_key[170];
-    uint8_t salsa_seed[170];
-    uint8_t salsa_key[32];
-    uint8_t salsa_nonce[8];
-    uint8_t stream_block[170];
-    uint8_t stream_in[170];
-    uint8_t stream_final[170];
-    uint8_t enc[NTRU_ENCLEN];
-    uint8_t enc_b[NTRU_ENCLEN];
-    uint8_t c;
-    uint8_t fbuf[171];
-    const void *fptr = (void *) fbuf;
-    struct fileHeader myInfo;
-    int nt;
-    int remainder, xx;
-    float blocks;    
-    struct stat in_info;
-    FILE *input, *output;
+void rotor_encrypt_file_sym(NtruEncKeyPair *kr, char *sfname, char *ofname, int compress){
+  rotor_ctx *ctx;
+  FILE *input, *output;
 
-#ifdef __ROTOR_MLOCK
-  mlock(&kr, sizeof(NtruEncKeyPair));
-  // mlock(&rng_sk, sizeof(NtruRandGen));
-  //mlock(&rand_sk_ctx, sizeof(NtruRandContext));
-  mlock(&enc, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&fbuf, (sizeof(char)*171));
-  mlock(&shake_key, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&stream_block, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&stream_in, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&stream_final, (sizeof(uint8_t)*NTRU_PRIVLEN));
+  ctx = rotor_open_ctx(kr, ROTOR_MODE_SYM, "rotor_encrypt_file_sym");
+  rotor_ctx_set_flags(ctx, ((compress) ? ROTOR_COMPRESS_FLAGS : 0) | ROTOR_FLAG_MAC | ROTOR_FLAG_INDEX);
+  input = rotor_open(sfname, "rb", "rotor_encrypt_file_sym");
+  output = rotor_open(ofname, "wb", "rotor_encrypt_file_sym");
+  if (rotor_write_header(ctx, (compress) ? NULL : sfname, output, 0, "rotor_encrypt_file_sym")) {
+    unlink(ofname);
+    exit(1);
+  }
+  printf("encrypting: source -  %s | target - %s\n",sfname, ofname);
+  if (rotor_encrypt_body(ctx, input, output, "rotor_encrypt_file_sym")) {
+    unlink(ofname);
+    exit(1);
+  }
+  rotor_ctx_free(ctx);
+  fclose(input);
+  if (rotor_close(output, ofname, "rotor_encrypt_file_sym"))
+    exit(1);
+}
+
+/*
+ * rotor_encrypt_stream: streamed format, input and output are the caller's
+ *
+ */
+
+void rotor_encrypt_stream(NtruEncKeyPair *kr, int mode, FILE *input, FILE *output, char *keyfname, int compress) {
+  rotor_ctx *ctx;
+  FILE *keyout;
+
+  ctx = rotor_open_ctx(kr, mode, "rotor_encrypt_stream");
+  rotor_ctx_set_flags(ctx, ((compress) ? ROTOR_COMPRESS_FLAGS : 0) | ROTOR_FLAG_MAC);
+  if (mode == ROTOR_MODE_EXT) {
+    keyout = rotor_open(keyfname, "wb", "rotor_encrypt_stream");
+    if (rotor_write_header(ctx, NULL, keyout, 0, "rotor_encrypt_stream")) {
+      unlink(keyfname);
+      exit(1);
+    }
+    if (rotor_close(keyout, keyfname, "rotor_encrypt_stream"))
+      exit(1);
+  } else {
+    if (rotor_write_header(ctx, NULL, output, 0, "rotor_encrypt_stream"))
+      exit(1);
+  }
+  printf("encrypting stream\n");
+  if (rotor_encrypt_body(ctx, input, output, "rotor_encrypt_stream"))
+    exit(1);
+  rotor_ctx_free(ctx);
+}
+
+/*
+ * rotor_decrypt_stream: counterpart of rotor_encrypt_stream
+ *
+ */
+
+void rotor_decrypt_stream(NtruEncKeyPair *kr, int mode, FILE *input, FILE *output, char *keyfname) {
+  rotor_ctx *ctx;
+  FILE *keyin;
+
+  ctx = rotor_open_ctx(kr, mode, "rotor_decrypt_stream");
+  if (mode == ROTOR_MODE_EXT) {
+    keyin = rotor_open(keyfname, "rb", "rotor_decrypt_stream");
+    if (rotor_read_header(ctx, keyin, "rotor_decrypt_stream"))
+      exit(1);
+    fclose(keyin);
+  } else {
+    if (rotor_read_header(ctx, input, "rotor_decrypt_stream"))
+      exit(1);
+  }
+  printf("decrypting stream\n");
+  if (rotor_decrypt_body(ctx, input, output, "rotor_decrypt_stream"))
+    exit(1);
+  rotor_ctx_free(ctx);
+}
+
+/*
+ * rotor_verify_segments: check every segment of an indexed file against its
+ * tag, one segment per thread at a time. each thread preads its own, so no
+ * thread waits on another's I/O. prints the first bad one
+ *
+ */
+
+static int rotor_verify_segments(rotor_ctx *ctx, const uint8_t *head, FILE *input, const char *fn) {
+  uint64_t body_off = ftello(input);
+  uint64_t count, body_len, seg, bad;
+  uint8_t *index, *bufs;
+  size_t index_len, seg_len;
+  int threads = 1, fd = fileno(input);
+  int rc;
+
+  if (((rc = rotor_find_index(ctx, input, body_off, &index, &index_len, &body_len, fn)) == ROTOR_SUCCESS) &&
+      ((rc = rotor_ctx_index_init(ctx, head, index, index_len))))
+    printf("%s: index %s\n", fn, rotor_ctx_strerror(rc));
+  free(index);
+  if (rc)
+    return rc;
+  rotor_ctx_index_info(ctx, &count, &seg_len, &body_len);
+#ifdef _OPENMP
+  threads = omp_get_max_threads();
+#endif
+  if ((uint64_t)threads > count)
+    threads = (count) ? count : 1;
+  if ((bufs = (uint8_t *)malloc((size_t)threads * seg_len)) == NULL) {
+    printf("%s: out of memory\n", fn);
+    exit(1);
+  }
+  bad = count;
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(threads) schedule(dynamic) reduction(min:bad)
+#endif
+  for (seg=0; seg<count; seg++) {
+    uint8_t *buf = bufs;
+    size_t len = (seg + 1 < count) ? seg_len : body_len - seg * seg_len;
+
+#ifdef _OPENMP
+    buf += (size_t)omp_get_thread_num() * seg_len;
 #endif
-    
-    stat(sfname, &in_info);
-    input = fopen(sfname, "rb");
-    output = fopen(ofname, "wb");
-    myInfo.fileSize=in_info.st_size;
-    lseek((int)input,0, SEEK_SET);
-    blocks = floor((myInfo.fileSize / 170));
-    remainder = (myInfo.fileSize - (170 * blocks));
-    myInfo.fileSize=blocks;
-    fwrite(&myInfo, sizeof(struct fileHeader), 1, output);
-    if (ntru_rand_init(&rand_sk_ctx, &rng_sk) != NTRU_SUCCESS)
-        printf("rng_sk fail\n");
-    if (ntru_rand_generate(shake_key, 170, &rand_sk_ctx) != NTRU_SUCCESS) {
-      exit(NTRU_ERR_PRNG);
-    } else {
-      printf("generated 170 byte random key for SHAKE-256 inner stream\n");
+    if ((seg < bad) && ((rotor_pread(fd, buf, len, body_off + seg * seg_len)) ||
+			(rotor_ctx_verify_segment(ctx, seg, buf, len) != ROTOR_SUCCESS)))
+      bad = seg;
+  }
+  free(bufs);
+  if (bad < count) {
+    printf("%s: %s, first bad segment %llu at offset %llu (%llu bytes)\n", fn, rotor_ctx_strerror(ROTOR_ERR_MAC),
+	   (unsigned long long)bad, (unsigned long long)(body_off + bad * seg_len), (unsigned long long)seg_len);
+    return ROTOR_ERR_MAC;
+  }
+  printf("%s: %llu segment(s) on %i thread(s)\n", fn, (unsigned long long)count, threads);
+  return ROTOR_SUCCESS;
+}
+
+/*
+ * rotor_verify_file: check the MAC of sfname without decrypting it. files
+ * with an index have their segments checked in parallel instead
+ *
+ */
+
+int rotor_verify_file(NtruEncKeyPair *kr, int mode, char *sfname, char *keyfname) {
+  uint8_t head[ROTOR_HEADER_LEN];
+  rotor_ctx *ctx;
+  FILE *input, *keyin;
+  int rc;
+
+  ctx = rotor_open_ctx(kr, mode, "rotor_verify_file");
+  input = rotor_open(sfname, "rb", "rotor_verify_file");
+  if (mode == ROTOR_MODE_EXT) {
+    keyin = rotor_open(keyfname, "rb", "rotor_verify_file");
+    rc = rotor_load_header(keyin, head, sfname);
+    fclose(keyin);
+  } else {
+    rc = rotor_load_header(input, head, sfname);
+  }
+  if ((rc == ROTOR_SUCCESS) && ((rc = rotor_ctx_verify_init(ctx, head)))) {
+    if (rc == ROTOR_ERR_NOMAC)
+      printf("%s: no MAC, made before rotor authenticated its files\n", sfname);
+    else
+      printf("%s: %s\n", sfname, rotor_ctx_strerror(rc));
+  } else if (rc == ROTOR_SUCCESS) {
+    if (rotor_ctx_flags(ctx) & ROTOR_FLAG_INDEX)
+      rc = rotor_verify_segments(ctx, head, input, sfname);
+    else
+      rc = rotor_crypt_stream(ctx, input, ROTOR_LEN_STREAM, NULL, sfname);
+  }
+  if (rc == ROTOR_SUCCESS)
+    printf("%s: authentic\n", sfname);
+  rotor_ctx_free(ctx);
+  fclose(input);
+  return rc;
+}
+
+/*
+ * rotor_crypt_file_batch: one file of a batch. same names as the single
+ * file path, but errors come back instead of exiting so the rest of the
+ * batch carries on. in_len gets the bytes read
+ *
+ */
+
+int rotor_crypt_file_batch(NtruEncKeyPair *kr, int mode, int dec, int compress, char *sfname, uint64_t *in_len) {
+  char ofname[PATH_MAX];
+  char keyfname[PATH_MAX];
+  struct stat in_info;
+  rotor_ctx *ctx;
+  FILE *input = NULL, *output = NULL, *keyf = NULL;
+  size_t sl = strlen(sfname);
+  int rc = ROTOR_ERR_PARAM;
+
+  *in_len = 0;
+  if (dec) {
+    if ((sl <= 4) || (strcmp(sfname + sl - 4, ".enc") != 0) || (sl - 4 >= PATH_MAX)) {
+      printf("%s: not a .enc file\n", sfname);
+      return rc;
     }
-    if (ntru_rand_generate(salsa_seed, 170, &rand_sk_ctx) != NTRU_SUCCESS) {
-      exit(NTRU_ERR_PRNG);
-    } else {
-      printf("generated 170 byte random seed for Salsa20 outer stream\n");
+    snprintf(ofname, sizeof(ofname), "%.*s", (int)(sl - 4), sfname);
+    snprintf(keyfname, sizeof(keyfname), "%s.key", sfname);
+  } else {
+    snprintf(ofname, sizeof(ofname), "%s.enc", sfname);
+    snprintf(keyfname, sizeof(keyfname), "%s.enc.key", sfname);
+  }
+  if (stat(sfname, &in_info) == 0)
+    *in_len = in_info.st_size;
+  ctx = rotor_open_ctx(kr, mode, sfname);
+  rotor_ctx_set_flags(ctx, ((compress) ? ROTOR_COMPRESS_FLAGS : 0) | ROTOR_FLAG_MAC | ROTOR_FLAG_INDEX);
+  if ((input = fopen(sfname, "rb")) == NULL) {
+    printf("%s: can't open\n", sfname);
+    goto done;
+  }
+  if (mode == ROTOR_MODE_EXT) {
+    if ((keyf = fopen(keyfname, dec ? "rb" : "wb")) == NULL) {
+      printf("%s: can't open %s\n", sfname, keyfname);
+      goto done;
     }
-    shake_key[1] = (uint8_t) remainder; // encode actual size of final block
-    printf("encrypting: source -  %s | target - %s\n",sfname, ofname);
-    if (ntru_encrypt(shake_key, 170, &kr.pub, &EES1087EP2, &rand_sk_ctx, enc) == NTRU_SUCCESS)
-	fwrite(enc, sizeof(enc),1, output);
-    FIPS202_SHAKE256(shake_key, 170, (uint8_t *) stream_block, 170);
-    if (ntru_encrypt(salsa_seed, 170, &kr.pub, &EES1087EP2, &rand_sk_ctx, enc) == NTRU_SUCCESS)
-	fwrite(enc, sizeof(enc),1, output);
-    FIPS202_SHAKE256(shake_key, 170, (uint8_t *) salsa_nonce, 8);
-    FIPS202_SHAKE256(salsa_seed, 170, (uint8_t *) salsa_key, 32);    
-    while ((nt=fread((void *)fptr,sizeof(char), 170, input))) {
-      for (xx=0;xx<nt;xx++) {
-	stream_final[xx] = fbuf[xx] ^ stream_block[xx];
-      }
-      FIPS202_SHAKE256(fptr, nt, (uint8_t *) stream_block, 170);
-	for(xx=0;xx<170;xx++) {
-	  c = stream_final[xx];
-	  fbuf[xx] = stream_final[xx];
-	  s20_crypt(salsa_key, S20_KEYLEN_256, salsa_nonce, xx, &c, 1);
-	  stream_final[xx] = c;
-	}
-		fwrite(stream_final, sizeof(stream_final),1,output);
-		FIPS202_SHAKE256(fbuf, 170, (uint8_t *) salsa_key, 32);    
-      }
-
-    ntru_rand_release(&rand_sk_ctx);
-
-    burn(&kr, sizeof(NtruEncKeyPair));
-    burn(&rng_sk, sizeof(NtruRandGen));
-    burn(&rand_sk_ctx, sizeof(NtruRandContext));
-    burn(&enc, (sizeof(uint8_t)*NTRU_PRIVLEN));
-    burn(&fbuf, (sizeof(char)*171));
-    burn(&stream_block, (sizeof(uint8_t)*NTRU_PRIVLEN));
-    burn(&stream_in, (sizeof(uint8_t)*NTRU_PRIVLEN));
-    burn(&stream_final, (sizeof(uint8_t)*NTRU_PRIVLEN));
-#ifdef __ROTOR_MLOCK
-    munlock(&kr, sizeof(NtruEncKeyPair));
-    munlock(&rng_sk, sizeof(NtruRandGen));
-    munlock(&rand_sk_ctx, sizeof(NtruRandContext));
-    munlock(&enc, (sizeof(uint8_t)*NTRU_PRIVLEN));
-    munlock(&fbuf, (sizeof(char)*171));
-    munlock(&shake_key, (sizeof(uint8_t)*NTRU_PRIVLEN));
-    munlock(&stream_block, (sizeof(uint8_t)*NTRU_PRIVLEN));
-    munlock(&stream_in, (sizeof(uint8_t)*NTRU_PRIVLEN));
-    munlock(&stream_final, (sizeof(uint8_t)*NTRU_PRIVLEN));
+  }
+  if ((output = fopen(ofname, "wb")) == NULL) {
+    printf("%s: can't open %s\n", sfname, ofname);
+    goto done;
+  }
+  if (dec) {
+    rc = rotor_read_header(ctx, keyf ? keyf : input, sfname);
+  } else {
+#ifdef _OPENMP
+#pragma omp critical (rotor_rand_init)
 #endif
-
+    rc = rotor_write_header(ctx, (compress) ? NULL : sfname, keyf ? keyf : output, 1, sfname);
+  }
+  if (rc == ROTOR_SUCCESS)
+    rc = (dec) ? rotor_decrypt_body(ctx, input, output, sfname) : rotor_encrypt_body(ctx, input, output, sfname);
+ done:
+  rotor_ctx_free(ctx);
+  if (input)
     fclose(input);
-    fclose(output);
+  if (keyf) {
+    if ((fclose(keyf) != 0) && !dec && (rc == ROTOR_SUCCESS)) {
+      printf("%s: write to %s failed\n", sfname, keyfname);
+      rc = ROTOR_ERR_PARAM;
+    }
+  }
+  if (output) {
+    if ((fclose(output) != 0) && (rc == ROTOR_SUCCESS)) {
+      printf("%s: write to %s failed\n", sfname, ofname);
+      rc = ROTOR_ERR_PARAM;
+    }
+    if (rc != ROTOR_SUCCESS) // no half written plaintext lying around
+      unlink(ofname);
+  }
+  if (keyf && !dec && (rc != ROTOR_SUCCESS)) // nor a key file for nothing
+    unlink(keyfname);
+  return rc;
 }
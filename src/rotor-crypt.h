@@ -30,20 +30,23 @@
 /*
  * rotor encryption and decryption master functions
  *
- * rotor_decrypt_file: use keypair to decrypt file
+ * rotor_decrypt_file: use keypair to decrypt file. these are file wrappers
+ * around librotor, see rotor-ctx.h
  *
  */
 
-void rotor_decrypt_file(NtruEncKeyPair kr, char *sfname, char *ofname, char *keyfname);
+void rotor_decrypt_file(NtruEncKeyPair *kr, char *sfname, char *ofname, char *keyfname);
 
 /*
  * rotor encryption and decryption master functions
  *
- * rotor_encrypt_file: use keypair to encrypt file
+ * rotor_encrypt_file: use keypair to encrypt file. compress runs the
+ * plaintext through bzip2 first (rotor-compress.h), decrypt sees it in the
+ * header
  *
  */
 
-void rotor_encrypt_file(NtruEncKeyPair kr, char *sfname, char *ofname, char *keyfname);
+void rotor_encrypt_file(NtruEncKeyPair *kr, char *sfname, char *ofname, char *keyfname, int compress);
 
 /*
  * rotor encryption and decryption master functions
@@ -52,7 +55,7 @@ void rotor_encrypt_file(NtruEncKeyPair kr, char *sfname, char *ofname, char *key
  *
  */
 
-void rotor_decrypt_file_sym(NtruEncKeyPair kr, char *sfname, char *ofname);
+void rotor_decrypt_file_sym(NtruEncKeyPair *kr, char *sfname, char *ofname);
 
 /*
  * rotor encryption and decryption master functions
@@ -61,7 +64,42 @@ void rotor_decrypt_file_sym(NtruEncKeyPair kr, char *sfname, char *ofname);
  *
  */
 
-void rotor_encrypt_file_sym(NtruEncKeyPair kr, char *sfname, char *ofname);
+void rotor_encrypt_file_sym(NtruEncKeyPair *kr, char *sfname, char *ofname, int compress);
+
+
+/*
+ * rotor_encrypt_stream: encrypt input to output in the streamed format, no
+ * stat() or seek, so pipes work. mode is 1 for --ext, which puts the header
+ * in keyfname
+ *
+ */
+
+void rotor_encrypt_stream(NtruEncKeyPair *kr, int mode, FILE *input, FILE *output, char *keyfname, int compress);
+
+/*
+ * rotor_decrypt_stream: decrypt a streamed file from input to output
+ *
+ */
+
+void rotor_decrypt_stream(NtruEncKeyPair *kr, int mode, FILE *input, FILE *output, char *keyfname);
+
+/*
+ * rotor_verify_file: check sfname's MAC (header in keyfname for --ext)
+ * without decrypting or writing anything, or with an index every segment
+ * in parallel. returns 0 or a ROTOR_ERR_ code
+ *
+ */
+
+int rotor_verify_file(NtruEncKeyPair *kr, int mode, char *sfname, char *keyfname);
+
+/*
+ * rotor_crypt_file_batch: encrypt sfname to sfname.enc, or decrypt it back
+ * if dec is set, for batch workers. compress as for rotor_encrypt_file.
+ * safe to call from several threads with a shared kr. returns 0 or a
+ * ROTOR_ERR_ code, never exits
+ *
+ */
 
+int rotor_crypt_file_batch(NtruEncKeyPair *kr, int mode, int dec, int compress, char *sfname, uint64_t *in_len);
 
 #endif
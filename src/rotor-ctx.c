@@ -0,0 +1,1032 @@
+/*****************************************************************************
+ * (c) 2016 BSD 2 clause adouble42/mrn@sdf                                   *
+ * rotor - "If knowledge can create problems, it is not through ignorance    *
+ * that we can solve them." -- isaac asimov                                  *
+ *                                                                           *
+ * rotor-ctx.c - librotor streaming encryption and decryption                *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "ntru.h"
+#include "shake.h"
+#include "salsa20.h"
+#include "skein/skein.h"
+#include "rotor.h"
+#include "rotor-ctx.h"
+#include "rotor-stats.h"
+#include "rotor-probe.h"
+
+#ifdef __ROTOR_MLOCK
+#include <sys/mman.h>
+#endif
+
+struct rotor_ctx {
+  NtruEncKeyPair *kr;
+  NtruRandGen rng;
+  NtruRandContext rand_ctx;
+  int rng_ok;
+  int mode;
+  int encrypt;
+  int ready;
+  int verify;           // rotor_ctx_verify_init: MAC only
+  int allow_unauth;     // rotor_ctx_allow_unauth: v2 files without a MAC
+  int stream;           // ROTOR_V2_STREAM format
+  uint32_t flags;       // ROTOR_FLAG_ bits of the header
+  uint32_t enc_flags;   // for the next encrypt_init
+  uint64_t total;       // plaintext length, encrypt only
+  uint64_t seen;
+  uint64_t blocks;      // full plaintext blocks
+  uint64_t block_count;
+  int remainder;
+  size_t in_block;      // bytes consumed per block
+  uint8_t salsa_key[32];
+  uint8_t salsa_nonce[8];
+  uint8_t stream_block[ROTOR_BLOCK];
+  uint8_t stream_final[ROTOR_BLOCK];
+  uint8_t enc[NTRU_ENCLEN];
+  uint8_t dec[NTRU_ENCLEN];
+  uint8_t buf[NTRU_ENCLEN]; // partial input block
+  size_t buf_len;
+  uint8_t pend[2][ROTOR_BLOCK]; // streamed decrypt: last data block and length block
+  uint16_t pend_len[2];
+  int pend_count;
+  uint64_t out_total;
+  Skein_512_Ctxt_t mac; // ROTOR_FLAG_MAC, header and every ciphertext block
+  Skein_512_Ctxt_t idx_key;  // ROTOR_FLAG_INDEX: keyed, every tag starts here
+  Skein_512_Ctxt_t idx_seg;  // segment being tagged
+  Skein_512_Ctxt_t idx_root; // header, tags and footer
+  uint64_t idx_count;   // segments tagged
+  uint64_t idx_bytes;   // ciphertext tagged
+  size_t idx_fill;      // bytes in idx_seg
+  uint8_t *idx;         // the tags, then the footer
+  size_t idx_cap;
+  size_t idx_len;       // finished index, 0 until then
+};
+
+static const char *rotor_ctx_errors[] = {
+  "success",
+  "bad argument or call order",
+  "random number generator failed",
+  "NTRU encryption failed",
+  "length does not match header",
+  "not a rotor header",
+  "compressed data is corrupt",
+  "authentication failed, file was altered",
+  "out of memory",
+  "no MAC, file is not authenticated",
+};
+
+const char *rotor_ctx_strerror(int err) {
+  if ((err < 0) || (err > ROTOR_ERR_NOMAC))
+    return "unknown error";
+  return rotor_ctx_errors[err];
+}
+
+rotor_ctx *rotor_ctx_new(NtruEncKeyPair *kr, int mode) {
+  rotor_ctx *ctx;
+
+  if ((!kr) || ((mode != ROTOR_MODE_SYM) && (mode != ROTOR_MODE_EXT)))
+    return NULL;
+  ctx = (rotor_ctx *)calloc(1, sizeof(rotor_ctx));
+  if (!ctx)
+    return NULL;
+#ifdef __ROTOR_MLOCK
+  mlock(ctx, sizeof(rotor_ctx));
+#endif
+  ctx->kr = kr;
+  ctx->mode = mode;
+  return ctx;
+}
+
+void rotor_ctx_free(rotor_ctx *ctx) {
+  if (!ctx)
+    return;
+  if (ctx->rng_ok)
+    ntru_rand_release(&ctx->rand_ctx);
+  free(ctx->idx);
+  burn(ctx, sizeof(rotor_ctx));
+#ifdef __ROTOR_MLOCK
+  munlock(ctx, sizeof(rotor_ctx));
+#endif
+  free(ctx);
+}
+
+/*
+ * rotor_ctx_keys: stream keys from the two header secrets. the MAC key is
+ * SHAKE-256 of both together, a different input length than either stream
+ * key is drawn from. the index key takes one byte more. a v2 header, v2
+ * non-NULL, goes into every one of them after the secrets, so a file whose
+ * flags or sizes were changed, or that was made into a v1 file, decrypts to
+ * noise under keys of its own. v1 keys stay what they always were
+ */
+
+static void rotor_ctx_keys(rotor_ctx *ctx, uint8_t *shake_key, uint8_t *salsa_seed, const uint8_t *v2) {
+  uint8_t key_in[170 + ROTOR_V2_LEN];
+  uint8_t mac_in[340 + ROTOR_V2_LEN + 1];
+  uint8_t mac_key[ROTOR_MAC_LEN];
+  size_t bind = (v2) ? ROTOR_V2_LEN : 0;
+
+#ifdef __ROTOR_MLOCK
+  mlock(&key_in, sizeof(key_in));
+  mlock(&mac_in, sizeof(mac_in));
+  mlock(&mac_key, sizeof(mac_key));
+#endif
+  memcpy(key_in, shake_key, 170);
+  memcpy(key_in + 170, v2, bind);
+  FIPS202_SHAKE256(key_in, 170 + bind, ctx->stream_block, 170);
+  FIPS202_SHAKE256(key_in, 170 + bind, ctx->salsa_nonce, 8);
+  memcpy(key_in, salsa_seed, 170);
+  FIPS202_SHAKE256(key_in, 170 + bind, ctx->salsa_key, 32);
+  memcpy(mac_in, shake_key, 170);
+  memcpy(mac_in + 170, salsa_seed, 170);
+  memcpy(mac_in + 340, v2, bind);
+  FIPS202_SHAKE256(mac_in, 340 + bind, mac_key, ROTOR_MAC_LEN);
+  Skein_512_InitExt(&ctx->mac, 512, SKEIN_CFG_TREE_INFO_SEQUENTIAL, mac_key, ROTOR_MAC_LEN);
+  mac_in[340 + bind] = 'i';
+  FIPS202_SHAKE256(mac_in, 341 + bind, mac_key, ROTOR_MAC_LEN);
+  Skein_512_InitExt(&ctx->idx_key, 8*ROTOR_IDX_TAG, SKEIN_CFG_TREE_INFO_SEQUENTIAL, mac_key, ROTOR_MAC_LEN);
+  ctx->idx_root = ctx->idx_key;
+  ctx->idx_count = 0;
+  ctx->idx_bytes = 0;
+  ctx->idx_fill = 0;
+  burn(&key_in, sizeof(key_in));
+  burn(&mac_in, sizeof(mac_in));
+  burn(&mac_key, sizeof(mac_key));
+#ifdef __ROTOR_MLOCK
+  munlock(&key_in, sizeof(key_in));
+  munlock(&mac_in, sizeof(mac_in));
+  munlock(&mac_key, sizeof(mac_key));
+#endif
+  // the tail of a short first block goes out as it is. keystream, not zeros,
+  // or a streamed file of a few bytes cut before its length block could
+  // pass for an empty one
+  memcpy(ctx->stream_final, ctx->stream_block, ROTOR_BLOCK);
+  ctx->seen = 0;
+  ctx->block_count = 0;
+  ctx->buf_len = 0;
+  ctx->pend_count = 0;
+  ctx->out_total = 0;
+  ctx->in_block = ctx->encrypt ? ROTOR_BLOCK : ((ctx->mode == ROTOR_MODE_EXT) ? NTRU_ENCLEN : ROTOR_BLOCK);
+  ctx->ready = 1;
+}
+
+/*
+ * little endian helpers for the v2 header
+ */
+
+static void rotor_put32(uint8_t *p, uint32_t v) {
+  int i;
+
+  for (i=0; i<4; i++)
+    p[i] = (uint8_t)(v >> (8*i));
+}
+
+static void rotor_put64(uint8_t *p, uint64_t v) {
+  int i;
+
+  for (i=0; i<8; i++)
+    p[i] = (uint8_t)(v >> (8*i));
+}
+
+static uint32_t rotor_get32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t rotor_get64(const uint8_t *p) {
+  return (uint64_t)rotor_get32(p) | ((uint64_t)rotor_get32(p + 4) << 32);
+}
+
+static int rotor_is_v2(const uint8_t *head) {
+  return (memcmp(head, ROTOR_V2_MAGIC, 8) == 0);
+}
+
+size_t rotor_ctx_header_len(const uint8_t *head) {
+  return (rotor_is_v2(head) ? ROTOR_V2_LEN : sizeof(struct fileHeader)) + 2*NTRU_ENCLEN;
+}
+
+/*
+ * rotor_ctx_segments: body blocks for the current size
+ */
+
+static uint64_t rotor_ctx_segments(const rotor_ctx *ctx) {
+  return ctx->blocks + ((ctx->remainder) ? 1 : 0) + ((ctx->mode == ROTOR_MODE_EXT) ? 1 : 0);
+}
+
+/*
+ * rotor_ctx_cipher_block: ciphertext block size
+ */
+
+static size_t rotor_ctx_cipher_block(const rotor_ctx *ctx) {
+  return (ctx->mode == ROTOR_MODE_EXT) ? NTRU_ENCLEN : ROTOR_BLOCK;
+}
+
+/*
+ * rotor_ctx_body_fits: the body a header promises has a length that fits in
+ * a uint64_t, so nothing derived from blocks overflows
+ */
+
+static int rotor_ctx_body_fits(const rotor_ctx *ctx) {
+  return (ctx->blocks <= (ROTOR_LEN_STREAM - ROTOR_MAC_LEN) / rotor_ctx_cipher_block(ctx) - 2);
+}
+
+uint64_t rotor_ctx_body_len(const rotor_ctx *ctx) {
+  if (ctx->stream)
+    return ROTOR_LEN_STREAM;
+  return rotor_ctx_segments(ctx) * rotor_ctx_cipher_block(ctx) + ((ctx->flags & ROTOR_FLAG_MAC) ? ROTOR_MAC_LEN : 0);
+}
+
+int rotor_ctx_set_flags(rotor_ctx *ctx, uint32_t flags) {
+  if ((!ctx) || (flags & ~(ROTOR_FLAG_BZIP2 | ROTOR_FLAG_FRAMES | ROTOR_FLAG_MAC | ROTOR_FLAG_INDEX)))
+    return ROTOR_ERR_PARAM;
+  ctx->enc_flags = flags;
+  return ROTOR_SUCCESS;
+}
+
+int rotor_ctx_allow_unauth(rotor_ctx *ctx, int allow) {
+  if (!ctx)
+    return ROTOR_ERR_PARAM;
+  ctx->allow_unauth = (allow) ? 1 : 0;
+  return ROTOR_SUCCESS;
+}
+
+uint32_t rotor_ctx_flags(const rotor_ctx *ctx) {
+  return ctx->flags;
+}
+
+void rotor_ctx_info(const rotor_ctx *ctx, uint64_t *size, uint64_t *segments) {
+  if (ctx->stream) {
+    *size = ROTOR_LEN_STREAM;
+    *segments = 0;
+  } else {
+    *size = ctx->blocks * ROTOR_BLOCK + ctx->remainder;
+    *segments = rotor_ctx_segments(ctx);
+  }
+}
+
+int rotor_ctx_encrypt_init(rotor_ctx *ctx, uint64_t total_len, uint8_t *head) {
+  uint8_t shake_key[170];
+  uint8_t salsa_seed[170];
+  int rc = ROTOR_SUCCESS;
+
+  if ((!ctx) || (!head))
+    return ROTOR_ERR_PARAM;
+  if (!ctx->rng_ok) {
+    ctx->rng = (NtruRandGen)NTRU_RNG_DEFAULT;
+    if (ntru_rand_init(&ctx->rand_ctx, &ctx->rng) != NTRU_SUCCESS)
+      return ROTOR_ERR_PRNG;
+    ctx->rng_ok = 1;
+  }
+#ifdef __ROTOR_MLOCK
+  mlock(&shake_key, sizeof(shake_key));
+  mlock(&salsa_seed, sizeof(salsa_seed));
+#endif
+  ctx->encrypt = 1;
+  ctx->verify = 0;
+  ctx->idx_len = 0;
+  ctx->total = total_len;
+  ctx->stream = (total_len == ROTOR_LEN_STREAM);
+  ctx->flags = ctx->enc_flags;
+  ctx->blocks = (ctx->stream) ? 0 : total_len / ROTOR_BLOCK;
+  ctx->remainder = (ctx->stream) ? 0 : total_len % ROTOR_BLOCK;
+  memset(head, 0, ROTOR_V2_LEN);
+  memcpy(head, ROTOR_V2_MAGIC, 8);
+  rotor_put32(head + 8, ctx->mode | ((ctx->stream) ? ROTOR_V2_STREAM : 0) | ctx->flags);
+  if (!ctx->stream) {
+    rotor_put32(head + 12, ctx->remainder);
+    rotor_put64(head + 16, total_len);
+    rotor_put64(head + 24, ctx->blocks);
+    rotor_put64(head + 32, rotor_ctx_segments(ctx));
+  }
+  if ((ntru_rand_generate(shake_key, 170, &ctx->rand_ctx) != NTRU_SUCCESS) ||
+      (ntru_rand_generate(salsa_seed, 170, &ctx->rand_ctx) != NTRU_SUCCESS)) {
+    rc = ROTOR_ERR_PRNG;
+  } else {
+    ROTOR_PROBE1(ntru_encrypt_start, (int64_t)-1);
+    if ((ntru_encrypt(shake_key, 170, &ctx->kr->pub, &EES1087EP2, &ctx->rand_ctx,
+		      head + ROTOR_V2_LEN) != NTRU_SUCCESS) ||
+	(ntru_encrypt(salsa_seed, 170, &ctx->kr->pub, &EES1087EP2, &ctx->rand_ctx,
+		      head + ROTOR_V2_LEN + NTRU_ENCLEN) != NTRU_SUCCESS))
+      rc = ROTOR_ERR_NTRU;
+    ROTOR_PROBE2(ntru_encrypt_done, (int64_t)-1, rc);
+    if (rc == ROTOR_SUCCESS)
+      rotor_ctx_keys(ctx, shake_key, salsa_seed, head);
+  }
+  if ((rc == ROTOR_SUCCESS) && (ctx->flags & ROTOR_FLAG_MAC))
+    Skein_512_Update(&ctx->mac, head, ROTOR_HEADER_LEN);
+  if ((rc == ROTOR_SUCCESS) && (ctx->flags & ROTOR_FLAG_INDEX))
+    Skein_512_Update(&ctx->idx_root, head, ROTOR_HEADER_LEN);
+  burn(&shake_key, sizeof(shake_key));
+  burn(&salsa_seed, sizeof(salsa_seed));
+#ifdef __ROTOR_MLOCK
+  munlock(&shake_key, sizeof(shake_key));
+  munlock(&salsa_seed, sizeof(salsa_seed));
+#endif
+  return rc;
+}
+
+/*
+ * rotor_ctx_parse_header: sizes from a v1 or v2 header, the v1 remainder
+ * comes later out of shake_key. returns the header length or 0
+ */
+
+static size_t rotor_ctx_parse_header(rotor_ctx *ctx, const uint8_t *head) {
+  struct fileHeaderV2 v2;
+  struct fileHeader myInfo;
+
+  if (!rotor_is_v2(head)) {
+    memcpy(&myInfo, head, sizeof(myInfo));
+    if (myInfo.fileSize < 0)
+      return 0;
+    ctx->stream = 0;
+    ctx->flags = 0;
+    ctx->blocks = myInfo.fileSize;
+    ctx->remainder = -1;
+    return (rotor_ctx_body_fits(ctx)) ? sizeof(myInfo) : 0;
+  }
+  v2.cryptMode = rotor_get32(head + 8);
+  v2.remainder = rotor_get32(head + 12);
+  v2.fileSize = rotor_get64(head + 16);
+  v2.blocks = rotor_get64(head + 24);
+  v2.segments = rotor_get64(head + 32);
+  if ((v2.cryptMode & ~(ROTOR_V2_EXT | ROTOR_V2_STREAM | ROTOR_V2_BZIP2 | ROTOR_V2_FRAMES | ROTOR_V2_MAC | ROTOR_V2_INDEX)) ||
+      ((int)(v2.cryptMode & ROTOR_V2_EXT) != ctx->mode))
+    return 0;
+  ctx->stream = (v2.cryptMode & ROTOR_V2_STREAM) ? 1 : 0;
+  ctx->flags = v2.cryptMode & (ROTOR_V2_BZIP2 | ROTOR_V2_FRAMES | ROTOR_V2_MAC | ROTOR_V2_INDEX);
+  if (ctx->stream) {
+    if (v2.remainder || v2.fileSize || v2.blocks || v2.segments)
+      return 0;
+    ctx->blocks = 0;
+    ctx->remainder = 0;
+    return ROTOR_V2_LEN;
+  }
+  ctx->blocks = v2.blocks;
+  ctx->remainder = v2.remainder;
+  if ((v2.blocks != v2.fileSize / ROTOR_BLOCK) || (v2.remainder != v2.fileSize % ROTOR_BLOCK) ||
+      (!rotor_ctx_body_fits(ctx)) || (v2.segments != rotor_ctx_segments(ctx)))
+    return 0;
+  return ROTOR_V2_LEN;
+}
+
+int rotor_ctx_decrypt_init(rotor_ctx *ctx, const uint8_t *head) {
+  uint8_t shake_key[NTRU_ENCLEN];
+  uint8_t salsa_seed[NTRU_ENCLEN];
+  uint16_t dec_len = 0;
+  size_t hlen;
+  int remainder, rc = ROTOR_SUCCESS;
+
+  if ((!ctx) || (!head))
+    return ROTOR_ERR_PARAM;
+#ifdef __ROTOR_MLOCK
+  mlock(&shake_key, sizeof(shake_key));
+  mlock(&salsa_seed, sizeof(salsa_seed));
+#endif
+  ctx->encrypt = 0;
+  ctx->ready = 0; // nothing from an earlier file once this one fails
+  ctx->verify = 0;
+  ctx->idx_len = 0;
+  hlen = rotor_ctx_parse_header(ctx, head);
+  remainder = ctx->remainder;
+  if (hlen)
+    memcpy(ctx->enc, head + hlen, NTRU_ENCLEN); // ntru_decrypt wants it writable
+  ROTOR_PROBE1(ntru_decrypt_start, (int64_t)-1);
+  if ((hlen == ROTOR_V2_LEN) && (!(ctx->flags & ROTOR_FLAG_MAC)) && (!ctx->allow_unauth)) {
+    rc = ROTOR_ERR_NOMAC; // whoever cut off the tag would have cleared the flag too
+  } else if ((!hlen) ||
+	     (ntru_decrypt(ctx->enc, ctx->kr, &EES1087EP2, shake_key, &dec_len) != NTRU_SUCCESS) ||
+	     (dec_len != 170)) {
+    rc = ROTOR_ERR_FORMAT;
+  } else {
+    memcpy(ctx->enc, head + hlen + NTRU_ENCLEN, NTRU_ENCLEN);
+    if (remainder < 0) // v1
+      remainder = shake_key[1];
+    if ((ntru_decrypt(ctx->enc, ctx->kr, &EES1087EP2, salsa_seed, &dec_len) != NTRU_SUCCESS) ||
+	(dec_len != 170) || (remainder >= ROTOR_BLOCK)) {
+      rc = ROTOR_ERR_FORMAT;
+    } else {
+      rotor_ctx_keys(ctx, shake_key, salsa_seed, (hlen == ROTOR_V2_LEN) ? head : NULL);
+      ctx->remainder = remainder;
+      if (ctx->flags & ROTOR_FLAG_MAC)
+	Skein_512_Update(&ctx->mac, head, hlen + 2*NTRU_ENCLEN);
+    }
+  }
+  ROTOR_PROBE3(ntru_decrypt_done, (int64_t)-1, rc, dec_len);
+  burn(&shake_key, sizeof(shake_key));
+  burn(&salsa_seed, sizeof(salsa_seed));
+#ifdef __ROTOR_MLOCK
+  munlock(&shake_key, sizeof(shake_key));
+  munlock(&salsa_seed, sizeof(salsa_seed));
+#endif
+  return rc;
+}
+
+int rotor_ctx_verify_init(rotor_ctx *ctx, const uint8_t *head) {
+  int rc;
+
+  if ((rc = rotor_ctx_decrypt_init(ctx, head)))
+    return rc;
+  if (!(ctx->flags & ROTOR_FLAG_MAC)) {
+    ctx->ready = 0;
+    return ROTOR_ERR_NOMAC;
+  }
+  ctx->verify = 1;
+  return ROTOR_SUCCESS;
+}
+
+/*
+ * rotor_ctx_burn: everything a finished or abandoned file leaves behind,
+ * except the index key
+ */
+
+static void rotor_ctx_burn(rotor_ctx *ctx) {
+  burn(ctx->stream_block, sizeof(ctx->stream_block));
+  burn(ctx->stream_final, sizeof(ctx->stream_final));
+  burn(ctx->salsa_key, sizeof(ctx->salsa_key));
+  burn(ctx->enc, sizeof(ctx->enc));
+  burn(ctx->dec, sizeof(ctx->dec));
+  burn(ctx->buf, sizeof(ctx->buf));
+  burn(ctx->pend, sizeof(ctx->pend));
+  burn(&ctx->mac, sizeof(ctx->mac));
+  burn(&ctx->idx_seg, sizeof(ctx->idx_seg));
+  burn(&ctx->idx_root, sizeof(ctx->idx_root));
+  ctx->buf_len = 0;
+  ctx->pend_count = 0;
+}
+
+/*
+ * rotor_ctx_seg_blocks, rotor_ctx_seg_len: blocks per index segment and its
+ * bytes
+ */
+
+static size_t rotor_ctx_seg_blocks(const rotor_ctx *ctx) {
+  return ROTOR_IDX_SEG / rotor_ctx_cipher_block(ctx);
+}
+
+static size_t rotor_ctx_seg_len(const rotor_ctx *ctx) {
+  return rotor_ctx_seg_blocks(ctx) * rotor_ctx_cipher_block(ctx);
+}
+
+/*
+ * rotor_ctx_index_room: idx big enough for n tags and the footer
+ */
+
+static int rotor_ctx_index_room(rotor_ctx *ctx, uint64_t n) {
+  size_t cap = ctx->idx_cap ? ctx->idx_cap : 64;
+  uint8_t *p;
+
+  if (n > (SIZE_MAX - ROTOR_IDX_FOOT) / ROTOR_IDX_TAG)
+    return ROTOR_ERR_MEMORY;
+  while (cap < n * ROTOR_IDX_TAG + ROTOR_IDX_FOOT)
+    cap = (cap > SIZE_MAX / 2) ? n * ROTOR_IDX_TAG + ROTOR_IDX_FOOT : 2 * cap;
+  if (cap == ctx->idx_cap)
+    return ROTOR_SUCCESS;
+  if ((p = (uint8_t *)realloc(ctx->idx, cap)) == NULL)
+    return ROTOR_ERR_MEMORY;
+  ctx->idx = p;
+  ctx->idx_cap = cap;
+  return ROTOR_SUCCESS;
+}
+
+/*
+ * rotor_ctx_segment_start: tag state for segment seg, its number goes first
+ * so segments can't swap places
+ */
+
+static void rotor_ctx_segment_start(const rotor_ctx *ctx, Skein_512_Ctxt_t *s, uint64_t seg) {
+  uint8_t n[8];
+
+  *s = ctx->idx_key;
+  rotor_put64(n, seg);
+  Skein_512_Update(s, n, 8);
+}
+
+/*
+ * rotor_ctx_index_tag: finish the open segment, its tag goes to the index
+ * and the root
+ */
+
+static int rotor_ctx_index_tag(rotor_ctx *ctx) {
+  uint8_t *tag;
+  int rc;
+
+  if ((rc = rotor_ctx_index_room(ctx, ctx->idx_count + 1)))
+    return rc;
+  tag = ctx->idx + ctx->idx_count * ROTOR_IDX_TAG;
+  Skein_512_Final(&ctx->idx_seg, tag);
+  Skein_512_Update(&ctx->idx_root, tag, ROTOR_IDX_TAG);
+  ctx->idx_count++;
+  ctx->idx_fill = 0;
+  return ROTOR_SUCCESS;
+}
+
+/*
+ * rotor_ctx_index_feed: len bytes of ciphertext on their way out, cut into
+ * segments. blocks and the MAC trailer after them, so a segment check
+ * covers everything up to the index
+ */
+
+static int rotor_ctx_index_feed(rotor_ctx *ctx, const uint8_t *out, size_t len) {
+  size_t take;
+  int rc;
+
+  if (!(ctx->flags & ROTOR_FLAG_INDEX))
+    return ROTOR_SUCCESS;
+  while (len) {
+    if (ctx->idx_fill == 0)
+      rotor_ctx_segment_start(ctx, &ctx->idx_seg, ctx->idx_count);
+    take = rotor_ctx_seg_len(ctx) - ctx->idx_fill;
+    if (take > len)
+      take = len;
+    Skein_512_Update(&ctx->idx_seg, out, take);
+    ctx->idx_fill += take;
+    ctx->idx_bytes += take;
+    out += take;
+    len -= take;
+    if ((ctx->idx_fill == rotor_ctx_seg_len(ctx)) && (rc = rotor_ctx_index_tag(ctx)))
+      return rc;
+  }
+  return ROTOR_SUCCESS;
+}
+
+/*
+ * rotor_ctx_index_close: tag the last short segment and write the footer
+ */
+
+static int rotor_ctx_index_close(rotor_ctx *ctx) {
+  uint8_t *foot;
+  int rc;
+
+  if ((ctx->idx_fill) && (rc = rotor_ctx_index_tag(ctx)))
+    return rc;
+  if ((rc = rotor_ctx_index_room(ctx, ctx->idx_count)))
+    return rc;
+  foot = ctx->idx + ctx->idx_count * ROTOR_IDX_TAG;
+  rotor_put64(foot, ctx->idx_count);
+  rotor_put32(foot + 8, rotor_ctx_seg_blocks(ctx));
+  rotor_put64(foot + 12, ctx->idx_bytes);
+  Skein_512_Update(&ctx->idx_root, foot, ROTOR_IDX_FOOT - ROTOR_IDX_TAG);
+  Skein_512_Final(&ctx->idx_root, foot + ROTOR_IDX_FOOT - ROTOR_IDX_TAG);
+  ctx->idx_len = ctx->idx_count * ROTOR_IDX_TAG + ROTOR_IDX_FOOT;
+  return ROTOR_SUCCESS;
+}
+
+/*
+ * rotor_ctx_tag_diff: nonzero if two tags differ, every byte compared
+ */
+
+static int rotor_ctx_tag_diff(const uint8_t *a, const uint8_t *b, size_t len) {
+  uint8_t diff = 0;
+  size_t xx;
+
+  for (xx=0; xx<len; xx++)
+    diff |= a[xx] ^ b[xx];
+  return diff;
+}
+
+const uint8_t *rotor_ctx_index(const rotor_ctx *ctx, size_t *len) {
+  *len = 0;
+  if ((!ctx) || (!ctx->encrypt) || (!ctx->idx_len))
+    return NULL;
+  *len = ctx->idx_len;
+  return ctx->idx;
+}
+
+size_t rotor_ctx_index_len(const rotor_ctx *ctx, const uint8_t *foot, uint64_t *body_len) {
+  uint64_t count = rotor_get64(foot);
+  uint64_t bytes = rotor_get64(foot + 12);
+
+  if ((rotor_get32(foot + 8) != rotor_ctx_seg_blocks(ctx)) || (bytes > ROTOR_LEN_STREAM / 2) ||
+      (count != (bytes + rotor_ctx_seg_len(ctx) - 1) / rotor_ctx_seg_len(ctx)) ||
+      (count > (SIZE_MAX - ROTOR_IDX_FOOT) / ROTOR_IDX_TAG))
+    return 0;
+  *body_len = bytes;
+  return count * ROTOR_IDX_TAG + ROTOR_IDX_FOOT;
+}
+
+int rotor_ctx_index_init(rotor_ctx *ctx, const uint8_t *head, const uint8_t *index, size_t index_len) {
+  Skein_512_Ctxt_t root;
+  uint8_t tag[ROTOR_IDX_TAG];
+  uint64_t body_len;
+  int rc;
+
+  if ((!index) || (index_len < ROTOR_IDX_FOOT))
+    return ROTOR_ERR_PARAM;
+  // straight after rotor_ctx_verify_init its keys are still there, a
+  // different head can't match the index tag under them
+  rc = ((ctx->verify) && (ctx->ready)) ? ROTOR_SUCCESS : rotor_ctx_decrypt_init(ctx, head);
+  ctx->ready = 0; // nothing to stream, only segments
+  rotor_ctx_burn(ctx);
+  if (rc)
+    return rc;
+  if (!(ctx->flags & ROTOR_FLAG_INDEX))
+    return ROTOR_ERR_FORMAT;
+  if (rotor_ctx_index_len(ctx, index + index_len - ROTOR_IDX_FOOT, &body_len) != index_len)
+    return ROTOR_ERR_FORMAT;
+  if ((!ctx->stream) && (body_len != rotor_ctx_body_len(ctx)))
+    return ROTOR_ERR_LENGTH;
+  root = ctx->idx_key;
+  Skein_512_Update(&root, head, rotor_ctx_header_len(head));
+  Skein_512_Update(&root, index, index_len - ROTOR_IDX_TAG);
+  Skein_512_Final(&root, tag);
+  if (rotor_ctx_tag_diff(tag, index + index_len - ROTOR_IDX_TAG, ROTOR_IDX_TAG))
+    return ROTOR_ERR_MAC;
+  ctx->idx_count = rotor_get64(index + index_len - ROTOR_IDX_FOOT);
+  ctx->idx_bytes = body_len;
+  if ((rc = rotor_ctx_index_room(ctx, ctx->idx_count)))
+    return rc;
+  memcpy(ctx->idx, index, index_len);
+  ctx->idx_len = index_len;
+  return ROTOR_SUCCESS;
+}
+
+void rotor_ctx_index_info(const rotor_ctx *ctx, uint64_t *count, size_t *seg_len, uint64_t *body_len) {
+  *count = (ctx->idx_len) ? ctx->idx_count : 0;
+  *seg_len = rotor_ctx_seg_len(ctx);
+  *body_len = (ctx->idx_len) ? ctx->idx_bytes : 0;
+}
+
+int rotor_ctx_verify_segment(const rotor_ctx *ctx, uint64_t seg, const uint8_t *in, size_t len) {
+  Skein_512_Ctxt_t s;
+  uint8_t tag[ROTOR_IDX_TAG];
+  uint64_t at;
+  double t0;
+
+  if ((!ctx) || (ctx->encrypt) || (!ctx->idx_len) || (seg >= ctx->idx_count))
+    return ROTOR_ERR_PARAM;
+  at = seg * rotor_ctx_seg_len(ctx);
+  if (len != ((seg + 1 < ctx->idx_count) ? rotor_ctx_seg_len(ctx) : ctx->idx_bytes - at))
+    return ROTOR_ERR_LENGTH;
+  t0 = rotor_stats_now();
+  rotor_ctx_segment_start(ctx, &s, seg);
+  Skein_512_Update(&s, in, len);
+  Skein_512_Final(&s, tag);
+  rotor_stats_time(ROTOR_STAT_MAC, t0);
+  return (rotor_ctx_tag_diff(tag, ctx->idx + seg * ROTOR_IDX_TAG, ROTOR_IDX_TAG)) ? ROTOR_ERR_MAC : ROTOR_SUCCESS;
+}
+
+/*
+ * rotor_ctx_encrypt_block: nt bytes of plaintext, nt < ROTOR_BLOCK only for
+ * the last one. the stale tail of stream_final goes along, as it always has
+ */
+
+static int rotor_ctx_encrypt_block(rotor_ctx *ctx, const uint8_t *in, int nt, uint8_t *out, size_t *out_len) {
+  double t0;
+  int xx, rc;
+
+  t0 = rotor_stats_now();
+  for (xx=0; xx<nt; xx++)
+    ctx->stream_final[xx] = in[xx] ^ ctx->stream_block[xx];
+  FIPS202_SHAKE256(in, nt, ctx->stream_block, 170);
+  rotor_stats_time(ROTOR_STAT_SHAKE, t0);
+  if (ctx->mode == ROTOR_MODE_SYM) {
+    t0 = rotor_stats_now();
+    memcpy(out, ctx->stream_final, ROTOR_BLOCK);
+    s20_crypt(ctx->salsa_key, S20_KEYLEN_256, ctx->salsa_nonce, 0, out, ROTOR_BLOCK);
+    rotor_stats_time(ROTOR_STAT_SALSA20, t0);
+    t0 = rotor_stats_now();
+    FIPS202_SHAKE256(ctx->stream_final, ROTOR_BLOCK, ctx->salsa_key, 32);
+    rotor_stats_time(ROTOR_STAT_SHAKE, t0);
+    memcpy(ctx->stream_final, out, ROTOR_BLOCK);
+    *out_len = ROTOR_BLOCK;
+  } else {
+    t0 = rotor_stats_now();
+    ROTOR_PROBE1(ntru_encrypt_start, (int64_t)ctx->block_count);
+    rc = ntru_encrypt(ctx->stream_final, 170, &ctx->kr->pub, &EES1087EP2, &ctx->rand_ctx, ctx->enc);
+    ROTOR_PROBE2(ntru_encrypt_done, (int64_t)ctx->block_count, rc);
+    rotor_stats_time(ROTOR_STAT_NTRU, t0);
+    rotor_stats_count(ROTOR_COUNT_NTRU, 1);
+    if (rc != NTRU_SUCCESS)
+      return ROTOR_ERR_NTRU;
+    t0 = rotor_stats_now();
+    memcpy(out, ctx->enc, NTRU_ENCLEN);
+    s20_crypt(ctx->salsa_key, S20_KEYLEN_256, ctx->salsa_nonce, 0, out, NTRU_ENCLEN);
+    rotor_stats_time(ROTOR_STAT_SALSA20, t0);
+    t0 = rotor_stats_now();
+    strncpy((char *)ctx->enc, (char *)ctx->stream_final, 165);
+    FIPS202_SHAKE256(ctx->enc, NTRU_ENCLEN, ctx->salsa_key, 32);
+    rotor_stats_time(ROTOR_STAT_SHAKE, t0);
+    *out_len = NTRU_ENCLEN;
+  }
+  t0 = rotor_stats_now();
+  if (ctx->flags & ROTOR_FLAG_MAC)
+    Skein_512_Update(&ctx->mac, out, *out_len);
+  ctx->block_count++;
+  rc = rotor_ctx_index_feed(ctx, out, *out_len);
+  rotor_stats_time(ROTOR_STAT_MAC, t0);
+  rotor_stats_count(ROTOR_COUNT_BLOCKS, 1);
+  return rc;
+}
+
+/*
+ * rotor_ctx_open_block: undo the outer layer of one ciphertext block of
+ * in_block bytes and advance the Salsa20 key. this part doesn't need to know
+ * how long the plaintext is
+ */
+
+static int rotor_ctx_open_block(rotor_ctx *ctx, const uint8_t *in, uint8_t *plain, uint16_t *dec_len) {
+  double t0;
+  int rc;
+
+  t0 = rotor_stats_now();
+  memcpy(ctx->enc, in, ctx->in_block);
+  s20_crypt(ctx->salsa_key, S20_KEYLEN_256, ctx->salsa_nonce, 0, ctx->enc, ctx->in_block);
+  rotor_stats_time(ROTOR_STAT_SALSA20, t0);
+  if (ctx->mode == ROTOR_MODE_SYM) {
+    t0 = rotor_stats_now();
+    FIPS202_SHAKE256(ctx->enc, ROTOR_BLOCK, ctx->salsa_key, 32);
+    rotor_stats_time(ROTOR_STAT_SHAKE, t0);
+    memcpy(plain, ctx->enc, ROTOR_BLOCK);
+    *dec_len = ROTOR_BLOCK;
+  } else {
+    t0 = rotor_stats_now();
+    ROTOR_PROBE1(ntru_decrypt_start, (int64_t)ctx->block_count - 1);
+    rc = ntru_decrypt(ctx->enc, ctx->kr, &EES1087EP2, ctx->dec, dec_len);
+    ROTOR_PROBE3(ntru_decrypt_done, (int64_t)ctx->block_count - 1, rc, *dec_len);
+    rotor_stats_time(ROTOR_STAT_NTRU, t0);
+    rotor_stats_count(ROTOR_COUNT_NTRU, 1);
+    if (rc != NTRU_SUCCESS)
+      return ROTOR_ERR_NTRU;
+    if (*dec_len > ROTOR_BLOCK)
+      return ROTOR_ERR_FORMAT;
+    t0 = rotor_stats_now();
+    strncpy((char *)ctx->enc, (char *)ctx->dec, 165);
+    FIPS202_SHAKE256(ctx->enc, NTRU_ENCLEN, ctx->salsa_key, 32);
+    rotor_stats_time(ROTOR_STAT_SHAKE, t0);
+    memcpy(plain, ctx->dec, ROTOR_BLOCK);
+  }
+  return ROTOR_SUCCESS;
+}
+
+/*
+ * rotor_ctx_inner: the SHAKE stream layer, dec_len bytes of plain to out
+ */
+
+static void rotor_ctx_inner(rotor_ctx *ctx, const uint8_t *plain, uint16_t dec_len, uint8_t *out) {
+  double t0 = rotor_stats_now();
+  int xx;
+
+  for (xx=0; xx<dec_len; xx++)
+    out[xx] = plain[xx] ^ ctx->stream_block[xx];
+  FIPS202_SHAKE256(out, dec_len, ctx->stream_block, dec_len);
+  ctx->out_total += dec_len;
+  rotor_stats_time(ROTOR_STAT_SHAKE, t0);
+}
+
+/*
+ * rotor_ctx_decrypt_block: one ciphertext block. streamed, the last data
+ * block can only be cut to size once the length block behind it is in, so
+ * output runs two blocks behind
+ */
+
+static int rotor_ctx_decrypt_block(rotor_ctx *ctx, const uint8_t *in, uint8_t *out, size_t *out_len) {
+  uint16_t dec_len;
+  uint64_t data;
+  double t0;
+  int rc;
+
+  ctx->block_count++;
+  *out_len = 0;
+  rotor_stats_count(ROTOR_COUNT_BLOCKS, 1);
+  if (ctx->flags & ROTOR_FLAG_MAC) {
+    t0 = rotor_stats_now();
+    Skein_512_Update(&ctx->mac, in, ctx->in_block);
+    rotor_stats_time(ROTOR_STAT_MAC, t0);
+  }
+  if (ctx->verify)
+    return ROTOR_SUCCESS;
+  if (ctx->stream) {
+    if (ctx->pend_count == 2) {
+      if (ctx->pend_len[0] != ROTOR_BLOCK)
+	return ROTOR_ERR_FORMAT;
+      rotor_ctx_inner(ctx, ctx->pend[0], ROTOR_BLOCK, out);
+      *out_len = ROTOR_BLOCK;
+      memcpy(ctx->pend[0], ctx->pend[1], ROTOR_BLOCK);
+      ctx->pend_len[0] = ctx->pend_len[1];
+      ctx->pend_count = 1;
+    }
+    rc = rotor_ctx_open_block(ctx, in, ctx->pend[ctx->pend_count], &ctx->pend_len[ctx->pend_count]);
+    ctx->pend_count++;
+    return rc;
+  }
+  // past what the header promised is an error now, not after decrypting
+  // the rest of a long file
+  if (ctx->block_count > rotor_ctx_segments(ctx))
+    return ROTOR_ERR_LENGTH;
+  if ((rc = rotor_ctx_open_block(ctx, in, ctx->dec, &dec_len)))
+    return rc;
+  // --ext blocks carry their own length: full data blocks hold 170, the
+  // last at least the remainder (v1 wrote just that), the closing one none
+  data = ctx->blocks + ((ctx->remainder) ? 1 : 0);
+  if ((ctx->mode == ROTOR_MODE_EXT) &&
+      (((ctx->block_count <= ctx->blocks) && (dec_len != ROTOR_BLOCK)) ||
+       ((ctx->block_count > ctx->blocks) && (ctx->block_count <= data) && (dec_len < ctx->remainder)) ||
+       ((ctx->block_count > data) && (dec_len != 0))))
+    return ROTOR_ERR_FORMAT;
+  if (ctx->block_count > ctx->blocks)
+    dec_len = (ctx->block_count <= data) ? ctx->remainder : 0;
+  rotor_ctx_inner(ctx, ctx->dec, dec_len, out);
+  *out_len = dec_len;
+  return ROTOR_SUCCESS;
+}
+
+/*
+ * rotor_ctx_stream_end: length block and the last data block of a streamed
+ * file
+ */
+
+static int rotor_ctx_stream_end(rotor_ctx *ctx, uint8_t *out, size_t *out_len) {
+  const uint8_t *tail;
+  uint64_t total = 0;
+  int xx;
+
+  if (ctx->pend_count == 0)
+    return ROTOR_ERR_LENGTH;
+  tail = ctx->pend[ctx->pend_count - 1];
+  for (xx=7; xx>=0; xx--)
+    total = (total << 8) | tail[xx];
+  if (ctx->mode == ROTOR_MODE_SYM) {
+    for (xx=8; xx<ROTOR_BLOCK; xx++) // zero padded, a data block won't be
+      if (tail[xx])
+	return ROTOR_ERR_LENGTH;
+  } else if (ctx->pend_len[ctx->pend_count - 1] != 8) {
+    return ROTOR_ERR_LENGTH;
+  }
+  if (ctx->pend_count == 1)
+    return (total == ctx->out_total) ? ROTOR_SUCCESS : ROTOR_ERR_LENGTH;
+  if ((ctx->pend_len[0] != ROTOR_BLOCK) || (total <= ctx->out_total) ||
+      (total - ctx->out_total > ROTOR_BLOCK))
+    return ROTOR_ERR_LENGTH;
+  *out_len = total - ctx->out_total;
+  rotor_ctx_inner(ctx, ctx->pend[0], *out_len, out);
+  return ROTOR_SUCCESS;
+}
+
+static int rotor_ctx_block(rotor_ctx *ctx, const uint8_t *in, uint8_t *out, size_t *out_len) {
+  if (ctx->encrypt)
+    return rotor_ctx_encrypt_block(ctx, in, ROTOR_BLOCK, out, out_len);
+  return rotor_ctx_decrypt_block(ctx, in, out, out_len);
+}
+
+size_t rotor_ctx_out_max(const rotor_ctx *ctx, size_t in_len) {
+  size_t n = (ctx->buf_len + in_len) / ctx->in_block;
+
+  if (ctx->encrypt)
+    return n * ((ctx->mode == ROTOR_MODE_EXT) ? NTRU_ENCLEN : ROTOR_BLOCK);
+  return n * ROTOR_BLOCK;
+}
+
+int rotor_ctx_update(rotor_ctx *ctx, const uint8_t *in, size_t in_len, uint8_t *out, size_t *out_len) {
+  size_t take, n;
+  int rc;
+
+  *out_len = 0;
+  if ((!ctx) || (!ctx->ready))
+    return ROTOR_ERR_PARAM;
+  if (ctx->encrypt) {
+    if ((!ctx->stream) && (in_len > ctx->total - ctx->seen))
+      return ROTOR_ERR_LENGTH;
+    ctx->seen += in_len;
+  }
+  while (in_len) {
+    if ((ctx->buf_len == 0) && (in_len >= ctx->in_block)) { // straight from the caller
+      if ((rc = rotor_ctx_block(ctx, in, out, &n)))
+	return rc;
+      in += ctx->in_block;
+      in_len -= ctx->in_block;
+    } else {
+      take = ctx->in_block - ctx->buf_len;
+      if (take > in_len)
+	take = in_len;
+      memcpy(ctx->buf + ctx->buf_len, in, take);
+      ctx->buf_len += take;
+      in += take;
+      in_len -= take;
+      if (ctx->buf_len < ctx->in_block)
+	break;
+      ctx->buf_len = 0;
+      if ((rc = rotor_ctx_block(ctx, ctx->buf, out, &n)))
+	return rc;
+    }
+    out += n;
+    *out_len += n;
+  }
+  return ROTOR_SUCCESS;
+}
+
+/*
+ * rotor_ctx_check_mac: compare the tag left in buf, every byte of it
+ */
+
+static int rotor_ctx_check_mac(rotor_ctx *ctx) {
+  uint8_t tag[ROTOR_MAC_LEN];
+  uint8_t diff = 0;
+  int xx;
+
+  if (ctx->buf_len != ROTOR_MAC_LEN)
+    return ROTOR_ERR_LENGTH;
+  Skein_512_Final(&ctx->mac, tag);
+  for (xx=0; xx<ROTOR_MAC_LEN; xx++)
+    diff |= tag[xx] ^ ctx->buf[xx];
+  burn(tag, sizeof(tag));
+  return (diff) ? ROTOR_ERR_MAC : ROTOR_SUCCESS;
+}
+
+int rotor_ctx_final(rotor_ctx *ctx, uint8_t *out, size_t *out_len) {
+  uint8_t tail[ROTOR_BLOCK];
+  size_t n, tag_len;
+  int xx, rc = ROTOR_SUCCESS;
+
+  *out_len = 0;
+  if ((!ctx) || (!ctx->ready))
+    return ROTOR_ERR_PARAM;
+  ctx->ready = 0;
+  if (ctx->encrypt) {
+    if ((!ctx->stream) && (ctx->seen != ctx->total))
+      rc = ROTOR_ERR_LENGTH;
+    else if (ctx->buf_len)
+      rc = rotor_ctx_encrypt_block(ctx, ctx->buf, ctx->buf_len, out, out_len);
+    memset(tail, 0, sizeof(tail));
+    for (xx=0; xx<8; xx++) // streamed: little endian length
+      tail[xx] = (uint8_t)(ctx->seen >> (8*xx));
+    n = *out_len;
+    out += n;
+    if ((rc == ROTOR_SUCCESS) && (ctx->mode == ROTOR_MODE_EXT)) { // closing block, empty unless streamed
+      ROTOR_PROBE1(ntru_encrypt_start, (int64_t)ctx->block_count);
+      if (ntru_encrypt((ctx->stream) ? tail : ctx->stream_final, (ctx->stream) ? 8 : 0,
+		       &ctx->kr->pub, &EES1087EP2, &ctx->rand_ctx, out) != NTRU_SUCCESS)
+	rc = ROTOR_ERR_NTRU;
+      ROTOR_PROBE2(ntru_encrypt_done, (int64_t)ctx->block_count, rc);
+      s20_crypt(ctx->salsa_key, S20_KEYLEN_256, ctx->salsa_nonce, 0, out, NTRU_ENCLEN);
+      *out_len += NTRU_ENCLEN;
+    } else if ((rc == ROTOR_SUCCESS) && (ctx->stream)) {
+      memcpy(out, tail, ROTOR_BLOCK);
+      s20_crypt(ctx->salsa_key, S20_KEYLEN_256, ctx->salsa_nonce, 0, out, ROTOR_BLOCK);
+      *out_len += ROTOR_BLOCK;
+    }
+    if ((rc == ROTOR_SUCCESS) && (ctx->flags & ROTOR_FLAG_MAC)) { // the closing block is covered too
+      Skein_512_Update(&ctx->mac, out, *out_len - n);
+      Skein_512_Final(&ctx->mac, out + *out_len - n);
+      *out_len += ROTOR_MAC_LEN;
+    }
+    if ((rc == ROTOR_SUCCESS) && ((rc = rotor_ctx_index_feed(ctx, out, *out_len - n)) == ROTOR_SUCCESS) &&
+	(ctx->flags & ROTOR_FLAG_INDEX))
+      rc = rotor_ctx_index_close(ctx);
+  } else {
+    // the tag is shorter than a block, so it is still sitting in buf
+    tag_len = (ctx->flags & ROTOR_FLAG_MAC) ? ROTOR_MAC_LEN : 0;
+    if ((ctx->buf_len != tag_len) || ((!ctx->stream) && (ctx->block_count != rotor_ctx_segments(ctx))) ||
+	((ctx->stream) && (ctx->block_count == 0)))
+      rc = ROTOR_ERR_LENGTH; // the closing --ext block decrypts to nothing but has to be there
+    else if (tag_len)
+      rc = rotor_ctx_check_mac(ctx);
+    if ((rc == ROTOR_SUCCESS) && (ctx->stream) && (!ctx->verify))
+      rc = rotor_ctx_stream_end(ctx, out, out_len);
+  }
+  rotor_ctx_burn(ctx);
+  burn(&ctx->idx_key, sizeof(ctx->idx_key));
+  return rc;
+}
+
+int rotor_ctx_decrypt_mem(rotor_ctx *ctx, const uint8_t *in, size_t in_len, uint8_t *out, size_t *out_len) {
+  const uint8_t *body;
+  uint64_t body_len, covered;
+  size_t hlen, idx_len, n;
+  int rc;
+
+  *out_len = 0;
+  if ((!ctx) || (!in) || (!out))
+    return ROTOR_ERR_PARAM;
+  if ((in_len < ROTOR_HEADER_PROBE) || (in_len < (hlen = rotor_ctx_header_len(in))))
+    return ROTOR_ERR_FORMAT;
+  if ((rc = rotor_ctx_decrypt_init(ctx, in)))
+    return rc;
+  body = in + hlen;
+  body_len = in_len - hlen;
+  if (ctx->flags & ROTOR_FLAG_INDEX) { // only checked for its length, rotor_ctx_index_init checks the rest
+    if ((body_len < ROTOR_IDX_FOOT) ||
+	((idx_len = rotor_ctx_index_len(ctx, body + body_len - ROTOR_IDX_FOOT, &covered)) == 0) ||
+	(covered + idx_len != body_len))
+      rc = ROTOR_ERR_LENGTH;
+    body_len = covered;
+  }
+  // a size the header doesn't agree with is refused before any of it is
+  // decrypted, which matters most for --ext's NTRU per block
+  if ((rc == ROTOR_SUCCESS) && (!ctx->stream) && (body_len != rotor_ctx_body_len(ctx)))
+    rc = ROTOR_ERR_LENGTH;
+  if (rc) {
+    ctx->ready = 0;
+    rotor_ctx_burn(ctx);
+    burn(&ctx->idx_key, sizeof(ctx->idx_key));
+    return rc;
+  }
+  if ((rc = rotor_ctx_update(ctx, body, body_len, out, out_len))) {
+    rotor_ctx_final(ctx, out + *out_len, &n); // just to burn it
+    return rc;
+  }
+  rc = rotor_ctx_final(ctx, out + *out_len, &n);
+  *out_len += n;
+  return rc;
+}
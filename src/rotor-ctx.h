@@ -0,0 +1,262 @@
+/*
+ *rotor
+ *Copyright (c) 2016, adouble42/mrn@sdf
+ *All rights reserved.
+ *
+ *Redistribution and use in source and binary forms, with or without
+ *modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ *THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __ROTOR_CTX_H
+#define __ROTOR_CTX_H
+
+// librotor: the rotor file formats over caller buffers. the context is
+// allocated once by rotor_ctx_new, every init/update/final after that works
+// in the context and the caller's buffers only, so a long running service
+// can push any number of messages through one context without allocating.
+//
+// ROTOR_MODE_SYM is the default format: NTRU header, Salsa20^SHAKE body.
+// ROTOR_MODE_EXT is --ext: every 170 byte block NTRU encrypted, the header
+// ("keyblock") is kept apart from the body.
+
+#define ROTOR_MODE_SYM 0
+#define ROTOR_MODE_EXT 1
+
+// new files get a v2 header (see rotor.h), v1 files are still read.
+// streamed files don't know their length up front: the header has
+// ROTOR_V2_STREAM set and the length follows the last block in a closing
+// length block, so nothing needs stat() or seek
+
+#define ROTOR_LEN_STREAM ((uint64_t)-1)   // total_len for rotor_ctx_encrypt_init
+
+// header flags for what the caller did to the plaintext before it got
+// here. librotor only records them, see rotor_ctx_set_flags. the exception
+// is ROTOR_FLAG_MAC: the ciphertext, header included, gets a Skein-512-MAC
+// under a key derived from the two header secrets. encrypt appends the
+// ROTOR_MAC_LEN byte tag after the last block, decrypt checks it in
+// rotor_ctx_final, so output handed out before that is unauthenticated
+// until final says ROTOR_SUCCESS. the v2 header goes into every key, and a
+// v2 file without the flag is refused with ROTOR_ERR_NOMAC unless the
+// caller asked for it with rotor_ctx_allow_unauth: clearing the flag and
+// cutting off the tag would otherwise leave a file open to bit flipping
+
+#define ROTOR_FLAG_BZIP2 ROTOR_V2_BZIP2
+#define ROTOR_FLAG_FRAMES ROTOR_V2_FRAMES
+#define ROTOR_FLAG_MAC ROTOR_V2_MAC
+
+// ROTOR_FLAG_INDEX: everything after the header, blocks and MAC trailer,
+// is also cut into segments of ROTOR_IDX_SEG bytes rounded down to whole
+// blocks, each with its own Skein-512-256 tag under a second derived key.
+// the tags and a footer (segment count, blocks per segment, bytes covered,
+// and a tag over the header, the tags and those three) make the index, which
+// rotor_ctx_index hands out after final for the caller to put behind
+// everything else. any segment can then be checked on its own, on any
+// thread, without decrypting or reading the rest. the tags are the one
+// thing the context allocates after rotor_ctx_new, 32 bytes per segment
+
+#define ROTOR_FLAG_INDEX ROTOR_V2_INDEX
+
+#define ROTOR_SUCCESS 0
+#define ROTOR_ERR_PARAM 1    // bad argument or call order
+#define ROTOR_ERR_PRNG 2     // NTRU rng failed
+#define ROTOR_ERR_NTRU 3     // NTRU encrypt or decrypt failed
+#define ROTOR_ERR_LENGTH 4   // more or less data than the header says
+#define ROTOR_ERR_FORMAT 5   // not a rotor header
+#define ROTOR_ERR_COMPRESS 6 // compressed plaintext is corrupt
+#define ROTOR_ERR_MAC 7      // ciphertext or header was altered
+#define ROTOR_ERR_MEMORY 8   // no room for the index
+#define ROTOR_ERR_NOMAC 9    // file has no MAC, see rotor_ctx_allow_unauth
+
+#define ROTOR_BLOCK 170                                          // plaintext per block
+#define ROTOR_HEADER_LEN (ROTOR_V2_LEN + 2*NTRU_ENCLEN)                 // written, and the most read
+#define ROTOR_HEADER_PROBE 8                                              // enough to tell v1 from v2
+#define ROTOR_MAC_LEN 64                                          // Skein-512-MAC tag
+#define ROTOR_FINAL_MAX (2*NTRU_ENCLEN + ROTOR_MAC_LEN)          // rotor_ctx_final output
+#define ROTOR_IDX_SEG (1024*1024)                                 // segment size, rounded down to blocks
+#define ROTOR_IDX_TAG 32                                          // Skein-512-256 tag per segment
+#define ROTOR_IDX_FOOT (8 + 4 + 8 + ROTOR_IDX_TAG)                // last bytes of the index
+
+typedef struct rotor_ctx rotor_ctx;
+
+/*
+ * librotor functions
+ *
+ * rotor_ctx_new: context for mode, using the caller's key pair. only pub is
+ * needed to encrypt. kr must stay valid while the context is in use
+ *
+ */
+
+rotor_ctx *rotor_ctx_new(NtruEncKeyPair *kr, int mode);
+
+/*
+ * rotor_ctx_free: burn and free a context
+ */
+
+void rotor_ctx_free(rotor_ctx *ctx);
+
+/*
+ * rotor_ctx_encrypt_init: start encrypting total_len bytes, the
+ * ROTOR_HEADER_LEN byte header goes to head. total_len ROTOR_LEN_STREAM
+ * writes the streamed format
+ */
+
+int rotor_ctx_encrypt_init(rotor_ctx *ctx, uint64_t total_len, uint8_t *head);
+
+/*
+ * rotor_ctx_set_flags: ROTOR_FLAG_ bits for the next rotor_ctx_encrypt_init
+ * to record in the header
+ */
+
+int rotor_ctx_set_flags(rotor_ctx *ctx, uint32_t flags);
+
+/*
+ * rotor_ctx_allow_unauth: with allow nonzero, decrypt v2 files that have no
+ * ROTOR_FLAG_MAC instead of refusing them. nothing then tells an intact
+ * file from an altered one
+ */
+
+int rotor_ctx_allow_unauth(rotor_ctx *ctx, int allow);
+
+/*
+ * rotor_ctx_flags: ROTOR_FLAG_ bits of the header after init
+ */
+
+uint32_t rotor_ctx_flags(const rotor_ctx *ctx);
+
+/*
+ * rotor_ctx_header_len: full length of the header starting with the
+ * ROTOR_HEADER_PROBE bytes at head
+ */
+
+size_t rotor_ctx_header_len(const uint8_t *head);
+
+/*
+ * rotor_ctx_decrypt_init: start decrypting, from the rotor_ctx_header_len
+ * byte header. either format, the header says which. ROTOR_ERR_NOMAC for
+ * a v2 header without ROTOR_FLAG_MAC, see rotor_ctx_allow_unauth
+ */
+
+int rotor_ctx_decrypt_init(rotor_ctx *ctx, const uint8_t *head);
+
+/*
+ * rotor_ctx_verify_init: like rotor_ctx_decrypt_init, but the body is only
+ * run through the MAC: rotor_ctx_update writes nothing and rotor_ctx_final
+ * says whether the file is intact. ROTOR_ERR_NOMAC for a file without
+ * ROTOR_FLAG_MAC
+ */
+
+int rotor_ctx_verify_init(rotor_ctx *ctx, const uint8_t *head);
+
+/*
+ * rotor_ctx_decrypt_mem: decrypt a whole file held in memory, the header
+ * followed by the body (for --ext the keyblock, then the file) and the
+ * index if there is one. a body whose length disagrees with the header is
+ * refused before any of it is decrypted. out must hold in_len bytes and
+ * gets the plaintext, which is only to be trusted on ROTOR_SUCCESS
+ */
+
+int rotor_ctx_decrypt_mem(rotor_ctx *ctx, const uint8_t *in, size_t in_len, uint8_t *out, size_t *out_len);
+
+/*
+ * rotor_ctx_body_len: ciphertext bytes the header says follow it after
+ * init, blocks and MAC tag but not the index. ROTOR_LEN_STREAM if streamed
+ */
+
+uint64_t rotor_ctx_body_len(const rotor_ctx *ctx);
+
+/*
+ * rotor_ctx_index: the index of the file just finished, for an encrypt ctx
+ * with ROTOR_FLAG_INDEX after a successful rotor_ctx_final, else NULL.
+ * valid until the next init
+ */
+
+const uint8_t *rotor_ctx_index(const rotor_ctx *ctx, size_t *len);
+
+/*
+ * rotor_ctx_index_len: length of the index ending in the ROTOR_IDX_FOOT
+ * bytes at foot, 0 if it can't be one. *body_len gets the bytes it covers,
+ * which end where the index starts
+ */
+
+size_t rotor_ctx_index_len(const rotor_ctx *ctx, const uint8_t *foot, uint64_t *body_len);
+
+/*
+ * rotor_ctx_index_init: like rotor_ctx_verify_init, but with the index
+ * instead of the whole body: checks the index belongs to the header, after
+ * which rotor_ctx_verify_segment takes segments in any order. update and
+ * final are off. ROTOR_ERR_FORMAT without ROTOR_FLAG_INDEX, ROTOR_ERR_MAC if
+ * the index was altered. straight after rotor_ctx_verify_init of the same
+ * head the NTRU header isn't decrypted a second time
+ */
+
+int rotor_ctx_index_init(rotor_ctx *ctx, const uint8_t *head, const uint8_t *index, size_t index_len);
+
+/*
+ * rotor_ctx_index_info: segment count and ciphertext bytes per segment
+ * after rotor_ctx_index_init. the last segment may be shorter, body_len is
+ * all of them
+ */
+
+void rotor_ctx_index_info(const rotor_ctx *ctx, uint64_t *count, size_t *seg_len, uint64_t *body_len);
+
+/*
+ * rotor_ctx_verify_segment: check segment seg, the len bytes of ciphertext
+ * at body offset seg * seg_len. only reads ctx, so threads can share one.
+ * a read of body bytes [a, b) needs segments a / seg_len to (b-1) / seg_len
+ */
+
+int rotor_ctx_verify_segment(const rotor_ctx *ctx, uint64_t seg, const uint8_t *in, size_t len);
+
+/*
+ * rotor_ctx_update: feed in_len bytes, out gets what's complete. out must
+ * hold rotor_ctx_out_max(ctx, in_len) bytes, *out_len is set to the amount
+ * written
+ */
+
+int rotor_ctx_update(rotor_ctx *ctx, const uint8_t *in, size_t in_len, uint8_t *out, size_t *out_len);
+
+/*
+ * rotor_ctx_final: flush the last block(s), out must hold ROTOR_FINAL_MAX.
+ * the context can be initialized again afterwards
+ */
+
+int rotor_ctx_final(rotor_ctx *ctx, uint8_t *out, size_t *out_len);
+
+/*
+ * rotor_ctx_out_max: output bound for the next rotor_ctx_update of in_len
+ */
+
+size_t rotor_ctx_out_max(const rotor_ctx *ctx, size_t in_len);
+
+/*
+ * rotor_ctx_info: plaintext size (ROTOR_LEN_STREAM if only known at the
+ * end) and number of body blocks after init
+ */
+
+void rotor_ctx_info(const rotor_ctx *ctx, uint64_t *size, uint64_t *segments);
+
+/*
+ * rotor_ctx_strerror: message for a ROTOR_ERR_ code
+ */
+
+const char *rotor_ctx_strerror(int err);
+
+#endif
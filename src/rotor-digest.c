@@ -0,0 +1,194 @@
+/*****************************************************************************
+ * (c) 2016 BSD 2 clause adouble42/mrn@sdf                                   *
+ * rotor - "If knowledge can create problems, it is not through ignorance    *
+ * that we can solve them." -- isaac asimov                                  *
+ *                                                                           *
+ * rotor-digest.c - parallel Skein-512 tree hash of whole files              *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "skein/skein_tree.h"
+#include "rotor-digest.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+static int rotor_digest_threads() {
+#ifdef _OPENMP
+  return omp_in_parallel() ? 1 : omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+/*
+ * rotor_digest_pread: all of len at off, or nonzero
+ */
+
+static int rotor_digest_pread(int fd, uint8_t *buf, size_t len, uint64_t off) {
+  ssize_t n;
+
+  while (len > 0) {
+    n = pread(fd, buf, len, off);
+    if (n <= 0)
+      return 1;
+    buf += n;
+    len -= n;
+    off += n;
+  }
+  return 0;
+}
+
+/*
+ * rotor_digest_spans: run len bytes, from in or else read from fd, through
+ * tree. each round a thread takes a span, hashes its leaves into res, then
+ * the results are added in order. bufs holds threads spans when reading
+ */
+
+static int rotor_digest_spans(Skein_512_Tree_Ctxt_t *tree, const uint8_t *in, int fd, uint64_t len,
+			      size_t span, int threads, uint8_t *bufs, uint8_t *res) {
+  size_t leaf_bytes = Skein_512_Tree_Leaf_Bytes(tree);
+  size_t per = span / leaf_bytes;
+  uint64_t off, at;
+  size_t got, i, k;
+  int t, n, fail = 0;
+
+  for (off = 0; off < len; off += (uint64_t)n * span) {
+    n = ((len - off + span - 1) / span < (uint64_t)threads) ? (len - off + span - 1) / span : threads;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(n) reduction(|:fail) private(at, got, i, k) if(n > 1)
+#endif
+    for (t=0; t<n; t++) {
+      const uint8_t *src;
+
+      at = off + (uint64_t)t * span;
+      got = (len - at < span) ? len - at : span;
+      src = in ? in + at : bufs + (size_t)t * span;
+      if ((!in) && (rotor_digest_pread(fd, bufs + (size_t)t * span, got, at))) {
+	fail |= 1;
+	continue;
+      }
+      for (i=0; i*leaf_bytes < got; i++) {
+	k = (got - i*leaf_bytes < leaf_bytes) ? got - i*leaf_bytes : leaf_bytes;
+	Skein_512_Tree_Leaf(tree, src + i*leaf_bytes, k, at + i*leaf_bytes, res + (t*per + i) * ROTOR_DIGEST_LEN);
+      }
+    }
+    if (fail)
+      return 1;
+    for (t=0; t<n; t++) {
+      at = off + (uint64_t)t * span;
+      got = (len - at < span) ? len - at : span;
+      for (i=0; i*leaf_bytes < got; i++) {
+	k = (got - i*leaf_bytes < leaf_bytes) ? got - i*leaf_bytes : leaf_bytes;
+	Skein_512_Tree_Add(tree, res + (t*per + i) * ROTOR_DIGEST_LEN, k);
+      }
+    }
+  }
+  return 0;
+}
+
+/*
+ * rotor_digest_init: set up tree, *span is ROTOR_DIGEST_SPAN or a leaf if
+ * that's bigger
+ */
+
+static int rotor_digest_init(Skein_512_Tree_Ctxt_t *tree, int leaf, int fanout, size_t *span) {
+  if ((leaf < 1) || (leaf > ROTOR_DIGEST_MAX_PARAM) || (fanout < 1) || (fanout > ROTOR_DIGEST_MAX_PARAM))
+    return 1;
+  if (Skein_512_Tree_Init(tree, 8*ROTOR_DIGEST_LEN, leaf, fanout, 0xFF, NULL, 0) != SKEIN_SUCCESS)
+    return 1;
+  *span = ROTOR_DIGEST_SPAN;
+  if (*span < Skein_512_Tree_Leaf_Bytes(tree))
+    *span = Skein_512_Tree_Leaf_Bytes(tree);
+  return 0;
+}
+
+int rotor_digest_mem(const uint8_t *in, uint64_t len, int leaf, int fanout, int threads, uint8_t *digest) {
+  Skein_512_Tree_Ctxt_t tree;
+  uint8_t *res;
+  size_t span;
+  int rc;
+
+  if (rotor_digest_init(&tree, leaf, fanout, &span) || (threads < 1))
+    return 1;
+  res = malloc((size_t)threads * (span / Skein_512_Tree_Leaf_Bytes(&tree)) * ROTOR_DIGEST_LEN);
+  if (!res)
+    return 1;
+  rc = rotor_digest_spans(&tree, in, -1, len, span, threads, NULL, res);
+  if (rc == 0)
+    Skein_512_Tree_Final(&tree, digest);
+  free(res);
+  return rc;
+}
+
+int rotor_digest_file(const char *fn, int leaf, int fanout, uint8_t *digest, uint64_t *len) {
+  Skein_512_Tree_Ctxt_t tree;
+  uint8_t *bufs, *res;
+  struct stat st;
+  size_t span;
+  int fd, threads, rc;
+
+  if (rotor_digest_init(&tree, leaf, fanout, &span)) {
+    printf("rotor_digest_file: leaf and fanout go from 1 to %i\n", ROTOR_DIGEST_MAX_PARAM);
+    return 1;
+  }
+  fd = open(fn, O_RDONLY);
+  if ((fd < 0) || (fstat(fd, &st) != 0) || (!S_ISREG(st.st_mode))) {
+    printf("rotor_digest_file: can't read %s\n", fn);
+    if (fd >= 0)
+      close(fd);
+    return 1;
+  }
+  *len = st.st_size;
+  threads = rotor_digest_threads();
+  if ((uint64_t)threads > (*len + span - 1) / span)
+    threads = (*len + span - 1) / span;
+  if (threads < 1)
+    threads = 1;
+  bufs = malloc((size_t)threads * span);
+  res = malloc((size_t)threads * (span / Skein_512_Tree_Leaf_Bytes(&tree)) * ROTOR_DIGEST_LEN);
+  if ((!bufs) || (!res)) {
+    printf("rotor_digest_file: out of memory\n");
+    rc = 1;
+  } else {
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    rc = rotor_digest_spans(&tree, NULL, fd, *len, span, threads, bufs, res);
+    if (rc)
+      printf("rotor_digest_file: read error on %s\n", fn);
+    else
+      Skein_512_Tree_Final(&tree, digest);
+  }
+  free(bufs);
+  free(res);
+  close(fd);
+  return rc;
+}
+
+int rotor_digest_show(const char *fn, int leaf, int fanout) {
+  uint8_t digest[ROTOR_DIGEST_LEN];
+  struct timespec t0, t1;
+  uint64_t len;
+  double secs;
+  int i;
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  if (rotor_digest_file(fn, leaf, fanout, digest, &len))
+    return 1;
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+  printf("skein512-tree-%i-%i ", leaf, fanout);
+  for (i=0; i<ROTOR_DIGEST_LEN; i++)
+    printf("%02x", digest[i]);
+  printf("  %s\n", fn);
+  printf("%llu bytes in %.3fs, %i core(s), %.2f MB/s\n", (unsigned long long)len, secs,
+	 rotor_digest_threads(), (secs > 0) ? len / secs / 1e6 : 0);
+  return 0;
+}
@@ -0,0 +1,69 @@
+/*
+ *rotor
+ *Copyright (c) 2016, adouble42/mrn@sdf
+ *All rights reserved.
+ *
+ *Redistribution and use in source and binary forms, with or without
+ *modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ *THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __ROTOR_DIGEST_H
+#define __ROTOR_DIGEST_H
+
+#include <stdint.h>
+
+// --digest: Skein-512 tree hash of a whole file. leaves of
+// 2^leaf Skein blocks are hashed on every core at once, the nodes above
+// them (2^fanout children each, no height limit) are cheap and built in
+// order as leaf results come in. the result is the standard Skein tree
+// hash for those parameters, so it only compares to digests made with the
+// same leaf and fanout
+
+#define ROTOR_DIGEST_LEN 64                  // Skein-512-512
+#define ROTOR_DIGEST_LEAF 10                 // log2 blocks, 64 KiB leaves
+#define ROTOR_DIGEST_FANOUT 4                // log2 children per node
+#define ROTOR_DIGEST_SPAN (4*1024*1024)      // read and hashed by a thread at a time
+#define ROTOR_DIGEST_MAX_PARAM 16            // leaf and fanout, log2
+
+/*
+ * rotor_digest_mem: tree hash len bytes of in on up to threads threads.
+ * nonzero on bad parameters
+ */
+
+int rotor_digest_mem(const uint8_t *in, uint64_t len, int leaf, int fanout, int threads, uint8_t *digest);
+
+/*
+ * rotor_digest_file: same for the file fn, read with one pread per thread
+ * and span, one thread per core. *len gets the file size. nonzero on
+ * error, with a message
+ */
+
+int rotor_digest_file(const char *fn, int leaf, int fanout, uint8_t *digest, uint64_t *len);
+
+/*
+ * rotor_digest_show: print the digest of fn and how fast it went, for
+ * --digest. nonzero on error
+ */
+
+int rotor_digest_show(const char *fn, int leaf, int fanout);
+
+#endif
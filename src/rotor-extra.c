@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include "rotor.h"
 #include "rotor-extra.h"
+#include "rotor-digest.h"
 #include "ntru.h"
 
 void rotor_show_ntru_params() {
@@ -38,15 +39,53 @@ void rotor_show_help() {
   printf("--show-params:dump some NTRU parameter specs\n\n");
   printf("--keygen:     generate public and private keys\n");
   printf("              if no file names specified, use NTRUPrivate.key and NTRUPublic.key in current directory. will overwrite! be careful!\n\n");
+  printf("--keygen-batch: generate the given number of key pairs in parallel from one\n");
+  printf("              passphrase, written as <privkey>.NNNN and <pubkey>.NNNN\n");
+  printf("--keygen-pubs: public keys per private key in a batch, default 1\n");
+  printf("--passfile:   read the batch passphrase from a file instead of prompting\n\n");
   printf("--infile:     specify file to operate on\n");
   printf("--privkey:    specify name of private key, default NTRUPrivate.key\n");
   printf("--pubkey:     specify name of public key, default NTRUPublic.key\n");
+  printf("--keycache:   keep imported public keys in this cache file, shared between\n");
+  printf("              runs. an entry is only used while the key file is unchanged\n");
+  printf("--rom:        mix a pre-initialized yescrypt ROM file (hugetlbfs) into the\n");
+  printf("              passphrase KDF. keys made with a ROM only unlock with that ROM\n");
+  printf("--rom-shm:    same, using the SysV shm ROM set up by --rom-init or initrom\n");
+  printf("--rom-init:   build a ROM of the given size in MiB, for --rom <file> or\n");
+  printf("              --rom-shm. run once at boot\n");
   printf("--ext:        encrypt entire file with NTRU public key encryption with internal\n");
   printf("              SHAKE-256, external Salsa20 streams\n");
   printf("              header portion with symkeys is saved separately\n");
   printf("              default is to encrypt header with NTRU and body with\n");
   printf("              Salsa20^SHAKE256 stream\n");
+  printf("--stream:     filter stdin to stdout with --enc or --dec, e.g.\n");
+  printf("              tar c dir | rotor --stream --enc | ssh ... . uses the streamed\n");
+  printf("              format, which carries its length at the end. the passphrase is\n");
+  printf("              read from --passfile or the terminal\n");
+  printf("--keyfile:    NTRU header file for --stream --ext\n");
+  printf("--compress:   bzip2 the plaintext before encrypting. fewer blocks to\n");
+  printf("              encrypt, a lot fewer NTRU operations with --ext. --dec\n");
+  printf("              decompresses on its own\n");
+  printf("--batch:      --enc or --dec every file named after it, key unlocked once\n");
+  printf("              and files spread over one worker per core (OMP_NUM_THREADS).\n");
+  printf("              x becomes x.enc and back, per file timing is printed\n");
+  printf("--manifest:   batch over the files listed in this file, one per line\n");
+  printf("--recursive:  batch over every file under this directory, .enc files\n");
+  printf("              for --dec\n");
   printf("--enc:        encrypt file specified by --infile\n");
   printf("--dec:        decrypt file specified by --infile\n");
+  printf("--verify:     check the MAC of the file given by --infile without\n");
+  printf("              decrypting it. --dec checks it too, and deletes the\n");
+  printf("              output if it fails. files with a segment index (--enc\n");
+  printf("              to a file) are checked a segment per core, and the\n");
+  printf("              offset of the first bad segment is printed\n");
+  printf("--digest:     Skein-512 tree hash of the file given by --infile, on\n");
+  printf("              every core. no keys needed\n");
+  printf("--digest-leaf: log2 of the Skein blocks per leaf, default %i (64 KiB)\n", ROTOR_DIGEST_LEAF);
+  printf("--digest-fanout: log2 of the children per tree node, default %i\n", ROTOR_DIGEST_FANOUT);
+  printf("              digests only match with the same leaf and fanout\n");
+  printf("--stats:      time spent per stage (KDF, NTRU, Salsa20, SHAKE, MAC, I/O)\n");
+  printf("              and bytes and blocks done, to stderr at exit\n");
+  printf("--stats-json: the same as one line of JSON\n");
   printf("\nthis is experimental software!!! you have been warned\n");
 }
@@ -0,0 +1,184 @@
+/*****************************************************************************
+ * (c) 2016 BSD 2 clause adouble42/mrn@sdf                                   *
+ * rotor - "If knowledge can create problems, it is not through ignorance    *
+ * that we can solve them." -- isaac asimov                                  *
+ *                                                                           *
+ * rotor-hex.c - hex armor encode/decode for key files                       *
+ *****************************************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rotor-hex.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+static const char hex_digits[] = "0123456789abcdef";
+
+/* nibble value of a hex digit, or 0xff */
+static uint8_t hex_value(uint8_t c) {
+  if ((c >= '0') && (c <= '9')) return c - '0';
+  c |= 0x20;
+  if ((c >= 'a') && (c <= 'f')) return c - 'a' + 10;
+  return 0xff;
+}
+
+#ifdef __SSE2__
+/* 16 nibbles to their digits: '0' + n, plus 39 more for a-f */
+static inline __m128i hex_digits_sse2(__m128i n) {
+  __m128i over = _mm_cmpgt_epi8(n, _mm_set1_epi8(9));
+  return _mm_add_epi8(_mm_add_epi8(n, _mm_set1_epi8('0')),
+		      _mm_and_si128(over, _mm_set1_epi8('a' - '0' - 10)));
+}
+
+/* 16 digits to nibbles, bad lanes are set in *bad */
+static inline __m128i hex_values_sse2(__m128i c, __m128i *bad) {
+  __m128i d = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+  __m128i is_d = _mm_and_si128(_mm_cmpgt_epi8(d, _mm_set1_epi8(-1)),
+			       _mm_cmplt_epi8(d, _mm_set1_epi8(10)));
+  __m128i l = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+  __m128i is_l = _mm_and_si128(_mm_cmpgt_epi8(l, _mm_set1_epi8(-1)),
+			       _mm_cmplt_epi8(l, _mm_set1_epi8(6)));
+  *bad = _mm_or_si128(*bad, _mm_andnot_si128(_mm_or_si128(is_d, is_l), _mm_set1_epi8(-1)));
+  return _mm_or_si128(_mm_and_si128(is_d, d),
+		      _mm_and_si128(is_l, _mm_add_epi8(l, _mm_set1_epi8(10))));
+}
+#endif
+
+#ifdef __AVX2__
+static inline __m256i hex_digits_avx2(__m256i n) {
+  __m256i over = _mm256_cmpgt_epi8(n, _mm256_set1_epi8(9));
+  return _mm256_add_epi8(_mm256_add_epi8(n, _mm256_set1_epi8('0')),
+			 _mm256_and_si256(over, _mm256_set1_epi8('a' - '0' - 10)));
+}
+#endif
+
+/*
+ * hex_encode: len bytes to 2*len digits, no wrapping
+ */
+
+static void hex_encode(const uint8_t *in, size_t len, char *out) {
+  size_t i = 0;
+
+#ifdef __AVX2__
+  for (; i + 32 <= len; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(in + i));
+    __m256i hi = hex_digits_avx2(_mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0f)));
+    __m256i lo = hex_digits_avx2(_mm256_and_si256(v, _mm256_set1_epi8(0x0f)));
+    __m256i a = _mm256_unpacklo_epi8(hi, lo); // bytes 0-7 | 16-23
+    __m256i b = _mm256_unpackhi_epi8(hi, lo); // bytes 8-15 | 24-31
+    _mm256_storeu_si256((__m256i *)(out + 2*i), _mm256_permute2x128_si256(a, b, 0x20));
+    _mm256_storeu_si256((__m256i *)(out + 2*i + 32), _mm256_permute2x128_si256(a, b, 0x31));
+  }
+#endif
+#ifdef __SSE2__
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+    __m128i hi = hex_digits_sse2(_mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0f)));
+    __m128i lo = hex_digits_sse2(_mm_and_si128(v, _mm_set1_epi8(0x0f)));
+    _mm_storeu_si128((__m128i *)(out + 2*i), _mm_unpacklo_epi8(hi, lo));
+    _mm_storeu_si128((__m128i *)(out + 2*i + 16), _mm_unpackhi_epi8(hi, lo));
+  }
+#endif
+  for (; i < len; i++) {
+    out[2*i] = hex_digits[in[i] >> 4];
+    out[2*i+1] = hex_digits[in[i] & 0x0f];
+  }
+}
+
+/*
+ * hex_decode: 2*len digits to len bytes. returns 0, or -1 on a bad digit
+ */
+
+static int hex_decode(const char *in, size_t len, uint8_t *out) {
+  size_t i = 0;
+  uint8_t hi, lo, bad = 0;
+
+#ifdef __SSE2__
+  __m128i vbad = _mm_setzero_si128();
+  for (; i + 16 <= len; i += 16) {
+    __m128i a = hex_values_sse2(_mm_loadu_si128((const __m128i *)(in + 2*i)), &vbad);
+    __m128i b = hex_values_sse2(_mm_loadu_si128((const __m128i *)(in + 2*i + 16)), &vbad);
+    // each 16 bit lane holds (lo << 8) | hi, fold to (hi << 4) | lo
+    a = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(a, _mm_set1_epi16(0x00ff)), 4), _mm_srli_epi16(a, 8));
+    b = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(b, _mm_set1_epi16(0x00ff)), 4), _mm_srli_epi16(b, 8));
+    _mm_storeu_si128((__m128i *)(out + i), _mm_packus_epi16(a, b));
+  }
+  if (_mm_movemask_epi8(vbad))
+    return -1;
+#endif
+  for (; i < len; i++) {
+    hi = hex_value(in[2*i]);
+    lo = hex_value(in[2*i+1]);
+    bad |= (hi | lo) & 0xf0;
+    out[i] = (hi << 4) | (lo & 0x0f);
+  }
+  return bad ? -1 : 0;
+}
+
+size_t rotor_hex_armor_len(size_t len) {
+  return (2*len) + ((2*len) / ROTOR_HEX_WRAP) + 1;
+}
+
+size_t rotor_hex_armor(const uint8_t *in, size_t len, char *out) {
+  char *p = out;
+  size_t n;
+
+  while (len) { // one line per pass, ROTOR_HEX_WRAP digits
+    n = (len < ROTOR_HEX_WRAP/2) ? len : ROTOR_HEX_WRAP/2;
+    hex_encode(in, n, p);
+    p += 2*n;
+    in += n;
+    len -= n;
+    if (n == ROTOR_HEX_WRAP/2)
+      *p++ = '\n';
+  }
+  *p++ = '\n';
+  return p - out;
+}
+
+long rotor_hex_dearmor(const char *in, size_t in_len, uint8_t *out, size_t out_len) {
+  const char *end = in + in_len;
+  const char *eol;
+  size_t want = out_len;
+  size_t n;
+  uint8_t hi, lo;
+
+  while (want) {
+    while ((in < end) && ((*in == '\n') || (*in == '\r')))
+      in++;
+    if (in >= end)
+      return -1;
+    eol = memchr(in, '\n', end - in);
+    if (!eol)
+      eol = end;
+    if (eol[-1] == '\r')
+      eol--;
+    n = (eol - in) / 2;
+    if (n > want)
+      n = want;
+    if (hex_decode(in, n, out))
+      return -1;
+    in += 2*n;
+    out += n;
+    want -= n;
+    if (want && (in < eol)) { // one digit left, byte split by a line break
+      hi = hex_value(*in++);
+      while ((in < end) && ((*in == '\n') || (*in == '\r')))
+	in++;
+      if (in >= end)
+	return -1;
+      lo = hex_value(*in++);
+      if ((hi | lo) & 0xf0)
+	return -1;
+      *out++ = (hi << 4) | lo;
+      want--;
+    }
+  }
+  return out_len;
+}
@@ -0,0 +1,59 @@
+/*
+ *rotor
+ *Copyright (c) 2016, adouble42/mrn@sdf
+ *All rights reserved.
+ *
+ *Redistribution and use in source and binary forms, with or without
+ *modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ *THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __ROTOR_HEX_H
+#define __ROTOR_HEX_H
+
+// armored keys are lowercase hex, wrapped every ROTOR_HEX_WRAP characters
+
+#define ROTOR_HEX_WRAP 72
+
+/*
+ * rotor hex armor functions
+ *
+ * rotor_hex_armor_len: bytes rotor_hex_armor writes for len bytes of input
+ *
+ */
+
+size_t rotor_hex_armor_len(size_t len);
+
+/*
+ * rotor_hex_armor: hex encode len bytes into out, a newline after every
+ * ROTOR_HEX_WRAP characters and one at the end. returns bytes written
+ */
+
+size_t rotor_hex_armor(const uint8_t *in, size_t len, char *out);
+
+/*
+ * rotor_hex_dearmor: decode out_len bytes from in_len characters of armor,
+ * skipping line breaks. anything after the last needed digit is ignored.
+ * returns out_len, or -1 on a bad digit or short input
+ */
+
+long rotor_hex_dearmor(const char *in, size_t in_len, uint8_t *out, size_t out_len);
+
+#endif
@@ -0,0 +1,200 @@
+/*****************************************************************************
+ * (c) 2016 BSD 2 clause adouble42/mrn@sdf                                   *
+ * rotor - "If knowledge can create problems, it is not through ignorance    *
+ * that we can solve them." -- isaac asimov                                  *
+ *                                                                           *
+ * rotor-keycache.c - cache of imported public keys                          *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ntru.h"
+#include "yescrypt.h"
+#include "rotor.h"
+#include "rotor-keys.h"
+#include "rotor-keycache.h"
+
+struct keycache_entry {
+  uint64_t dev;
+  uint64_t ino;
+  uint64_t size;
+  int64_t mtime_sec;
+  int64_t mtime_nsec;
+  uint32_t used;
+  uint32_t pad;
+  NtruEncPubKey pub;
+};
+
+struct keycache_head {
+  char magic[8];
+  uint32_t entry_size; // refuse files written by a build with another layout
+  uint32_t slots;
+  uint64_t hits;
+  uint64_t misses;
+};
+
+static struct keycache_entry kc_local[ROTOR_KEYCACHE_SLOTS];
+static uint64_t kc_hits, kc_misses;
+static struct keycache_head *kc_shared = NULL;
+static size_t kc_shared_len;
+static int kc_fd = -1;
+
+/*
+ * keycache_fill: cache key for a stat()ed key file
+ */
+
+static void keycache_fill(struct keycache_entry *k, const struct stat *st) {
+  memset(k, 0, sizeof(struct keycache_entry));
+  k->dev = st->st_dev;
+  k->ino = st->st_ino;
+  k->size = st->st_size;
+#ifdef __APPLE__
+  k->mtime_sec = st->st_mtimespec.tv_sec;
+  k->mtime_nsec = st->st_mtimespec.tv_nsec;
+#else
+  k->mtime_sec = st->st_mtim.tv_sec;
+  k->mtime_nsec = st->st_mtim.tv_nsec;
+#endif
+  k->used = 1;
+}
+
+static int keycache_match(const struct keycache_entry *a, const struct keycache_entry *b) {
+  return a->used && (a->dev == b->dev) && (a->ino == b->ino) && (a->size == b->size) &&
+    (a->mtime_sec == b->mtime_sec) && (a->mtime_nsec == b->mtime_nsec);
+}
+
+static uint32_t keycache_slot(const struct keycache_entry *k, uint32_t slots) {
+  uint64_t h = (k->ino * 0x9e3779b97f4a7c15ULL) ^ k->dev;
+  return (uint32_t)((h ^ (h >> 29)) % slots);
+}
+
+int rotor_keycache_open(const char *cachefile) {
+  struct keycache_head head;
+  struct stat st;
+  int fd;
+
+  if (kc_shared)
+    return 0;
+  kc_shared_len = sizeof(struct keycache_head) + ROTOR_KEYCACHE_FILE_SLOTS * sizeof(struct keycache_entry);
+  fd = open(cachefile, O_RDWR|O_CREAT|O_EXCL, S_IRUSR|S_IWUSR);
+  if (fd >= 0) { // new cache, header goes in before anyone else can map it
+    flock(fd, LOCK_EX);
+    memset(&head, 0, sizeof(head));
+    memcpy(head.magic, ROTOR_KEYCACHE_MAGIC, sizeof(head.magic));
+    head.entry_size = sizeof(struct keycache_entry);
+    head.slots = ROTOR_KEYCACHE_FILE_SLOTS;
+    if (ftruncate(fd, kc_shared_len) || (pwrite(fd, &head, sizeof(head), 0) != sizeof(head))) {
+      perror("rotor_keycache_open");
+      close(fd);
+      unlink(cachefile);
+      return -1;
+    }
+    flock(fd, LOCK_UN);
+  } else {
+    fd = open(cachefile, O_RDWR);
+    if (fd < 0) {
+      perror("rotor_keycache_open");
+      return -1;
+    }
+  }
+  // cached keys are trusted as is, so nobody else may be able to plant one
+  if (fstat(fd, &st) || (st.st_uid != geteuid()) || (st.st_mode & (S_IWGRP|S_IWOTH)) ||
+      (st.st_size != kc_shared_len)) {
+    printf("rotor_keycache_open: refusing %s (owner, mode or size)\n", cachefile);
+    close(fd);
+    return -1;
+  }
+  kc_shared = mmap(NULL, kc_shared_len, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+  if (kc_shared == MAP_FAILED) {
+    perror("rotor_keycache_open");
+    kc_shared = NULL;
+    close(fd);
+    return -1;
+  }
+  flock(fd, LOCK_SH);
+  if (memcmp(kc_shared->magic, ROTOR_KEYCACHE_MAGIC, sizeof(kc_shared->magic)) ||
+      (kc_shared->entry_size != sizeof(struct keycache_entry)) ||
+      (kc_shared->slots != ROTOR_KEYCACHE_FILE_SLOTS)) {
+    flock(fd, LOCK_UN);
+    printf("rotor_keycache_open: %s is not a rotor key cache\n", cachefile);
+    munmap(kc_shared, kc_shared_len);
+    kc_shared = NULL;
+    close(fd);
+    return -1;
+  }
+  flock(fd, LOCK_UN);
+  kc_fd = fd;
+  return 0;
+}
+
+void rotor_keycache_close() {
+  if (!kc_shared)
+    return;
+  munmap(kc_shared, kc_shared_len);
+  close(kc_fd);
+  kc_shared = NULL;
+  kc_fd = -1;
+}
+
+int rotor_keycache_load_pub(char *infile, NtruEncPubKey *pub) {
+  struct keycache_entry want;
+  struct keycache_entry *slot, *shared_slots = NULL;
+  struct stat st;
+  int hit = 0;
+
+  if (stat(infile, &st)) { // let the importer report it
+    *pub = rotor_load_armorpub(infile);
+    return 0;
+  }
+  keycache_fill(&want, &st);
+  slot = &kc_local[keycache_slot(&want, ROTOR_KEYCACHE_SLOTS)];
+  if (keycache_match(slot, &want)) {
+    *pub = slot->pub;
+    kc_hits++;
+    return 1;
+  }
+  if (kc_shared) {
+    shared_slots = (struct keycache_entry *)(kc_shared + 1);
+    flock(kc_fd, LOCK_EX);
+    if (keycache_match(&shared_slots[keycache_slot(&want, ROTOR_KEYCACHE_FILE_SLOTS)], &want)) {
+      want.pub = shared_slots[keycache_slot(&want, ROTOR_KEYCACHE_FILE_SLOTS)].pub;
+      kc_shared->hits++;
+      hit = 1;
+    } else {
+      kc_shared->misses++;
+    }
+    flock(kc_fd, LOCK_UN);
+  }
+  if (!hit) {
+    want.pub = rotor_load_armorpub(infile);
+    kc_misses++;
+    if (kc_shared) {
+      flock(kc_fd, LOCK_EX);
+      shared_slots[keycache_slot(&want, ROTOR_KEYCACHE_FILE_SLOTS)] = want;
+      flock(kc_fd, LOCK_UN);
+    }
+  } else {
+    kc_hits++;
+  }
+  *slot = want;
+  *pub = want.pub;
+  return hit;
+}
+
+void rotor_keycache_stats(uint64_t *hits, uint64_t *misses, uint64_t *shared_hits, uint64_t *shared_misses) {
+  *hits = kc_hits;
+  *misses = kc_misses;
+  *shared_hits = *shared_misses = 0;
+  if (kc_shared) {
+    flock(kc_fd, LOCK_SH);
+    *shared_hits = kc_shared->hits;
+    *shared_misses = kc_shared->misses;
+    flock(kc_fd, LOCK_UN);
+  }
+}
@@ -0,0 +1,70 @@
+/*
+ *rotor
+ *Copyright (c) 2016, adouble42/mrn@sdf
+ *All rights reserved.
+ *
+ *Redistribution and use in source and binary forms, with or without
+ *modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ *THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __ROTOR_KEYCACHE_H
+#define __ROTOR_KEYCACHE_H
+
+// imported public keys, keyed by the key file's (dev, inode, mtime, size).
+// a changed or replaced key file never matches a stale entry
+
+#define ROTOR_KEYCACHE_SLOTS 16        // in-process
+#define ROTOR_KEYCACHE_FILE_SLOTS 256  // shared cache file
+#define ROTOR_KEYCACHE_MAGIC "ROTORKC1"
+
+/*
+ * rotor key cache functions
+ *
+ * rotor_keycache_open: also use the shared, mmapped cache file cachefile,
+ * creating it (mode 0600) if needed. a file not owned by us or writable by
+ * others is refused. returns 0 on success, -1 if only the in-process cache
+ * is available
+ *
+ */
+
+int rotor_keycache_open(const char *cachefile);
+
+/*
+ * rotor_keycache_close: unmap the shared cache file, if any
+ */
+
+void rotor_keycache_close();
+
+/*
+ * rotor_keycache_load_pub: rotor_load_armorpub through the cache.
+ * returns 1 on a cache hit, 0 on a miss (key imported and cached)
+ */
+
+int rotor_keycache_load_pub(char *infile, NtruEncPubKey *pub);
+
+/*
+ * rotor_keycache_stats: hit/miss counters for this process, and for
+ * everyone using the shared file if one is open (else set to 0)
+ */
+
+void rotor_keycache_stats(uint64_t *hits, uint64_t *misses, uint64_t *shared_hits, uint64_t *shared_misses);
+
+#endif
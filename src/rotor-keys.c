@@ -12,6 +12,8 @@
 #include <unistd.h>
 #include <string.h>
 #include <termios.h>
+#include <time.h>
+#include <sys/resource.h>
 #include "ntru.h"
 #include "shake.h"
 #include "yescrypt.h"
@@ -19,93 +21,18 @@
 #include "blake512.h"
 #include "rotor.h"
 #include "rotor-keys.h"
+#include "rotor-hex.h"
+#include "rotor-stats.h"
+#include "rotor-probe.h"
 #include "progressbar.h"
 
 #ifdef __ROTOR_MLOCK
 #include <sys/mman.h>
 #endif
 
-char const *strip="\r\n"; // strip newlines from armored keys
-
-int zstring_search_chr(const char *token,char s){
-    if (!token || s=='\0')
-        return 0;
-
-    for (;*token; token++)
-        if (*token == s)
-            return 1;
-
-    return 0;
-}
-
-char *zstring_remove_chr(char *str,const char *bad) {
-    char *src = str , *dst = str;
-    while(*src)
-        if(zstring_search_chr(bad,*src))
-            src++;
-        else
-            *dst++ = *src++;  /* assign first, then incement */
-
-    *dst='\0';
-        return str;
-}
-
-/* utility function to convert hex character representation to their 
- * nibble (4 bit) values
- */
-static uint8_t
-nibbleFromChar(char c)
-{
-  if(c >= '0' && c <= '9') return c - '0';
-  if(c >= 'a' && c <= 'f') return c - 'a' + 10;
-  if(c >= 'A' && c <= 'F') return c - 'A' + 10;
-  return 255;
-}
-
-/* Convert a string of characters representing a hex buffer into a 
- * series of bytes of that real value
- */
-void
-hexStringToBytes(char *inhex, uint8_t *arr, int keysize)
-{
-  if (!arr) arr = (uint8_t *)malloc(keysize*sizeof(uint8_t));
-  uint8_t *retval;
-  uint8_t *p;
-  int len, i;
-
-  len = strlen(inhex) / 2;
-  for(i=0, p = (uint8_t *) inhex; i<len; i++) {
-    arr[i] = (nibbleFromChar(*p) << 4) | nibbleFromChar(*(p+1));
-    p += 2;
-  }
-}
-
-static char byteMap[] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' };
-static int byteMapLen = sizeof(byteMap);
-
-/* Utility function to convert nibbles (4 bit values) into a hex 
-character representation */
-static char
-nibbleToChar(uint8_t nibble)
-{
-  if(nibble < byteMapLen) return byteMap[nibble];
-  return '*';
-}
-
-char
-*bytesToHexString(uint8_t *bytes, size_t buflen)
-{
-  char *retval;
-  int i,count,sz;
-
-  retval = malloc(buflen*2 + 1);
-  for(i=0; i<buflen; i++) {
-    retval[(i)*2] = nibbleToChar(bytes[i] >> 4);
-    retval[(i)*2+1] = nibbleToChar(bytes[i] & 0x0f);
-  }
-  retval[i*2+1] = '\0';
-  return retval;
-}
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 /*
  * rotor key management functions
@@ -143,29 +70,161 @@ struct NtruEncKeyPair rotor_keypair_generate() {
 }
 
 /*
- * rotor_exp_armorpriv: export encrypted, armored rotor private key
+ * yescrypt RAM region kept across unlocks, see rotor_kdf_pool_init
  */
 
-void rotor_exp_armorpriv(uint8_t *priv_keyx, char *secret, int s_len, char *outfile) {
+static yescrypt_local_t kdf_pool;
+static int kdf_pool_ready = 0;
+static unsigned long kdf_unlocks = 0;
+static long kdf_minflt = 0;
+static long kdf_majflt = 0;
+
+/*
+ * rotor_kdf_pool_init: reserve, prefault and optionally mlock the yescrypt
+ * RAM region once, so that every later unlock reuses it without faulting
+ *
+ */
+
+int rotor_kdf_pool_init(int lock) {
+  size_t need;
+  int flags = YESCRYPT_LOCAL_PREFAULT;
+
+  if (kdf_pool_ready)
+    return 0;
+  need = yescrypt_local_size(KDF_YESCRYPT_N, KDF_YESCRYPT_R, KDF_YESCRYPT_P, KDF_YESCRYPT_G, YESCRYPT_RW);
+  if (!need)
+    return -1;
+  if (lock)
+    flags |= YESCRYPT_LOCAL_MLOCK;
+  yescrypt_init_local(&kdf_pool);
+  if (yescrypt_reserve_local(&kdf_pool, need, flags) != 0) {
+    if (!lock || yescrypt_reserve_local(&kdf_pool, need, YESCRYPT_LOCAL_PREFAULT) != 0) {
+      perror("rotor_kdf_pool_init");
+      return -1;
+    }
+    printf("KDF region could not be locked, using it unlocked\n");
+  }
+  printf("KDF region of %.2f MiB reserved%s\n", kdf_pool.base_size / (1024.0*1024.0),
+	 (kdf_pool.base_size > need) ? " in huge pages" : "");
+  kdf_pool_ready = 1;
+  return 0;
+}
+
+/*
+ * rotor_kdf_pool_release: unmap the region, report faults per unlock
+ */
+
+void rotor_kdf_pool_release() {
+  if (!kdf_pool_ready)
+    return;
+  if (kdf_unlocks)
+    printf("KDF: %lu unlock(s), %.1f minor / %.1f major page faults per unlock\n", kdf_unlocks,
+	   (double)kdf_minflt / kdf_unlocks, (double)kdf_majflt / kdf_unlocks);
+  yescrypt_free_local(&kdf_pool);
+  kdf_pool_ready = 0;
+}
+
+/*
+ * rotor_kdf_unlock: yescrypt stage of the passphrase KDF, 64 byte dk out
+ * rom is an attached yescrypt ROM or NULL
+ */
+
+int rotor_kdf_unlock(const yescrypt_shared_t *rom, const uint8_t *secret, size_t s_len, uint8_t *dk) {
+  yescrypt_local_t locald;
+  yescrypt_local_t *local = &kdf_pool;
+  struct rusage ru_start, ru_end;
+  const char *salt = KDF_SALT;
+  double t0;
+  int ret;
+
+  if (!kdf_pool_ready) {
+    yescrypt_init_local(&locald);
+    local = &locald;
+  }
+  printf("modified yescrypt KDF initialized\n");
+  printf("current yescrypt parameters: %i/%i/%i/%i/%i/RW/64%s\n", KDF_YESCRYPT_N, KDF_YESCRYPT_R,
+	 KDF_YESCRYPT_P, KDF_YESCRYPT_T, KDF_YESCRYPT_G, rom ? " + ROM" : "");
+  printf("instead of just a couple rounds of PBKDF, we do a few hundred.\nthis gets you in the front door.\n");
+  printf("enhanced with BLAKE 256 - https://131002.net/blake/\n");
+  getrusage(RUSAGE_SELF, &ru_start);
+  t0 = rotor_stats_now();
+  ROTOR_PROBE3(kdf_start, s_len, KDF_YESCRYPT_N, KDF_YESCRYPT_R);
+  ret = yescrypt_kdf(rom, local, secret, s_len, (uint8_t *) salt, strlen (salt),
+		     KDF_YESCRYPT_N, KDF_YESCRYPT_R, KDF_YESCRYPT_P, KDF_YESCRYPT_T, KDF_YESCRYPT_G,
+		     YESCRYPT_RW, dk, 64);
+  ROTOR_PROBE1(kdf_done, ret);
+  rotor_stats_time(ROTOR_STAT_KDF_YESCRYPT, t0);
+  getrusage(RUSAGE_SELF, &ru_end);
+  if (local == &locald)
+    yescrypt_free_local(&locald);
+  kdf_unlocks++;
+  kdf_minflt += ru_end.ru_minflt - ru_start.ru_minflt;
+  kdf_majflt += ru_end.ru_majflt - ru_start.ru_majflt;
+  printf("page faults during KDF: %ld minor, %ld major\n", ru_end.ru_minflt - ru_start.ru_minflt,
+	 ru_end.ru_majflt - ru_start.ru_majflt);
+  if (ret != 0) { // dk is garbage now, don't go deriving keys from it
+    _passwdqc_memzero(dk, 64);
+    perror("rotor_kdf_unlock: yescrypt KDF failed");
+    if (rom)
+      printf("rotor_kdf_unlock: ROM must be initialized with r=%i\n", KDF_YESCRYPT_R);
+  }
+  return ret;
+}
+
+/*
+ * rotor_armor_write: tag line, wrapped hex and a dash line, one write
+ */
+
+static int rotor_armor_write(const char *tag, const uint8_t *key, size_t len, char *outfile) {
+  char *armored_key;
+  size_t tlen, n;
+  FILE *Out=NULL;
+
+  tlen = strlen(tag);
+  armored_key = (char *)malloc((2*tlen) + 2 + rotor_hex_armor_len(len));
+  if (!armored_key)
+    return -1;
+  memcpy(armored_key, tag, tlen);
+  n = tlen;
+  armored_key[n++] = '\n';
+  n += rotor_hex_armor(key, len, armored_key + n);
+  memset(armored_key + n, '-', tlen);
+  n += tlen;
+  armored_key[n++] = '\n';
+  Out=fopen(outfile,"wb");
+  if(Out!=NULL)
+  {
+    if (fwrite(armored_key, 1, n, Out) != n)
+      n = 0;
+    if (fclose(Out))
+      n = 0;
+  }
+  burn(armored_key, n);
+  free(armored_key);
+  return ((Out != NULL) && n) ? 0 : -1;
+}
+
+/*
+ * rotor_armor_stream: derive the NTRU_PRIVLEN byte stream a private key is
+ * xored with from the 170 byte post-KDF secret
+ */
+
+void rotor_armor_stream(char *secret, int s_len, uint8_t *stream) {
   uint8_t shk_outp[NTRU_PRIVLEN];
   uint8_t shk_finalp[NTRU_PRIVLEN];
-  char header_privline[PRIVATE_TLEN];
-  char armored_key[NTRU_PRIVLEN*2];
-  FILE *Out=NULL;
-  int i, x, progress;
+  double t0;
+  int i, progress;
 
 #ifdef __ROTOR_MLOCK
   mlock(&shk_outp, (sizeof(uint8_t)*NTRU_PRIVLEN));
   mlock(&shk_finalp, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&secret, sizeof(secret));
-  mlock(&priv_keyx, sizeof(priv_keyx));
 #endif
-  
-  sprintf(header_privline,"%s\n", PRIVATE_KEYTAG);
+  t0 = rotor_stats_now();
   FIPS202_SHAKE256((uint8_t *)secret, s_len, (uint8_t *)shk_outp, NTRU_PRIVLEN);
   progress = KDF_ROUNDS/100;
   progressbar *cpro = progressbar_new("deriving stream key ",100);
 
+  ROTOR_PROBE1(kdf_rounds_start, KDF_ROUNDS);
   for (i=0; i<KDF_ROUNDS; i++) { // put the lime in the coconut
     if (i == progress) {
       progressbar_inc(cpro);
@@ -174,126 +233,168 @@ void rotor_exp_armorpriv(uint8_t *priv_keyx, char *secret, int s_len, char *outf
     FIPS202_SHAKE256(shk_outp, NTRU_PRIVLEN, (uint8_t *)shk_finalp, NTRU_PRIVLEN);
     FIPS202_SHAKE256(shk_finalp, NTRU_PRIVLEN, (uint8_t *)shk_outp, NTRU_PRIVLEN);
   }
+  ROTOR_PROBE1(kdf_rounds_done, KDF_ROUNDS);
   progressbar_inc(cpro);
   progressbar_finish(cpro);
-  Out=fopen(outfile,"wb");
-  if(Out!=NULL)
-  {
-    fwrite(header_privline,sizeof(char),sizeof(header_privline),Out);
-    int xl;
-    FIPS202_SHAKE256(shk_outp, NTRU_PRIVLEN, (uint8_t *)shk_finalp, NTRU_PRIVLEN);
-    for (xl=0;xl<NTRU_PRIVLEN;xl++) {
-      shk_outp[xl] = priv_keyx[xl] ^ shk_finalp[xl];
-    }
-    strncpy (armored_key, bytesToHexString(shk_outp,NTRU_PRIVLEN), (NTRU_PRIVLEN*2));
-    x=0;
-    for (i=0;i<(NTRU_PRIVLEN*2);i++) {
-      x++;
-      fwrite(&armored_key[i],1,1,Out);
-      if (x==72) {
-	fwrite("\n",1,1,Out);
-	x=0;
-      }
-    }
+  FIPS202_SHAKE256(shk_outp, NTRU_PRIVLEN, stream, NTRU_PRIVLEN);
+  rotor_stats_time(ROTOR_STAT_KDF_SHAKE, t0);
   burn(&shk_outp, (sizeof(uint8_t)*NTRU_PRIVLEN));
   burn(&shk_finalp, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  burn(&secret, sizeof(secret));
-  burn(&priv_keyx, sizeof(priv_keyx));
-    
 #ifdef __ROTOR_MLOCK
   munlock(&shk_outp, (sizeof(uint8_t)*NTRU_PRIVLEN));
   munlock(&shk_finalp, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  munlock(&secret, sizeof(secret));
-  munlock(&priv_keyx, sizeof(priv_keyx));
 #endif
-    fwrite("\n",1,1,Out);
-    for (i=0;i<((sizeof(header_privline))-1);i++) {
-      fwrite("-",1,1,Out);
-    }
-    fwrite("\n",1,1,Out);
-    fclose(Out);
+}
+
+/*
+ * rotor_armor_salt_stream: SHAKE256 the armor stream and salt into the
+ * stream one key is xored with
+ */
+
+void rotor_armor_salt_stream(const uint8_t *stream, const uint8_t *salt, uint8_t *key_stream) {
+  uint8_t shk_in[NTRU_PRIVLEN+ROTOR_ARMOR_SALT];
+
+#ifdef __ROTOR_MLOCK
+  mlock(&shk_in, sizeof(shk_in));
+#endif
+  memcpy(shk_in, stream, NTRU_PRIVLEN);
+  memcpy(shk_in + NTRU_PRIVLEN, salt, ROTOR_ARMOR_SALT);
+  FIPS202_SHAKE256(shk_in, sizeof(shk_in), key_stream, NTRU_PRIVLEN);
+  burn(&shk_in, sizeof(shk_in));
+#ifdef __ROTOR_MLOCK
+  munlock(&shk_in, sizeof(shk_in));
+#endif
+}
+
+/*
+ * rotor_exp_armorpriv_stream: export private key under an already derived
+ * armor stream, salted if salt isn't NULL
+ */
+
+void rotor_exp_armorpriv_stream(uint8_t *priv_keyx, const uint8_t *stream, const uint8_t *salt, char *outfile) {
+  uint8_t shk_outp[NTRU_PRIVLEN+ROTOR_ARMOR_SALT];
+  size_t len = NTRU_PRIVLEN;
+  int i;
+
+#ifdef __ROTOR_MLOCK
+  mlock(&shk_outp, sizeof(shk_outp));
+#endif
+  if (salt) { // the salted stream goes in shk_outp first, then the key over it
+    rotor_armor_salt_stream(stream, salt, shk_outp);
+    memcpy(shk_outp + NTRU_PRIVLEN, salt, ROTOR_ARMOR_SALT);
+    len += ROTOR_ARMOR_SALT;
+    stream = shk_outp;
   }
+  for (i=0;i<NTRU_PRIVLEN;i++) {
+    shk_outp[i] = priv_keyx[i] ^ stream[i];
+  }
+  if (rotor_armor_write(PRIVATE_KEYTAG, shk_outp, len, outfile))
+    printf("rotor_exp_armorpriv: can't write %s\n", outfile);
+  burn(&shk_outp, sizeof(shk_outp));
+#ifdef __ROTOR_MLOCK
+  munlock(&shk_outp, sizeof(shk_outp));
+#endif
 }
 
 /*
- * rotor_exp_armorpub: export armored rotor public key
+ * rotor_dearmor_priv: dearmor a private key and xor off its stream. a
+ * batch key has its salt after the key, a single key ends at the dash line
  */
 
-void rotor_exp_armorpub(uint8_t *pub_keyx, char *outfile) {
-  char header_publine[PUBLIC_TLEN];
-  char armored_key[NTRU_PUBLEN*2];
-  int i,x;
-  FILE *Out=NULL;
+int rotor_dearmor_priv(const char *armor, size_t a_len, const uint8_t *stream, uint8_t *priv_keyx) {
+  uint8_t priv_imp[NTRU_PRIVLEN+ROTOR_ARMOR_SALT];
+  uint8_t key_stream[NTRU_PRIVLEN];
+  int i;
 
-  Out=fopen(outfile,"wb");
-  sprintf(header_publine,"%s\n", PUBLIC_KEYTAG);
-  strncpy (armored_key, bytesToHexString(pub_keyx,NTRU_PUBLEN), (NTRU_PUBLEN*2));
-  if(Out!=NULL)
-  {
-    fwrite(header_publine,sizeof(char),sizeof(header_publine),Out);
-    x=0;
-    for (i=0;i<(NTRU_PUBLEN*2);i++) {
-      x++;
-      fwrite(&armored_key[i],1,1,Out);
-      if (x==72) {
-	fwrite("\n",1,1,Out);
-	x=0;
-      }
-    }
-    fwrite("\n",1,1,Out);
-    for (i=0;i<((sizeof(header_publine))-1);i++) {
-      fwrite("-",1,1,Out);
-    }
-    fwrite("\n",1,1,Out);
-    fclose(Out);
+#ifdef __ROTOR_MLOCK
+  mlock(&priv_imp, sizeof(priv_imp));
+  mlock(&key_stream, sizeof(key_stream));
+#endif
+  if (rotor_hex_dearmor(armor, a_len, priv_imp, sizeof(priv_imp)) == sizeof(priv_imp)) {
+    rotor_armor_salt_stream(stream, priv_imp + NTRU_PRIVLEN, key_stream);
+    stream = key_stream;
+  } else if (rotor_hex_dearmor(armor, a_len, priv_imp, NTRU_PRIVLEN) != NTRU_PRIVLEN) {
+    burn(&priv_imp, sizeof(priv_imp));
+#ifdef __ROTOR_MLOCK
+    munlock(&priv_imp, sizeof(priv_imp));
+    munlock(&key_stream, sizeof(key_stream));
+#endif
+    return -1;
   }
+  for (i=0; i<NTRU_PRIVLEN; i++) {
+    priv_keyx[i] = priv_imp[i] ^ stream[i];
+  }
+  burn(&priv_imp, sizeof(priv_imp));
+  burn(&key_stream, sizeof(key_stream));
+#ifdef __ROTOR_MLOCK
+  munlock(&priv_imp, sizeof(priv_imp));
+  munlock(&key_stream, sizeof(key_stream));
+#endif
+  return 0;
+}
+
+/*
+ * rotor_exp_armorpriv: export encrypted, armored rotor private key
+ */
+
+void rotor_exp_armorpriv(uint8_t *priv_keyx, char *secret, int s_len, char *outfile) {
+  uint8_t stream[NTRU_PRIVLEN];
+
+#ifdef __ROTOR_MLOCK
+  mlock(&stream, (sizeof(uint8_t)*NTRU_PRIVLEN));
+#endif
+  rotor_armor_stream(secret, s_len, stream);
+  rotor_exp_armorpriv_stream(priv_keyx, stream, NULL, outfile);
+  burn(&stream, (sizeof(uint8_t)*NTRU_PRIVLEN));
+#ifdef __ROTOR_MLOCK
+  munlock(&stream, (sizeof(uint8_t)*NTRU_PRIVLEN));
+#endif
+}
+
+/*
+ * rotor_exp_armorpub: export armored rotor public key
+ */
+
+void rotor_exp_armorpub(uint8_t *pub_keyx, char *outfile) {
+  if (rotor_armor_write(PUBLIC_KEYTAG, pub_keyx, NTRU_PUBLEN, outfile))
+    printf("rotor_exp_armorpub: can't write %s\n", outfile);
 }
 
 /*
  * rotor_load_armorpriv: import encrypted, armored rotor private key
  */
 
-struct NtruEncPrivKey rotor_load_armorpriv(const uint8_t *secret, int s_len, char *infile) {
+struct NtruEncPrivKey rotor_load_armorpriv(const yescrypt_shared_t *rom, const uint8_t *secret, int s_len, char *infile) {
   NtruEncPrivKey kr_out;
-  yescrypt_local_t locald;
-  const char *salt = "saljy";
   uint8_t dk[64];
   uint8_t shk_outp[NTRU_PRIVLEN];
   uint8_t shk_finalp[NTRU_PRIVLEN];
-  uint8_t priv_imp[NTRU_PRIVLEN];
-  char p_buf[(sizeof(priv_imp)*2)+30];
-  char p_buf2[(sizeof(priv_imp)*2)+30];
-  char header_privline[PRIVATE_TLEN];
-  char *stripchars = "\r\n";
+  char p_buf[((NTRU_PRIVLEN+ROTOR_ARMOR_SALT)*2)+60]; // room for CRLF line ends
   FILE *In=NULL;
+  size_t p_len;
+  double t0;
   int i, progress;
 #ifdef __ROTOR_MLOCK
   mlock(&kr_out, sizeof(NtruEncPrivKey));
   mlock(&shk_outp, (sizeof(uint8_t)*NTRU_PRIVLEN));
   mlock(&shk_finalp, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&priv_imp, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&p_buf, (sizeof(char)*((sizeof(priv_imp)*2)+30)));
-  mlock(&p_buf2, (sizeof(char)*((sizeof(priv_imp)*2)+30)));
+  mlock(&p_buf, sizeof(p_buf));
   mlock(&secret, sizeof(secret));
   mlock(&dk, (sizeof(uint8_t)*64));
 #endif
-  yescrypt_init_local(&locald);
-  printf("modified yescrypt KDF initialized\n");
-  printf("current yescrypt parameters: 32/8/8/12/9/RW/64\n");
-  printf("instead of just a couple rounds of PBKDF, we do a few hundred.\nthis gets you in the front door.\n");
-  printf("enhanced with BLAKE 256 - https://131002.net/blake/\n");
-  yescrypt_kdf(NULL, &locald, secret, strlen((char *)secret), (uint8_t *) salt, strlen (salt), 32, 8, 8, 12, 9, YESCRYPT_RW, dk, 64);
-  yescrypt_free_local(&locald);
-  _passwdqc_memzero(&secret, strlen(secret)); // best way to keep a secret:
+  if (rotor_kdf_unlock(rom, secret, strlen((char *)secret), dk) != 0)
+    exit(1);
+  _passwdqc_memzero((void *)secret, s_len); // best way to keep a secret:
   printf("now for the next key derivation -SHAKE 256.\n\n");
+  t0 = rotor_stats_now();
   FIPS202_SHAKE256(dk, 64, (uint8_t *)shk_finalp, 170);
   _passwdqc_memzero(&dk, 64); // kill everyone else who knows!
   progress = KDF_ROUNDS/100;
   In=fopen(infile,"rb");
-  sprintf(header_privline,"%s\n", PRIVATE_KEYTAG);
   if (In!=NULL) {
     FIPS202_SHAKE256(shk_finalp, 170, (uint8_t *)shk_outp, NTRU_PRIVLEN);
     progressbar *cpro = progressbar_new("processing decryption key ",100);
+    ROTOR_PROBE1(kdf_rounds_start, KDF_ROUNDS);
     for (i=0; i<KDF_ROUNDS; i++) { // put the lime in the coconut
       if (i == progress) {
 	progressbar_inc(cpro);
@@ -302,31 +403,34 @@ struct NtruEncPrivKey rotor_load_armorpriv(const uint8_t *secret, int s_len, cha
       FIPS202_SHAKE256(shk_outp, NTRU_PRIVLEN, (uint8_t *)shk_finalp, NTRU_PRIVLEN);
       FIPS202_SHAKE256(shk_finalp, NTRU_PRIVLEN, (uint8_t *)shk_outp, NTRU_PRIVLEN);
     }
+    ROTOR_PROBE1(kdf_rounds_done, KDF_ROUNDS);
     _passwdqc_memzero(&shk_finalp, sizeof(shk_finalp)); // no intermediates
     progressbar_inc(cpro);
     progressbar_finish(cpro);
     FIPS202_SHAKE256(shk_outp, NTRU_PRIVLEN, (uint8_t *)shk_finalp, NTRU_PRIVLEN);
+    rotor_stats_time(ROTOR_STAT_KDF_SHAKE, t0);
     _passwdqc_memzero(&shk_outp, sizeof(shk_outp)); // get it yet?
+    t0 = rotor_stats_now();
     printf("loading encrypted private key from file\n");
-    fseek(In, sizeof(header_privline), SEEK_SET);
-    fread(p_buf, (sizeof(char)), (NTRU_PRIVLEN*2)+30, In);
-    hexStringToBytes(zstring_remove_chr(p_buf,strip), (uint8_t *)priv_imp, NTRU_PRIVLEN);
-    _passwdqc_memzero(&p_buf, sizeof(p_buf));
-    for (i=0; i<NTRU_PRIVLEN; i++) {
-      shk_outp[i] = priv_imp[i] ^ shk_finalp[i];
+    fseek(In, strlen(PRIVATE_KEYTAG), SEEK_SET);
+    p_len = fread(p_buf, (sizeof(char)), sizeof(p_buf), In);
+    if (rotor_dearmor_priv(p_buf, p_len, shk_finalp, shk_outp)) {
+      printf("rotor_load_armorpriv: %s is not an armored private key\n", infile);
+      _passwdqc_memzero(&shk_finalp, sizeof(shk_finalp));
+      _passwdqc_memzero(&p_buf, sizeof(p_buf));
+      exit(1);
     }
-    _passwdqc_memzero(&priv_imp, sizeof(priv_imp)); // yawwwwwn
+    _passwdqc_memzero(&p_buf, sizeof(p_buf)); // yawwwwwn
     _passwdqc_memzero(&shk_finalp, sizeof(shk_finalp));
     fclose(In);
     printf("key decrypted.\n");
     ntru_import_priv(shk_outp, &kr_out);
     _passwdqc_memzero(&shk_outp, sizeof(shk_outp)); // burn it with fire!!!
+    rotor_stats_time(ROTOR_STAT_KEYS, t0);
 #ifdef __ROTOR_MLOCK
   munlock(&shk_outp, (sizeof(uint8_t)*NTRU_PRIVLEN));
   munlock(&shk_finalp, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  munlock(&priv_imp, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  munlock(&p_buf, (sizeof(char)*((sizeof(priv_imp)*2)+30)));
-  munlock(&p_buf2, (sizeof(char)*((sizeof(priv_imp)*2)+30)));
+  munlock(&p_buf, sizeof(p_buf));
   munlock(&secret, sizeof(secret));
   munlock(&dk, (sizeof(uint8_t)*64));
 #endif
@@ -340,57 +444,45 @@ struct NtruEncPrivKey rotor_load_armorpriv(const uint8_t *secret, int s_len, cha
 
 struct NtruEncPubKey rotor_load_armorpub(char *infile) {
   NtruEncPubKey kp_out;
-  char p_buf[(1499*2)+60];
-  char p_buf2[(1499*2)+60];
+  char p_buf[(NTRU_PUBLEN*2)+100]; // room for CRLF line ends
   uint8_t pub_imp[NTRU_PUBLEN];
-  char header_publine[PUBLIC_TLEN];
-
-  char *stripchars = "\r\n";
   FILE *In=NULL;
+  size_t p_len;
+  double t0;
 
+  t0 = rotor_stats_now();
   In=fopen(infile, "rb");
-  sprintf(header_publine,"%s\n", PUBLIC_KEYTAG);
   if (In!=NULL) {
-    fseek(In, sizeof(header_publine), SEEK_SET);
-    fread(p_buf,(sizeof(char)), (ntru_pub_len(&EES1087EP2)*2)+60, In);
-    hexStringToBytes(zstring_remove_chr(p_buf,strip), (uint8_t *)pub_imp, ntru_pub_len(&EES1087EP2));
+    fseek(In, strlen(PUBLIC_KEYTAG), SEEK_SET);
+    p_len = fread(p_buf, (sizeof(char)), sizeof(p_buf), In);
+    if (rotor_hex_dearmor(p_buf, p_len, pub_imp, NTRU_PUBLEN) != NTRU_PUBLEN) {
+      printf("rotor_load_armorpub: %s is not an armored public key\n", infile);
+      exit(1);
+    }
     fclose(In);
     ntru_import_pub(pub_imp, &kp_out);
+    rotor_stats_time(ROTOR_STAT_KEYS, t0);
 
         return(kp_out);
   }      
 }
 
-void rotor_user_keygen(char *skname, char *pkname) {
+/*
+ * rotor_keygen_passphrase: prompt for a new passphrase until passwdqc
+ * likes it and it's confirmed. secret must hold 64 bytes
+ */
+
+static void rotor_keygen_passphrase(uint8_t *secret) {
   static struct termios oldt, newt;
-  NtruEncKeyPair kp;
-  NtruRandGen rng = NTRU_RNG_DEFAULT;
-  NtruRandContext rand_ctx;
   passwdqc_params_t params;
-  yescrypt_local_t locald;
-  uint8_t pub_arr[NTRU_PUBLEN];
-  uint8_t priv_arr[NTRU_PRIVLEN];
-  uint8_t secret[64];
   uint8_t verify[64];
-  const char *salt = "saljy";
   const char *check_reason;
-  char password_char[170];
-  uint8_t dk[64];
-  uint8_t dkt[64];
-  int i, dklen,v,ok_pass;
-  dklen=64;
+  int v, ok_pass;
   v=1;
- #ifdef __ROTOR_MLOCK
-  mlock(&kp, sizeof(NtruEncKeyPair));
-  mlock(&rng, sizeof(NtruRandGen));
-  mlock(&rand_ctx, sizeof(NtruRandContext));
-  mlock(&priv_arr, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&password_char, (sizeof(uint8_t)*NTRU_PRIVLEN));
-  mlock(&secret, (sizeof(uint8_t)*64));
+  memset(secret, 0, 64);
+#ifdef __ROTOR_MLOCK
   mlock(&verify, (sizeof(uint8_t)*64));
-  mlock(&dk, (sizeof(uint8_t)*64));
-  mlock(&dkt, (sizeof(uint8_t)*64));
-#endif 
+#endif
   tcgetattr(STDIN_FILENO, &oldt); // kill the lights
   newt=oldt;
   newt.c_lflag &= ~(ECHO);
@@ -402,7 +494,7 @@ void rotor_user_keygen(char *skname, char *pkname) {
     printf("choose a strong passphrase to protect your private key: ");
     ok_pass=0;
     if (secret) {
-      _passwdqc_memzero(&secret, strlen(secret));
+      _passwdqc_memzero(secret, strlen(secret));
     }
     fgets(secret, 64, stdin);
     check_reason = passwdqc_check(&params.qc, secret, NULL, NULL);
@@ -420,14 +512,37 @@ void rotor_user_keygen(char *skname, char *pkname) {
   } while (((v == 1) && (ok_pass == 0) && (strncmp(secret, verify, strlen(secret)))));
   _passwdqc_memzero(&verify, strlen(verify));
   tcsetattr(STDIN_FILENO, TCSANOW, &oldt); // lights on
+#ifdef __ROTOR_MLOCK
+  munlock(&verify, (sizeof(uint8_t)*64));
+#endif
+}
 
-  yescrypt_init_local(&locald);
-  printf("modified yescrypt KDF initialized\n");
-  printf("current yescrypt parameters: 32/8/8/12/9/RW/64\n");
-  printf("instead of just a couple rounds of PBKDF, we do a few hundred.\nthis gets you in the front door.\n");
-  printf("enhanced with BLAKE 256 - https://131002.net/blake/\n");
-  yescrypt_kdf(NULL, &locald, secret, strlen((char *)secret), (uint8_t *) salt, strlen (salt), 32, 8, 8, 12, 9, YESCRYPT_RW, dk, 64);
-  yescrypt_free_local(&locald);
+void rotor_user_keygen(const yescrypt_shared_t *rom, char *skname, char *pkname) {
+  NtruEncKeyPair kp;
+  NtruRandGen rng = NTRU_RNG_DEFAULT;
+  NtruRandContext rand_ctx;
+  uint8_t pub_arr[NTRU_PUBLEN];
+  uint8_t priv_arr[NTRU_PRIVLEN];
+  uint8_t secret[64];
+  char password_char[170];
+  uint8_t dk[64];
+  uint8_t dkt[64];
+  int i, dklen;
+  dklen=64;
+ #ifdef __ROTOR_MLOCK
+  mlock(&kp, sizeof(NtruEncKeyPair));
+  mlock(&rng, sizeof(NtruRandGen));
+  mlock(&rand_ctx, sizeof(NtruRandContext));
+  mlock(&priv_arr, (sizeof(uint8_t)*NTRU_PRIVLEN));
+  mlock(&password_char, (sizeof(uint8_t)*NTRU_PRIVLEN));
+  mlock(&secret, (sizeof(uint8_t)*64));
+  mlock(&dk, (sizeof(uint8_t)*64));
+  mlock(&dkt, (sizeof(uint8_t)*64));
+#endif 
+  rotor_keygen_passphrase(secret);
+
+  if (rotor_kdf_unlock(rom, secret, strlen((char *)secret), dk) != 0)
+    exit(1);
   _passwdqc_memzero(&secret, strlen(secret)); // don't need this any more
   printf("now for the next key derivation -SHAKE 256.\n\n");
   FIPS202_SHAKE256(dk, 64, (uint8_t *)password_char, 170);
@@ -448,8 +563,170 @@ void rotor_user_keygen(char *skname, char *pkname) {
   munlock(&priv_arr, (sizeof(uint8_t)*NTRU_PRIVLEN));
   munlock(&password_char, (sizeof(uint8_t)*NTRU_PRIVLEN));
   munlock(&secret, (sizeof(uint8_t)*64));
-  munlock(&verify, (sizeof(uint8_t)*64));
   munlock(&dk, (sizeof(uint8_t)*64));
   munlock(&dkt, (sizeof(uint8_t)*64));
 #endif
 }
+
+/*
+ * rotor_batch_keygen: count key pairs from one passphrase, generated in
+ * parallel and written out in one pass after. each private key gets pubs
+ * public keys through ntru_gen_key_pair_multi, and a random salt so the one
+ * armor stream is never reused as the pad of two keys
+ */
+
+void rotor_batch_keygen(const yescrypt_shared_t *rom, char *skname, char *pkname, int count, int pubs, char *passfile) {
+  passwdqc_params_t params;
+  uint8_t secret[64];
+  uint8_t dk[64];
+  char password_char[170];
+  uint8_t stream[NTRU_PRIVLEN];
+  uint8_t *priv_arr, *pub_arr, *salt_arr;
+  char fname[80];
+  const char *check_reason;
+  struct timespec t_start, t_gen, t_end;
+  double gen_secs, all_secs;
+  size_t priv_size;
+  int i, j, failed = 0;
+  FILE *In=NULL;
+
+  if ((count < 1) || (pubs < 1)) {
+    printf("rotor_batch_keygen: nothing to do\n");
+    return;
+  }
+#ifdef __ROTOR_MLOCK
+  mlock(&secret, (sizeof(uint8_t)*64));
+  mlock(&dk, (sizeof(uint8_t)*64));
+  mlock(&password_char, (sizeof(char)*170));
+  mlock(&stream, (sizeof(uint8_t)*NTRU_PRIVLEN));
+#endif
+  memset(secret, 0, sizeof(secret));
+  if (passfile) { // non interactive
+    In=fopen(passfile, "rb");
+    if ((In == NULL) || (fgets(secret, 63, In) == NULL)) {
+      printf("rotor_batch_keygen: can't read passphrase from %s\n", passfile);
+      exit(1);
+    }
+    fclose(In);
+    if (secret[strlen(secret)-1] != '\n') // --dec reads it with fgets too
+      strcat(secret, "\n");
+    passwdqc_params_reset(&params);
+    check_reason = passwdqc_check(&params.qc, secret, NULL, NULL);
+    if (check_reason) {
+      printf("Bad passphrase: (%s)\n", check_reason);
+      _passwdqc_memzero(&secret, sizeof(secret));
+      exit(1);
+    }
+  } else {
+    rotor_keygen_passphrase(secret);
+  }
+
+  // one KDF and one armor stream for the whole batch, salted per key
+  if (rotor_kdf_unlock(rom, secret, strlen((char *)secret), dk) != 0)
+    exit(1);
+  _passwdqc_memzero(&secret, sizeof(secret));
+  FIPS202_SHAKE256(dk, 64, (uint8_t *)password_char, 170);
+  _passwdqc_memzero(&dk, 64);
+  rotor_armor_stream(password_char, 170, stream);
+  _passwdqc_memzero(&password_char, 170);
+
+  priv_size = (size_t)count * NTRU_PRIVLEN;
+  priv_arr = (uint8_t *)malloc(priv_size);
+  pub_arr = (uint8_t *)malloc((size_t)count * pubs * NTRU_PUBLEN);
+  salt_arr = (uint8_t *)malloc((size_t)count * ROTOR_ARMOR_SALT);
+  if ((!priv_arr) || (!pub_arr) || (!salt_arr)) {
+    printf("rotor_batch_keygen: out of memory\n");
+    exit(1);
+  }
+#ifdef __ROTOR_MLOCK
+  mlock(priv_arr, priv_size);
+#endif
+
+#ifdef _OPENMP
+  printf("generating %i key pair(s) on %i thread(s)\n", count, omp_get_max_threads());
+#else
+  printf("generating %i key pair(s)\n", count);
+#endif
+  clock_gettime(CLOCK_MONOTONIC, &t_start);
+#ifdef _OPENMP
+#pragma omp parallel default(shared) private(i, j)
+#endif
+  {
+    NtruRandGen rng = NTRU_RNG_DEFAULT;
+    NtruRandContext rand_ctx;
+    NtruEncPrivKey priv;
+    NtruEncPubKey *pub;
+    int rng_ok;
+
+    pub = (NtruEncPubKey *)malloc(pubs * sizeof(NtruEncPubKey));
+#ifdef __ROTOR_MLOCK
+    mlock(&priv, sizeof(NtruEncPrivKey));
+#endif
+#ifdef _OPENMP
+#pragma omp critical (rotor_rand_init)
+#endif
+    rng_ok = (pub != NULL) && (ntru_rand_init(&rand_ctx, &rng) == NTRU_SUCCESS);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+    for (i=0; i<count; i++) {
+      if ((!rng_ok) || (ntru_gen_key_pair_multi(&EES1087EP2, &priv, pub, &rand_ctx, pubs) != NTRU_SUCCESS) ||
+	  (ntru_rand_generate(salt_arr + (size_t)i * ROTOR_ARMOR_SALT, ROTOR_ARMOR_SALT, &rand_ctx) != NTRU_SUCCESS)) {
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+	failed++;
+	continue;
+      }
+      ntru_export_priv(&priv, priv_arr + (size_t)i * NTRU_PRIVLEN);
+      for (j=0; j<pubs; j++)
+	ntru_export_pub(&pub[j], pub_arr + ((size_t)i * pubs + j) * NTRU_PUBLEN);
+    }
+    if (rng_ok)
+      ntru_rand_release(&rand_ctx);
+    burn(&priv, sizeof(NtruEncPrivKey));
+#ifdef __ROTOR_MLOCK
+    munlock(&priv, sizeof(NtruEncPrivKey));
+#endif
+    free(pub);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t_gen);
+
+  if (failed) {
+    printf("rotor_batch_keygen: %i key pair(s) failed, nothing written\n", failed);
+  } else {
+    for (i=0; i<count; i++) {
+      snprintf(fname, sizeof(fname), "%s.%04i", skname, i);
+      rotor_exp_armorpriv_stream(priv_arr + (size_t)i * NTRU_PRIVLEN, stream,
+				 salt_arr + (size_t)i * ROTOR_ARMOR_SALT, fname);
+      for (j=0; j<pubs; j++) {
+	if (pubs == 1)
+	  snprintf(fname, sizeof(fname), "%s.%04i", pkname, i);
+	else
+	  snprintf(fname, sizeof(fname), "%s.%04i-%02i", pkname, i, j);
+	rotor_exp_armorpub(pub_arr + ((size_t)i * pubs + j) * NTRU_PUBLEN, fname);
+      }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t_end);
+    gen_secs = (t_gen.tv_sec - t_start.tv_sec) + (t_gen.tv_nsec - t_start.tv_nsec) / 1e9;
+    all_secs = (t_end.tv_sec - t_start.tv_sec) + (t_end.tv_nsec - t_start.tv_nsec) / 1e9;
+    printf("%i private / %i public key(s) written to %s.* and %s.*\n", count, count * pubs, skname, pkname);
+    printf("keygen: %.3fs, %.1f keys/s - with export: %.3fs, %.1f keys/s\n",
+	   gen_secs, count / gen_secs, all_secs, count / all_secs);
+  }
+
+  burn(priv_arr, priv_size);
+#ifdef __ROTOR_MLOCK
+  munlock(priv_arr, priv_size);
+#endif
+  free(priv_arr);
+  free(pub_arr);
+  free(salt_arr);
+  _passwdqc_memzero(&stream, NTRU_PRIVLEN);
+#ifdef __ROTOR_MLOCK
+  munlock(&secret, (sizeof(uint8_t)*64));
+  munlock(&dk, (sizeof(uint8_t)*64));
+  munlock(&password_char, (sizeof(char)*170));
+  munlock(&stream, (sizeof(uint8_t)*NTRU_PRIVLEN));
+#endif
+}
@@ -30,6 +30,20 @@
 
 #define KDF_ROUNDS 10000
 
+// yescrypt stage of the passphrase KDF: N/r/p/t/g, upgraded g times
+
+#define KDF_SALT "saljy"
+#define KDF_YESCRYPT_N 32
+#define KDF_YESCRYPT_R 8
+#define KDF_YESCRYPT_P 8
+#define KDF_YESCRYPT_T 12
+#define KDF_YESCRYPT_G 9
+
+// batch private keys carry a random salt after the key, each one is armored
+// with SHAKE256(stream | salt) so no two keys of a batch share a pad
+
+#define ROTOR_ARMOR_SALT 16
+
 /*
  * rotor key management functions
  *
@@ -39,6 +53,53 @@
 
 struct NtruEncKeyPair rotor_keypair_generate();
 
+/*
+ * rotor_kdf_pool_init: reserve the yescrypt RAM region once for all unlocks
+ * in this process, prefaulted and mlock()ed if lock is set. optional
+ */
+
+int rotor_kdf_pool_init(int lock);
+
+/*
+ * rotor_kdf_pool_release: free the region, print page faults per unlock
+ */
+
+void rotor_kdf_pool_release();
+
+/*
+ * rotor_kdf_unlock: run the yescrypt stage of the passphrase KDF, optionally
+ * against a shared ROM. returns 0 on success, dk is wiped on failure
+ */
+
+int rotor_kdf_unlock(const yescrypt_shared_t *rom, const uint8_t *secret, size_t s_len, uint8_t *dk);
+
+/*
+ * rotor_armor_stream: derive the stream private keys are armored with
+ */
+
+void rotor_armor_stream(char *secret, int s_len, uint8_t *stream);
+
+/*
+ * rotor_armor_salt_stream: per key stream from the armor stream and a
+ * ROTOR_ARMOR_SALT byte salt
+ */
+
+void rotor_armor_salt_stream(const uint8_t *stream, const uint8_t *salt, uint8_t *key_stream);
+
+/*
+ * rotor_exp_armorpriv_stream: export private key with a derived stream. with
+ * a salt the key is armored with its own salted stream and the salt stored
+ */
+
+void rotor_exp_armorpriv_stream(uint8_t *priv_keyx, const uint8_t *stream, const uint8_t *salt, char *outfile);
+
+/*
+ * rotor_dearmor_priv: decrypt an armored private key, salted or not, with
+ * the armor stream. returns 0, or -1 if it isn't an armored private key
+ */
+
+int rotor_dearmor_priv(const char *armor, size_t a_len, const uint8_t *stream, uint8_t *priv_keyx);
+
 /*
  * rotor_exp_armorpriv: export encrypted, armored rotor private key
  */
@@ -55,7 +116,7 @@ void rotor_exp_armorpub(uint8_t pub_keyx[NTRU_PUBLEN], char *outfile);
  * rotor_load_armorpriv: import encrypted, armored rotor private key
  */
 
-struct NtruEncPrivKey rotor_load_armorpriv(const uint8_t *secret, int s_len, char *infile);
+struct NtruEncPrivKey rotor_load_armorpriv(const yescrypt_shared_t *rom, const uint8_t *secret, int s_len, char *infile);
 
 /*
  * rotor_load_armorpub: import armored rotor public key
@@ -67,6 +128,13 @@ struct NtruEncPubKey rotor_load_armorpub(char *infile);
  * rotor_user_keygen: get user input and generate keypair
  */
 
-void rotor_user_keygen(char *skname, char *pkname);
+void rotor_user_keygen(const yescrypt_shared_t *rom, char *skname, char *pkname);
+
+/*
+ * rotor_batch_keygen: non interactive bulk keygen, one KDF for all keys.
+ * passphrase from passfile, or prompted once if NULL
+ */
+
+void rotor_batch_keygen(const yescrypt_shared_t *rom, char *skname, char *pkname, int count, int pubs, char *passfile);
 
 #endif
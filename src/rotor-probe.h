@@ -0,0 +1,72 @@
+/*
+ *rotor
+ *Copyright (c) 2016, adouble42/mrn@sdf
+ *All rights reserved.
+ *
+ *Redistribution and use in source and binary forms, with or without
+ *modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ *THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __ROTOR_PROBE_H
+#define __ROTOR_PROBE_H
+
+// static tracepoints, provider "rotor", for perf and bpftrace. on linux
+// with the systemtap <sys/sdt.h> around (systemtap-sdt-dev /
+// systemtap-sdt-devel) they're built in by default: a nop in the code and
+// a note in the ELF, nothing runs until a tracer attaches. the DTrace
+// <sys/sdt.h> of FreeBSD and illumos wants a dtrace -G link step instead,
+// so there, without the header, or with -D__ROTOR_NO_USDT they compile to
+// nothing. list them with
+//   bpftrace -l 'usdt:./rotor:*'  or  perf buildid-cache --add ./rotor
+// examples are in probes/
+//
+// rotor:chunk_start  (offset, len)                 a read buffer into librotor
+// rotor:chunk_done   (offset, len, out_len)
+// rotor:ntru_encrypt_start (block)                 block is -1 for the header
+// rotor:ntru_encrypt_done  (block, rc)
+// rotor:ntru_decrypt_start (block)
+// rotor:ntru_decrypt_done  (block, rc, dec_len)
+// rotor:kdf_start    (s_len, N, r)                 yescrypt stage
+// rotor:kdf_done     (rc)
+// rotor:kdf_rounds_start (rounds)                  SHAKE stage
+// rotor:kdf_rounds_done  (rounds)
+
+#if !defined(__ROTOR_NO_USDT) && defined(__linux__) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#ifdef STAP_PROBE1    // systemtap's, its probes need no extra link step
+#define __ROTOR_USDT
+#endif
+#endif
+#endif
+
+#ifdef __ROTOR_USDT
+#define ROTOR_PROBE1(name, a) STAP_PROBE1(rotor, name, a)
+#define ROTOR_PROBE2(name, a, b) STAP_PROBE2(rotor, name, a, b)
+#define ROTOR_PROBE3(name, a, b, c) STAP_PROBE3(rotor, name, a, b, c)
+#else
+#define ROTOR_PROBE1(name, a) do { } while (0)
+#define ROTOR_PROBE2(name, a, b) do { } while (0)
+#define ROTOR_PROBE3(name, a, b, c) do { } while (0)
+#endif
+
+#endif
@@ -0,0 +1,222 @@
+/*****************************************************************************
+ * (c) 2016 BSD 2 clause adouble42/mrn@sdf                                   *
+ * rotor - "If knowledge can create problems, it is not through ignorance    *
+ * that we can solve them." -- isaac asimov                                  *
+ *                                                                           *
+ * rotor-rom.c - shared yescrypt ROM for key unlock                          *
+ *****************************************************************************/
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/shm.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ntru.h"
+#include "yescrypt.h"
+#include "rotor.h"
+#include "rotor-keys.h"
+#include "rotor-rom.h"
+
+// maximum parallelism during ROM initialization, as in zefcrypt's initrom.
+// p goes into the ROM contents, so these have to match initrom for the two
+// tools to produce the same ROM
+
+#define ROTOR_ROM_PROM_SHM 32
+#define ROTOR_ROM_PROM_FILE 4
+
+/*
+ * rotor_rom_init: one time ROM setup, file or shm
+ *
+ */
+
+int rotor_rom_init(const char *romfile, uint64_t rom_mb) {
+  yescrypt_shared_t shared;
+  uint64_t rom_bytes, NROM;
+  uint8_t digest[4];
+  int rom_fd, shmid;
+
+  if (!rom_mb) {
+    printf("rotor_rom_init: wrong ROM size requested\n");
+    return -1;
+  }
+  rom_bytes = 1;
+  while ((rom_bytes << 1) <= rom_mb)
+    rom_bytes <<= 1;
+  rom_bytes *= (1024ULL*1024); // power of two, so NROM is too
+  NROM = rom_bytes / (128 * ROTOR_ROM_R);
+  printf("r=%u NROM=%llu\n", ROTOR_ROM_R, (unsigned long long)NROM);
+  printf("will use %.2f MiB ROM\n", rom_bytes / (1024.0*1024.0));
+
+  shared.aligned_size = rom_bytes;
+  if (romfile) {
+    rom_fd = open(romfile, O_CREAT|O_RDWR|O_EXCL, S_IRUSR|S_IRGRP|S_IWUSR);
+    if (rom_fd < 0) {
+      perror("open");
+      return -1;
+    }
+    if (ftruncate(rom_fd, rom_bytes)) {
+      perror("ftruncate");
+      close(rom_fd);
+      unlink(romfile);
+      return -1;
+    }
+    int flags =
+#ifdef MAP_NOCORE
+      MAP_NOCORE |
+#endif
+#ifdef MAP_HUGETLB
+      MAP_HUGETLB |
+#endif
+      MAP_SHARED;
+    void *p = mmap(NULL, rom_bytes, PROT_READ | PROT_WRITE, flags, rom_fd, 0);
+#ifdef MAP_HUGETLB
+    if (p == MAP_FAILED)
+      p = mmap(NULL, rom_bytes, PROT_READ | PROT_WRITE, flags & ~MAP_HUGETLB, rom_fd, 0);
+#endif
+    close(rom_fd);
+    if (p == MAP_FAILED) {
+      perror("mmap");
+      unlink(romfile);
+      return -1;
+    }
+    shared.base = shared.aligned = p;
+  } else {
+    shmid = shmget(ROTOR_ROM_SHM_KEY, shared.aligned_size,
+#ifdef SHM_HUGETLB
+		   SHM_HUGETLB |
+#endif
+		   IPC_CREAT|IPC_EXCL | S_IRUSR|S_IRGRP|S_IWUSR);
+#ifdef SHM_HUGETLB
+    if (shmid == -1) {
+      perror("shmget");
+      printf("retrying without SHM_HUGETLB\n");
+      shmid = shmget(ROTOR_ROM_SHM_KEY, shared.aligned_size,
+		     IPC_CREAT|IPC_EXCL | S_IRUSR|S_IRGRP|S_IWUSR);
+    }
+#endif
+    if (shmid == -1) {
+      perror("shmget");
+      return -1;
+    }
+    shared.base = shared.aligned = shmat(shmid, NULL, 0);
+    if (shared.base == (void *)-1) {
+      int save_errno = errno;
+      shmctl(shmid, IPC_RMID, NULL);
+      errno = save_errno;
+      perror("shmat");
+      return -1;
+    }
+  }
+
+  printf("initializing ROM ...");
+  fflush(stdout);
+  if (yescrypt_init_shared(&shared, (uint8_t *)ROTOR_ROM_PARAM, strlen(ROTOR_ROM_PARAM),
+			   NROM, ROTOR_ROM_R,
+			   romfile ? ROTOR_ROM_PROM_FILE : ROTOR_ROM_PROM_SHM,
+			   YESCRYPT_SHARED_PREALLOCATED, digest, sizeof(digest))) {
+    printf(" FAILED\n");
+    if (romfile) {
+      munmap(shared.base, rom_bytes);
+      unlink(romfile);
+    } else {
+      shmdt(shared.base);
+      shmctl(shmid, IPC_RMID, NULL);
+    }
+    return -1;
+  }
+  // the digest is the same on every host given the same size and param,
+  // compare it before trusting a key generated elsewhere
+  printf(" DONE (%02x%02x%02x%02x)\n", digest[0], digest[1], digest[2], digest[3]);
+  if (romfile)
+    munmap(shared.base, rom_bytes);
+  else
+    shmdt(shared.base);
+  return 0;
+}
+
+/*
+ * rotor_rom_attach: read only view of an existing ROM
+ *
+ */
+
+yescrypt_shared_t *rotor_rom_attach(const char *romfile) {
+  yescrypt_shared_t *rom;
+  struct shmid_ds ds;
+  struct stat st;
+  int rom_fd, shmid;
+
+  rom = (yescrypt_shared_t *)malloc(sizeof(yescrypt_shared_t));
+  if (!rom)
+    return NULL;
+  if (romfile) {
+    rom_fd = open(romfile, O_RDONLY);
+    if (rom_fd < 0) {
+      perror("open");
+      free(rom);
+      return NULL;
+    }
+    if (fstat(rom_fd, &st) || st.st_size <= 0) {
+      printf("rotor_rom_attach: %s is not a ROM\n", romfile);
+      close(rom_fd);
+      free(rom);
+      return NULL;
+    }
+    int flags =
+#ifdef MAP_NOCORE
+      MAP_NOCORE |
+#endif
+#ifdef MAP_HUGETLB
+      MAP_HUGETLB |
+#endif
+      MAP_SHARED;
+    void *p = mmap(NULL, st.st_size, PROT_READ, flags, rom_fd, 0);
+#ifdef MAP_HUGETLB
+    if (p == MAP_FAILED)
+      p = mmap(NULL, st.st_size, PROT_READ, flags & ~MAP_HUGETLB, rom_fd, 0);
+#endif
+    close(rom_fd);
+    if (p == MAP_FAILED) {
+      perror("mmap");
+      free(rom);
+      return NULL;
+    }
+    rom->base = rom->aligned = p;
+    rom->base_size = rom->aligned_size = st.st_size;
+  } else {
+    shmid = shmget(ROTOR_ROM_SHM_KEY, 0, 0);
+    if (shmid == -1 || shmctl(shmid, IPC_STAT, &ds)) {
+      perror("shmget");
+      free(rom);
+      return NULL;
+    }
+    rom->base = rom->aligned = shmat(shmid, NULL, SHM_RDONLY);
+    if (rom->base == (void *)-1) {
+      perror("shmat");
+      free(rom);
+      return NULL;
+    }
+    rom->base_size = 0; // marks shm for rotor_rom_detach
+    rom->aligned_size = ds.shm_segsz;
+  }
+  printf("attached %.2f MiB yescrypt ROM\n", rom->aligned_size / (1024.0*1024.0));
+  return rom;
+}
+
+/*
+ * rotor_rom_detach: drop our mapping, the ROM itself stays for the next run
+ *
+ */
+
+void rotor_rom_detach(yescrypt_shared_t *rom) {
+  if (!rom)
+    return;
+  if (rom->base_size)
+    munmap(rom->base, rom->base_size);
+  else
+    shmdt(rom->base);
+  free(rom);
+}
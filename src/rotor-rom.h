@@ -0,0 +1,63 @@
+/*
+ *rotor
+ *Copyright (c) 2016, adouble42/mrn@sdf
+ *All rights reserved.
+ *
+ *Redistribution and use in source and binary forms, with or without
+ *modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ *THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __ROTOR_ROM_H
+#define __ROTOR_ROM_H
+
+// same SysV key and local parameter as zefcrypt's initrom/userom, so a ROM
+// set up at boot by either tool can be attached by rotor. rotor's KDF runs
+// with r=8, so the ROM has to be initialized with r=8 as well - initrom does
+// that for power of two GiB sizes in shm mode, rotor --rom-init always does.
+
+#define ROTOR_ROM_SHM_KEY 0x524f4d0a
+#define ROTOR_ROM_PARAM "change this before use"
+#define ROTOR_ROM_R KDF_YESCRYPT_R
+
+/*
+ * rotor ROM functions
+ *
+ * rotor_rom_init: build a yescrypt ROM of rom_mb MiB, either in a file
+ * (hugetlbfs or plain) or in a SysV shm segment when romfile is NULL.
+ * meant to be run once at boot. returns 0 on success.
+ *
+ */
+
+int rotor_rom_init(const char *romfile, uint64_t rom_mb);
+
+/*
+ * rotor_rom_attach: map an initialized ROM read only. returns NULL on failure
+ */
+
+yescrypt_shared_t *rotor_rom_attach(const char *romfile);
+
+/*
+ * rotor_rom_detach: unmap a ROM returned by rotor_rom_attach
+ */
+
+void rotor_rom_detach(yescrypt_shared_t *rom);
+
+#endif
@@ -0,0 +1,132 @@
+/*****************************************************************************
+ * (c) 2016 BSD 2 clause adouble42/mrn@sdf                                   *
+ * rotor - "If knowledge can create problems, it is not through ignorance    *
+ * that we can solve them." -- isaac asimov                                  *
+ *                                                                           *
+ * rotor-stats.c - --stats stage timers and counters                         *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include "rotor-stats.h"
+
+int rotor_stats_on = 0;
+
+static int rotor_stats_how = 0;
+static double rotor_stats_start = 0;
+static double rotor_stats_secs[ROTOR_STAT_STAGES];
+static uint64_t rotor_stats_calls[ROTOR_STAT_STAGES];
+static uint64_t rotor_stats_counts[ROTOR_COUNTERS];
+
+static const char *rotor_stats_stage[ROTOR_STAT_STAGES] = {
+  "kdf_yescrypt", "kdf_shake", "keys", "ntru_header", "ntru_block",
+  "salsa20", "shake", "mac", "read", "write"
+};
+
+static const char *rotor_stats_counter[ROTOR_COUNTERS] = {
+  "bytes_read", "bytes_written", "blocks", "ntru_ops", "files"
+};
+
+static double rotor_stats_clock() {
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void rotor_stats_exit() {
+  rotor_stats_report(rotor_stats_how);
+}
+
+void rotor_stats_enable(int how) {
+  if (rotor_stats_on) {
+    rotor_stats_how |= how;
+    return;
+  }
+  rotor_stats_how = how;
+  rotor_stats_start = rotor_stats_clock();
+  rotor_stats_on = 1;
+  atexit(rotor_stats_exit);
+}
+
+double rotor_stats_now() {
+  if (!rotor_stats_on)
+    return 0;
+  return rotor_stats_clock();
+}
+
+void rotor_stats_time(int stage, double t0) {
+  double d;
+
+  if (!rotor_stats_on)
+    return;
+  d = rotor_stats_clock() - t0;
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+  rotor_stats_secs[stage] += d;
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+  rotor_stats_calls[stage]++;
+}
+
+void rotor_stats_count(int counter, uint64_t n) {
+  if (!rotor_stats_on)
+    return;
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+  rotor_stats_counts[counter] += n;
+}
+
+size_t rotor_stats_fread(void *buf, size_t len, FILE *f) {
+  double t0 = rotor_stats_now();
+  size_t n = fread(buf, sizeof(char), len, f);
+
+  rotor_stats_time(ROTOR_STAT_READ, t0);
+  rotor_stats_count(ROTOR_COUNT_READ, n);
+  return n;
+}
+
+size_t rotor_stats_fwrite(const void *buf, size_t len, FILE *f) {
+  double t0 = rotor_stats_now();
+  size_t n = fwrite(buf, sizeof(char), len, f);
+
+  rotor_stats_time(ROTOR_STAT_WRITE, t0);
+  rotor_stats_count(ROTOR_COUNT_WRITE, n);
+  return n;
+}
+
+void rotor_stats_report(int how) {
+  double wall = rotor_stats_clock() - rotor_stats_start;
+  int i;
+
+  // stderr, so stats never mix with --stream output
+  if (how & ROTOR_STATS_TEXT) {
+    fflush(stdout);
+    fprintf(stderr, "rotor stats: %.3fs wall\n", wall);
+    fprintf(stderr, "  %-14s %12s %10s %7s\n", "stage", "calls", "secs", "%wall");
+    for (i=0; i<ROTOR_STAT_STAGES; i++)
+      if (rotor_stats_calls[i])
+	fprintf(stderr, "  %-14s %12llu %10.3f %6.1f%%\n", rotor_stats_stage[i],
+		(unsigned long long)rotor_stats_calls[i], rotor_stats_secs[i],
+		(wall > 0) ? 100 * rotor_stats_secs[i] / wall : 0);
+    for (i=0; i<ROTOR_COUNTERS; i++)
+      fprintf(stderr, "  %-14s %12llu\n", rotor_stats_counter[i], (unsigned long long)rotor_stats_counts[i]);
+  }
+  if (how & ROTOR_STATS_JSON) {
+    fflush(stdout);
+    fprintf(stderr, "{\"rotor_stats\": {\"wall_s\": %.6f, \"stages\": {", wall);
+    for (i=0; i<ROTOR_STAT_STAGES; i++)
+      fprintf(stderr, "%s\"%s\": {\"calls\": %llu, \"secs\": %.6f}", i ? ", " : "", rotor_stats_stage[i],
+	      (unsigned long long)rotor_stats_calls[i], rotor_stats_secs[i]);
+    fprintf(stderr, "}, \"counters\": {");
+    for (i=0; i<ROTOR_COUNTERS; i++)
+      fprintf(stderr, "%s\"%s\": %llu", i ? ", " : "", rotor_stats_counter[i],
+	      (unsigned long long)rotor_stats_counts[i]);
+    fprintf(stderr, "}}}\n");
+  }
+}
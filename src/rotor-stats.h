@@ -0,0 +1,103 @@
+/*
+ *rotor
+ *Copyright (c) 2016, adouble42/mrn@sdf
+ *All rights reserved.
+ *
+ *Redistribution and use in source and binary forms, with or without
+ *modification, are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ *THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __ROTOR_STATS_H
+#define __ROTOR_STATS_H
+
+// --stats: where the time went. stages are timed with CLOCK_MONOTONIC and
+// summed, over every thread in a batch, and a few counters kept. all of it
+// is behind one flag: when it's off a timer is a load and a compare, no
+// clock is read
+
+#define ROTOR_STAT_KDF_YESCRYPT 0   // passphrase KDF, yescrypt stage
+#define ROTOR_STAT_KDF_SHAKE 1      // passphrase KDF, SHAKE rounds
+#define ROTOR_STAT_KEYS 2           // reading and importing key files
+#define ROTOR_STAT_HEADER 3         // NTRU wrap/unwrap of the header secrets
+#define ROTOR_STAT_NTRU 4           // NTRU per block, --ext
+#define ROTOR_STAT_SALSA20 5        // outer stream
+#define ROTOR_STAT_SHAKE 6          // inner stream and key chaining
+#define ROTOR_STAT_MAC 7            // Skein MAC and segment index
+#define ROTOR_STAT_READ 8           // file input
+#define ROTOR_STAT_WRITE 9          // file output
+#define ROTOR_STAT_STAGES 10
+
+#define ROTOR_COUNT_READ 0          // bytes
+#define ROTOR_COUNT_WRITE 1         // bytes
+#define ROTOR_COUNT_BLOCKS 2        // ciphertext blocks
+#define ROTOR_COUNT_NTRU 3          // NTRU operations
+#define ROTOR_COUNT_FILES 4
+#define ROTOR_COUNTERS 5
+
+#define ROTOR_STATS_TEXT 1
+#define ROTOR_STATS_JSON 2
+
+extern int rotor_stats_on;
+
+/*
+ * rotor stats functions
+ *
+ * rotor_stats_enable: start the clock, print the ROTOR_STATS_ formats in
+ * how at exit
+ *
+ */
+
+void rotor_stats_enable(int how);
+
+/*
+ * rotor_stats_now: start of a timed stage, 0 when stats are off
+ */
+
+double rotor_stats_now();
+
+/*
+ * rotor_stats_time: add the time since t0 to stage
+ */
+
+void rotor_stats_time(int stage, double t0);
+
+/*
+ * rotor_stats_count: add n to counter
+ */
+
+void rotor_stats_count(int counter, uint64_t n);
+
+/*
+ * rotor_stats_fread, rotor_stats_fwrite: fread and fwrite of bytes, timed
+ * and counted as read and write
+ */
+
+size_t rotor_stats_fread(void *buf, size_t len, FILE *f);
+size_t rotor_stats_fwrite(const void *buf, size_t len, FILE *f);
+
+/*
+ * rotor_stats_report: print what's been gathered, in the formats in how
+ */
+
+void rotor_stats_report(int how);
+
+#endif
@@ -20,6 +20,11 @@
 #include "rotor-crypt.h"
 #include "rotor-keys.h"
 #include "rotor-extra.h"
+#include "rotor-rom.h"
+#include "rotor-keycache.h"
+#include "rotor-batch.h"
+#include "rotor-digest.h"
+#include "rotor-stats.h"
 #include "shake.h"
 
 #ifdef __ROTOR_MLOCK
@@ -27,6 +32,7 @@
 #endif
 
 int main(int argc, char *argv[]) {
+  int opc;
   uint8_t plain[170];    
   char password_char[170];
   char pkname[64];
@@ -34,13 +40,51 @@ int main(int argc, char *argv[]) {
   char sfname[64];
   char ofname[64];
   char keyfname[64];
+  char romfname[64];
+  char passfname[64];
+  char cachefname[64];
+  yescrypt_shared_t *rom = NULL;
+  uint64_t romInit = 0;
+  int useRom = 0;
   int encMode = 0;
   int extMode = 0;
   int decMode = 0;
   int keyGen = 0;
+  int keyBatch = 0;
+  int keyPubs = 1;
+  int passFile = 0;
+  int keyCache = 0;
+  uint64_t kc_hits, kc_misses, kc_shits, kc_smisses;
   int show_params = 0;
   int inFile = 0;
+  int streamMode = 0;
+  int batchMode = 0;
+  int compressMode = 0;
+  int verifyMode = 0;
+  int digestMode = 0;
+  int digestLeaf = ROTOR_DIGEST_LEAF;
+  int digestFanout = ROTOR_DIGEST_FANOUT;
+  int batchFailed = 0;
+  rotor_batch batch = {NULL, 0, 0};
+  char *batchDir = ".";
+  FILE *dataOut = stdout;
+  FILE *passIn = stdin;
 
+  sfname[0] = '\0';
+  keyfname[0] = '\0';
+  for (opc = 1; opc < argc; opc++) {
+    if (strcmp(argv[opc], "--stream") == 0) {
+      // stdout carries the data, everything we say goes to stderr
+      streamMode = 1;
+      dataOut = fdopen(dup(STDOUT_FILENO), "wb");
+      dup2(STDERR_FILENO, STDOUT_FILENO);
+    }
+    // before anything else, so the KDF is on the clock too
+    if (strcmp(argv[opc], "--stats") == 0)
+      rotor_stats_enable(ROTOR_STATS_TEXT);
+    if (strcmp(argv[opc], "--stats-json") == 0)
+      rotor_stats_enable(ROTOR_STATS_JSON);
+  }
   printf("rotor - version %i.%i\n(c)2016 mrn@sdf.org\n",ROTOR_MAJOR,ROTOR_MINOR);
 #ifdef __ROTOR_MLOCK
   printf("rotor was built with use of mlock() and mlockall() enabled. sensitive data will not be swapped to disk.\n\n");
@@ -51,15 +95,16 @@ int main(int argc, char *argv[]) {
   
   strcpy (pkname, "NTRUPublic.key");
   strcpy (skname, "NTRUPrivate.key");
-  int opc;
   for (opc = 1; opc < argc; opc++) {
     if (strcmp(argv[opc], "--pubkey") == 0) {
       strncpy(pkname, argv[opc+1], 64);
       opc++;
+      continue;
     }
     if (strcmp(argv[opc], "--privkey") == 0) {
       strncpy(skname, argv[opc+1], 64);
       opc++;
+      continue;
     }
     if (strcmp(argv[opc], "--infile") == 0) {
       inFile = 1;
@@ -67,6 +112,7 @@ int main(int argc, char *argv[]) {
         strncpy(sfname, argv[opc+1], 64);
         opc++;
       }
+      continue;
     }
     if (strcmp(argv[opc], "--enc") == 0) {
       encMode = 1;
@@ -79,11 +125,120 @@ int main(int argc, char *argv[]) {
     if (strcmp(argv[opc], "--dec") == 0) {
       decMode = 1;
       strncpy(ofname, sfname, 64);
-      ofname[(strlen(sfname)-4)] = '\0';
+      if (strlen(sfname) >= 4)
+        ofname[(strlen(sfname)-4)] = '\0';
+    }
+    if (strcmp(argv[opc], "--keyfile") == 0) {
+      if (argv[opc+1]) {
+        strncpy(keyfname, argv[opc+1], 64);
+        opc++;
+      }
+      continue;
     }
     if (strcmp(argv[opc], "--keygen") == 0) {
       keyGen = 1;
     }
+    if (strcmp(argv[opc], "--keygen-batch") == 0) {
+      keyGen = 1;
+      if (argv[opc+1]) {
+        keyBatch = atoi(argv[opc+1]);
+        opc++;
+      }
+      continue;
+    }
+    if (strcmp(argv[opc], "--keygen-pubs") == 0) {
+      if (argv[opc+1]) {
+        keyPubs = atoi(argv[opc+1]);
+        opc++;
+      }
+      continue;
+    }
+    if (strcmp(argv[opc], "--passfile") == 0) {
+      passFile = 1;
+      if (argv[opc+1]) {
+        strncpy(passfname, argv[opc+1], 64);
+        opc++;
+      }
+      continue;
+    }
+    if (strcmp(argv[opc], "--keycache") == 0) {
+      keyCache = 1;
+      if (argv[opc+1]) {
+        strncpy(cachefname, argv[opc+1], 64);
+        opc++;
+      }
+      continue;
+    }
+    if (strcmp(argv[opc], "--verify") == 0) {
+      verifyMode = 1;
+      decMode = 1; // needs the private key all the same
+      continue;
+    }
+    if (strcmp(argv[opc], "--digest") == 0) {
+      digestMode = 1;
+      continue;
+    }
+    if (strcmp(argv[opc], "--digest-leaf") == 0) {
+      if (argv[opc+1]) {
+        digestLeaf = atoi(argv[opc+1]);
+        opc++;
+      }
+      continue;
+    }
+    if (strcmp(argv[opc], "--digest-fanout") == 0) {
+      if (argv[opc+1]) {
+        digestFanout = atoi(argv[opc+1]);
+        opc++;
+      }
+      continue;
+    }
+    if (strcmp(argv[opc], "--compress") == 0) {
+      compressMode = 1;
+      continue;
+    }
+    if (strcmp(argv[opc], "--batch") == 0) {
+      batchMode = 1;
+      continue;
+    }
+    if (strcmp(argv[opc], "--manifest") == 0) {
+      batchMode = 1;
+      if (argv[opc+1]) {
+	if (rotor_batch_manifest(&batch, argv[opc+1]))
+	  exit(1);
+	opc++;
+      }
+      continue;
+    }
+    if (strcmp(argv[opc], "--recursive") == 0) {
+      batchMode = 2; // walked once --dec is known
+      if (argv[opc+1]) {
+	batchDir = argv[opc+1];
+	opc++;
+      }
+      continue;
+    }
+    if ((batchMode) && (argv[opc][0] != '-')) {
+      rotor_batch_add(&batch, argv[opc]);
+      continue;
+    }
+    if (strcmp(argv[opc], "--rom") == 0) {
+      useRom = 1;
+      if (argv[opc+1]) {
+        strncpy(romfname, argv[opc+1], 64);
+        opc++;
+      }
+      continue;
+    }
+    if (strcmp(argv[opc], "--rom-shm") == 0) {
+      useRom = 2;
+    }
+    if (strcmp(argv[opc], "--rom-init") == 0) {
+      if (argv[opc+1]) {
+        romInit = strtoull(argv[opc+1], NULL, 10);
+        opc++;
+      }
+      continue;
+    }
     if (strcmp(argv[opc], "--version") == 0) {
       exit(0);
     }
@@ -96,12 +251,45 @@ int main(int argc, char *argv[]) {
       exit(0);
     }
   }
+  if (digestMode) { // no keys needed
+    if (sfname[0] == '\0') {
+      printf("--digest needs --infile\n");
+      exit(1);
+    }
+    exit(rotor_digest_show(sfname, digestLeaf, digestFanout) ? 1 : 0);
+  }
+  if (romInit) { // once at boot, then everyone attaches
+    exit(rotor_rom_init((useRom == 1) ? romfname : NULL, romInit) ? 1 : 0);
+  }
+  if ((batchMode == 2) && (rotor_batch_recurse(&batch, batchDir, decMode)))
+    exit(1);
+  if ((batchMode) && (encMode == 0) && (decMode == 0)) {
+    printf("--batch needs --enc or --dec\n");
+    exit(1);
+  }
   if (((keyGen != 1) && (opc <= 2)) || ((opc <= 3) && (inFile == 1))) {
     rotor_show_help();
     exit(0);
   }
+  if ((useRom) && ((keyGen == 1) || (decMode == 1))) {
+    rom = rotor_rom_attach((useRom == 1) ? romfname : NULL);
+    if (!rom)
+      exit(1);
+  }
+  if ((keyGen == 1) || (decMode == 1)) {
+#ifdef __ROTOR_MLOCK
+    rotor_kdf_pool_init(1);
+#else
+    rotor_kdf_pool_init(0);
+#endif
+  }
   if (keyGen == 1) {
-    rotor_user_keygen(skname, pkname);
+    if (keyBatch > 0)
+      rotor_batch_keygen(rom, skname, pkname, keyBatch, keyPubs, passFile ? passfname : NULL);
+    else
+      rotor_user_keygen(rom, skname, pkname);
+    rotor_kdf_pool_release();
+    rotor_rom_detach(rom);
     exit(0);
   }
 
@@ -117,18 +305,32 @@ int main(int argc, char *argv[]) {
     mlockall(MCL_CURRENT);
 #endif
     
-    tcgetattr(STDIN_FILENO, &oldt); // kill the lights
+    if (passFile == 1) // stdin may be the data
+      passIn = fopen(passfname, "rb");
+    else if (streamMode == 1)
+      passIn = fopen("/dev/tty", "r");
+    if (passIn == NULL) {
+      printf("can't open %s to read the passphrase\n", (passFile == 1) ? passfname : "/dev/tty");
+      exit(1);
+    }
+    tcgetattr(fileno(passIn), &oldt); // kill the lights
     newt=oldt;
     newt.c_lflag &= ~(ECHO);
-    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
+    tcsetattr(fileno(passIn), TCSANOW, &newt);
     printf("enter passphrase to begin unlocking private key: ");
-    fgets(secret, 64, stdin);
+    fflush(stdout);
+    secret[0] = '\0';
+    fgets(secret, 64, passIn);
     printf("\n");
-    tcsetattr(STDIN_FILENO, TCSANOW, &oldt); // lights on
+    tcsetattr(fileno(passIn), TCSANOW, &oldt); // lights on
+    if (passIn != stdin)
+      fclose(passIn);
     
     krpr = (NtruEncPrivKey *)malloc(sizeof(NtruEncPrivKey));
-    *krpr = rotor_load_armorpriv(secret, strlen(secret), skname);
+    *krpr = rotor_load_armorpriv(rom, secret, strlen(secret), skname);
     _passwdqc_memzero(&secret, sizeof(secret)); // done with you
+    rotor_kdf_pool_release();
+    rotor_rom_detach(rom);
     kr.priv = *krpr;
     printf("private key loaded\n");
   }
@@ -136,29 +338,63 @@ int main(int argc, char *argv[]) {
   printf("importing NTRU public key from file %s\n",pkname);
 
   krpub = (NtruEncPubKey *)malloc(sizeof(NtruEncPubKey));
-  *krpub = rotor_load_armorpub(pkname);
+  if (keyCache == 1)
+    rotor_keycache_open(cachefname);
+  rotor_keycache_load_pub(pkname, krpub);
   kr.pub = *krpub;
   printf("keys imported.\n");
+  if (keyCache == 1) {
+    rotor_keycache_stats(&kc_hits, &kc_misses, &kc_shits, &kc_smisses);
+    printf("key cache: %llu hit(s), %llu miss(es) - %s: %llu hit(s), %llu miss(es)\n",
+	   (unsigned long long)kc_hits, (unsigned long long)kc_misses, cachefname,
+	   (unsigned long long)kc_shits, (unsigned long long)kc_smisses);
+    rotor_keycache_close();
+  }
  
+  if (streamMode == 1) {
+    if ((extMode == 1) && (keyfname[0] == '\0')) {
+      printf("--stream --ext needs --keyfile for the NTRU header\n");
+      exit(1);
+    }
+    if (encMode == 1)
+      rotor_encrypt_stream(&kr, extMode, stdin, dataOut, (extMode == 1) ? keyfname : NULL, compressMode);
+    if (decMode == 1)
+      rotor_decrypt_stream(&kr, extMode, stdin, dataOut, (extMode == 1) ? keyfname : NULL);
+    fclose(dataOut);
+    encMode = decMode = 0;
+  }
+  if (verifyMode == 1) {
+    if (extMode == 1) {
+      strncpy(keyfname, sfname, 64);
+      strncat(keyfname, ".key", 64);
+    }
+    batchFailed = (rotor_verify_file(&kr, extMode, sfname, keyfname) != 0);
+    encMode = decMode = 0;
+  }
+  if (batchMode) { // key is unlocked once for the lot
+    batchFailed = rotor_batch_run(&batch, &kr, extMode, decMode, compressMode);
+    rotor_batch_free(&batch);
+    encMode = decMode = 0;
+  }
   if ((encMode == 1) && (extMode == 0)) {
     printf("encrypting using NTRU header only, Salsa20-SHAKE OFB stream.\n");
-    rotor_encrypt_file_sym(kr, sfname, ofname);
+    rotor_encrypt_file_sym(&kr, sfname, ofname, compressMode);
   } 
   if ((decMode == 1) && (extMode == 0)){
     printf("decrypting using NTRU header only, Salsa20-SHAKE OFB stream.\n");
-    rotor_decrypt_file_sym(kr, sfname, ofname);
+    rotor_decrypt_file_sym(&kr, sfname, ofname);
   }
   if ((encMode == 1) && (extMode == 1)) {
     printf("encrypting using NTRU full length of file.\n");
     strncpy(keyfname, sfname, 64);
     strncat(keyfname, ".enc.key", 64);
-    rotor_encrypt_file(kr, sfname, ofname, keyfname);
+    rotor_encrypt_file(&kr, sfname, ofname, keyfname, compressMode);
   } 
   if ((decMode == 1) && (extMode == 1)){
     printf("decrypting using NTRU full length of file.\n");
     strncpy(keyfname, sfname, 64);
     strncat(keyfname, ".key", 64);
-    rotor_decrypt_file(kr, sfname, ofname, keyfname);
+    rotor_decrypt_file(&kr, sfname, ofname, keyfname);
   }
 
   _passwdqc_memzero(&kr, sizeof(kr)); // don't hold on to the past
@@ -170,4 +406,6 @@ int main(int argc, char *argv[]) {
     munlockall();
   }
   #endif
+  if (batchFailed)
+    exit(1);
 }
@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "bzlib.h"
+
+// single-thread speed of the vendored bzlib on corpora from very repetitive
+// to random, plus any files named after the size. compress is mostly
+// BZ2_blockSort, decompress the Huffman decoder and the inverse BWT. every
+// result is checked
+
+#define BENCH_SIZE (16*1024*1024)
+#define BENCH_BLOCK 900000
+
+static uint32_t bench_x;
+
+static uint32_t bench_rand(void) {
+  bench_x ^= bench_x << 13;
+  bench_x ^= bench_x >> 17;
+  bench_x ^= bench_x << 5;
+  return bench_x;
+}
+
+// the same log line over and over
+static void fill_repeat(uint8_t *buf, size_t len) {
+  const char *line = "2016-10-19 12:00:01 rotor[311]: session ok from user\n";
+  size_t i, l = strlen(line);
+
+  for (i=0; i<len; i++)
+    buf[i] = line[i % l];
+}
+
+// period 2, which the run-length pass ahead of the sort can't shorten
+static void fill_ab(uint8_t *buf, size_t len) {
+  size_t i;
+
+  for (i=0; i<len; i++)
+    buf[i] = (i & 1) ? 'b' : 'a';
+}
+
+// log lines with varying stamps and words
+static void fill_log(uint8_t *buf, size_t len) {
+  static const char *words[] = {
+    "GET", "POST", "/index.html", "/api/v1/keys", "200", "404", "rotor", "session",
+    "closed", "accepted", "from", "user", "timeout", "decrypt", "encrypt", "ok"
+  };
+  size_t i = 0;
+  uint32_t x;
+  int n;
+
+  while (i < len) {
+    x = bench_rand();
+    if ((x & 7) == 0)
+      n = snprintf((char *)buf + i, len - i, "\n%u.%03u ", x >> 12, x & 1023);
+    else
+      n = snprintf((char *)buf + i, len - i, "%s ", words[(x >> 8) & 15]);
+    if (n < 0)
+      break;
+    i += n;
+  }
+}
+
+static void fill_random(uint8_t *buf, size_t len) {
+  size_t i;
+
+  for (i=0; i<len; i++)
+    buf[i] = bench_rand() >> 24;
+}
+
+static const struct {
+  const char *name;
+  void (*fill)(uint8_t *, size_t);
+} corpora[] = {
+  { "repeat", fill_repeat },
+  { "ab", fill_ab },
+  { "log", fill_log },
+  { "random", fill_random }
+};
+
+static double bench_secs(struct timespec *t0) {
+  struct timespec t1;
+
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  return (t1.tv_sec - t0->tv_sec) + (t1.tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+/*
+ * bench_corpus: compress and decompress len bytes a block at a time
+ */
+
+static void bench_corpus(const char *name, const uint8_t *plain, size_t len, uint8_t *z, uint8_t *out) {
+  struct timespec t0;
+  size_t off, n, z_total = 0;
+  unsigned int z_len, out_len;
+  double c_secs = 0, d_secs = 0;
+  int ok = 1;
+
+  for (off = 0; off < len; off += n) {
+    n = (len - off < BENCH_BLOCK) ? len - off : BENCH_BLOCK;
+    z_len = BENCH_BLOCK + BENCH_BLOCK / 100 + 600;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (BZ2_bzBuffToBuffCompress((char *)z, &z_len, (char *)plain + off, n, 9, 0, 0) != BZ_OK) {
+      printf("BZ2_bzBuffToBuffCompress failed\n");
+      exit(1);
+    }
+    c_secs += bench_secs(&t0);
+    z_total += z_len;
+    out_len = BENCH_BLOCK;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    ok = ok && (BZ2_bzBuffToBuffDecompress((char *)out, &out_len, (char *)z, z_len, 0, 0) == BZ_OK);
+    d_secs += bench_secs(&t0);
+    ok = ok && (out_len == n) && (memcmp(out, plain + off, n) == 0);
+  }
+  printf("%-12s %9.2f %9.2f %7.2f%s\n", name, len / c_secs / 1e6, len / d_secs / 1e6,
+	 (double)len / z_total, ok ? "" : "  MISMATCH");
+}
+
+int main(int argc, char **argv) {
+  struct stat st;
+  FILE *f;
+  uint8_t *plain, *z, *out;
+  size_t len = BENCH_SIZE;
+  int c;
+
+  if (argc > 1)
+    len = strtoull(argv[1], NULL, 10) * 1024 * 1024;
+  plain = (uint8_t *)malloc(len);
+  z = (uint8_t *)malloc(BENCH_BLOCK + BENCH_BLOCK / 100 + 600);
+  out = (uint8_t *)malloc(BENCH_BLOCK);
+  if ((!plain) || (!z) || (!out)) {
+    printf("out of memory\n");
+    return 1;
+  }
+  printf("bzip2 -9 on %zu MiB, blocks of %i\n", len >> 20, BENCH_BLOCK);
+  printf("corpus      comp MB/s decomp MB/s ratio\n");
+  for (c=0; c<(int)(sizeof(corpora) / sizeof(corpora[0])); c++) {
+    bench_x = 2463534242U;
+    corpora[c].fill(plain, len);
+    bench_corpus(corpora[c].name, plain, len, z, out);
+  }
+  free(plain);
+
+  // files, e.g. the canterbury or silesia corpus
+  for (c=2; c<argc; c++) {
+    if ((stat(argv[c], &st) != 0) || (!(f = fopen(argv[c], "rb")))) {
+      printf("can't open %s\n", argv[c]);
+      continue;
+    }
+    plain = (uint8_t *)malloc(st.st_size + 1);
+    if ((plain) && (fread(plain, 1, st.st_size, f) == (size_t)st.st_size))
+      bench_corpus(argv[c], plain, st.st_size, z, out);
+    free(plain);
+    fclose(f);
+  }
+  free(z);
+  free(out);
+  return 0;
+}
@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ntru.h"
+#include "bzlib.h"
+#include "rotor.h"
+#include "rotor-ctx.h"
+#include "rotor-compress.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// scaling of the parallel --compress stage: the same log-like input
+// compressed on 1, 2, 4 ... threads, every result decompressed and checked.
+// then random input, which the entropy sample should pass through raw
+
+#define BENCH_SIZE (64*1024*1024)
+
+static const char *bench_words[] = {
+  "GET", "POST", "/index.html", "/api/v1/keys", "200", "404", "500", "rotor",
+  "connection", "closed", "accepted", "from", "user", "session", "timeout",
+  "ntru", "decrypt", "encrypt", "ok", "failed", "retry", "cache", "hit", "miss"
+};
+
+static void bench_fill(uint8_t *buf, size_t len) {
+  uint32_t x = 2463534242U;
+  size_t i = 0;
+  int n;
+
+  while (i < len) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    if ((x & 15) == 0) {
+      n = snprintf((char *)buf + i, len - i, "\n%u.%03u ", x >> 12, x & 1023);
+    } else {
+      n = snprintf((char *)buf + i, len - i, "%s ", bench_words[(x >> 8) % (sizeof(bench_words) / sizeof(bench_words[0]))]);
+    }
+    if (n < 0)
+      break;
+    i += n;
+  }
+}
+
+/*
+ * bench_check: undo the frames in z, compare against plain
+ */
+
+static int bench_check(const uint8_t *z, size_t z_len, const uint8_t *plain, size_t len) {
+  uint8_t *out;
+  unsigned int n;
+  uint32_t v, f_len;
+  size_t off = 0, done = 0;
+  int ok = 1;
+
+  out = (uint8_t *)malloc(ROTOR_BZ_BLOCK);
+  while ((ok) && (off + ROTOR_BZ_FRAME <= z_len)) {
+    v = z[off] | (z[off+1] << 8) | (z[off+2] << 16) | ((uint32_t)z[off+3] << 24);
+    f_len = v & ~ROTOR_BZ_FRAME_BZIP2;
+    off += ROTOR_BZ_FRAME;
+    if (off + f_len > z_len)
+      break;
+    if (v & ROTOR_BZ_FRAME_BZIP2) {
+      n = ROTOR_BZ_BLOCK;
+      ok = (BZ2_bzBuffToBuffDecompress((char *)out, &n, (char *)z + off, f_len, 0, 0) == BZ_OK);
+    } else {
+      n = f_len;
+      memcpy(out, z + off, n);
+    }
+    ok = ok && (done + n <= len) && (memcmp(out, plain + done, n) == 0);
+    done += n;
+    off += f_len;
+  }
+  free(out);
+  return ok && (off == z_len) && (done == len);
+}
+
+/*
+ * bench_run: compress len bytes on threads threads, seconds taken
+ */
+
+static double bench_run(const uint8_t *plain, size_t len, uint8_t *z, size_t *z_total, int threads,
+			struct rotor_compress_stats *stats) {
+  size_t block_len = (size_t)ROTOR_BZ_MAX_BLOCKS * ROTOR_BZ_BLOCK;
+  struct timespec t0, t1;
+  size_t off, z_len;
+
+  memset(stats, 0, sizeof(*stats));
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  *z_total = 0;
+  for (off = 0; off < len; off += block_len) {
+    if (rotor_compress_blocks(plain + off, (len - off < block_len) ? len - off : block_len,
+			      z + *z_total, &z_len, threads, stats)) {
+      printf("rotor_compress_blocks failed\n");
+      exit(1);
+    }
+    *z_total += z_len;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  return (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+}
+
+int main(int argc, char **argv) {
+  struct rotor_compress_stats stats;
+  uint8_t *plain, *z;
+  size_t len = BENCH_SIZE, z_total, i;
+  double secs, base = 0;
+  int threads, max_threads = 1;
+  uint32_t x = 88172645U;
+
+  if (argc > 1)
+    len = strtoull(argv[1], NULL, 10) * 1024 * 1024;
+#ifdef _OPENMP
+  max_threads = omp_get_max_threads();
+#endif
+  plain = (uint8_t *)malloc(len);
+  z = (uint8_t *)malloc(rotor_compress_bound(len));
+  if ((!plain) || (!z)) {
+    printf("out of memory\n");
+    return 1;
+  }
+  bench_fill(plain, len);
+  printf("compressing %zu MiB of text, %i segment(s) of %i\n", len >> 20,
+	 (int)((len + ROTOR_BZ_BLOCK - 1) / ROTOR_BZ_BLOCK), ROTOR_BZ_BLOCK);
+  printf("threads     MB/s  speedup  ratio\n");
+  for (threads = 1; ; threads *= 2) {
+    if (threads > max_threads)
+      threads = max_threads;
+    secs = bench_run(plain, len, z, &z_total, threads, &stats);
+    if (threads == 1)
+      base = secs;
+    printf("%7i %8.2f %8.2f %6.2f%s\n", threads, len / secs / 1e6, base / secs,
+	   (double)len / z_total, bench_check(z, z_total, plain, len) ? "" : "  MISMATCH");
+    if (threads == max_threads)
+      break;
+  }
+
+  // already compressed input: the entropy sample should skip every segment
+  for (i=0; i<len; i++) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    plain[i] = x >> 24;
+  }
+  secs = bench_run(plain, len, z, &z_total, max_threads, &stats);
+  printf("random input: %.2f MB/s on %i thread(s), %u of %u segment(s) skipped%s\n",
+	 len / secs / 1e6, max_threads, stats.skip_segs,
+	 stats.bz_segs + stats.skip_segs + stats.trial_segs,
+	 bench_check(z, z_total, plain, len) ? "" : "  MISMATCH");
+  free(plain);
+  free(z);
+  return 0;
+}
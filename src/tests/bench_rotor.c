@@ -0,0 +1,628 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <ctype.h>
+#include <sys/utsname.h>
+#if defined(__FreeBSD__) || defined(__NetBSD__) || defined(__APPLE__)
+#include <sys/types.h>
+#include <sys/sysctl.h>
+#endif
+#include "ntru.h"
+#include "shake.h"
+#include "salsa20.h"
+#include "yescrypt.h"
+#include "rotor.h"
+#include "rotor-keys.h"
+#include "rotor-ctx.h"
+#include "rotor-crypt.h"
+
+// rotor-bench: every primitive rotor spends its time in, then whole files
+// through the same code --batch uses, in both modes. results go to stdout
+// as JSON, one object per benchmark, progress to stderr.
+//
+// each benchmark is timed per sample until BENCH_MIN_SECS have passed and
+// there are BENCH_MIN_SAMPLES samples, or a few times BENCH_MIN_SECS if a
+// single sample is slower than that. fast operations are batched so a
+// sample takes at least BENCH_SAMPLE_SECS, latencies are per operation
+//
+// -p is the regression suite instead: fixed workloads, a warm-up call and
+// -n trials of a fixed number of operations each, the fastest trial is the
+// result and how far the median is behind it the noise. with -b each result
+// is checked against a baseline made the same way on the same kind of
+// machine (make perf-baseline, tests/perf/<-H>.json), and anything slower
+// by more than its tolerance fails the run, as does a workload the baseline
+// doesn't have. the tolerance is -T percent, -F for the file workloads
+// which are mostly I/O, widened to BENCH_NOISE_K times the noise of either
+// run but never past BENCH_NOISE_CAP times that
+
+#define BENCH_MIN_SECS 1.0
+#define BENCH_MIN_SAMPLES 5
+#define BENCH_SAMPLE_SECS 20e-6
+#define BENCH_MAX_SAMPLES 100000
+#define BENCH_MiB (1024*1024)
+#define BENCH_TRIALS 5
+#define BENCH_TOLERANCE 10.0
+#define BENCH_FILE_TOLERANCE 25.0
+#define BENCH_NOISE_K 3.0
+#define BENCH_NOISE_CAP 2.0
+#define BENCH_MAX_BASE 64
+
+typedef void (*bench_fn)(void *arg);
+
+struct bench_result {
+  char name[64];
+  uint64_t bytes;   // per operation, 0 if it doesn't make sense
+  uint64_t ops;
+  double secs;
+  double p50, p99;  // seconds per operation
+  double noise;     // -p: percent the median trial is behind the fastest
+};
+
+static double *bench_samples;
+static double bench_min_secs = BENCH_MIN_SECS;
+static int bench_count;
+static const char *bench_skip; // set by a benchmark that can't run here
+static int bench_trials = BENCH_TRIALS;
+static double bench_tolerance = BENCH_TOLERANCE;
+static double bench_file_tolerance = BENCH_FILE_TOLERANCE;
+static int bench_failed;
+
+struct bench_base {
+  char name[64];
+  double ops_per_s;
+  double noise;
+};
+
+static struct bench_base bench_base[BENCH_MAX_BASE];
+static int bench_base_count;
+
+static double bench_now() {
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static int bench_cmp(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+
+  return (x > y) - (x < y);
+}
+
+/*
+ * bench_fill: repeatable noise, so file sizes are all there is to compare
+ */
+
+static void bench_fill(uint8_t *buf, size_t len, uint32_t seed) {
+  uint32_t x = seed | 1;
+  size_t i;
+
+  for (i=0; i<len; i++) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    buf[i] = x >> 24;
+  }
+}
+
+/*
+ * bench_print: one result as a JSON object, trials 0 outside -p
+ */
+
+static void bench_print(const struct bench_result *r, int trials) {
+  fprintf(stderr, "%12.1f ops/s %10.2f MB/s  p50 %.1f us", r->ops / r->secs,
+	  r->bytes * r->ops / r->secs / 1e6, r->p50 * 1e6);
+  printf("%s    {\"name\": \"%s\", \"bytes\": %llu, \"ops\": %llu, \"ops_per_s\": %.3f, \"mb_per_s\": %.3f, "
+	 "\"p50_us\": %.3f, \"p99_us\": %.3f", (bench_count++) ? ",\n" : "", r->name,
+	 (unsigned long long)r->bytes, (unsigned long long)r->ops, r->ops / r->secs,
+	 r->bytes * r->ops / r->secs / 1e6, r->p50 * 1e6, r->p99 * 1e6);
+  if (trials)
+    printf(", \"trials\": %i, \"noise_pct\": %.3f", trials, r->noise);
+  printf("}");
+  fflush(stdout);
+}
+
+/*
+ * bench_run: time fn(arg) as described at the top, print the JSON object
+ */
+
+static void bench_run(const char *name, uint64_t bytes, bench_fn fn, void *arg) {
+  struct bench_result r;
+  double t0, t, start, elapsed = 0;
+  uint64_t batch = 1, i;
+  int n = 0;
+
+  fprintf(stderr, "%-24s", name);
+  // warm-up, and how many calls make a sample
+  t0 = bench_now();
+  fn(arg);
+  t = bench_now() - t0;
+  if (bench_skip) {
+    fprintf(stderr, "skipped, %s\n", bench_skip);
+    bench_skip = NULL;
+    return;
+  }
+  if (t >= bench_min_secs) { // too slow to throw away
+    bench_samples[n++] = t;
+    elapsed = t;
+  }
+  while (t * batch < BENCH_SAMPLE_SECS)
+    batch *= 2;
+  start = bench_now();
+  while ((n < BENCH_MAX_SAMPLES) && ((elapsed < bench_min_secs) ||
+				     ((n < BENCH_MIN_SAMPLES) && (elapsed < 5 * bench_min_secs)))) {
+    t0 = bench_now();
+    for (i=0; i<batch; i++)
+      fn(arg);
+    t = bench_now();
+    bench_samples[n++] = (t - t0) / batch;
+    elapsed = t - start;
+  }
+  qsort(bench_samples, n, sizeof(double), bench_cmp);
+  snprintf(r.name, sizeof(r.name), "%s", name);
+  r.bytes = bytes;
+  r.ops = (uint64_t)n * batch;
+  r.secs = 0;
+  for (i=0; i<(uint64_t)n; i++)
+    r.secs += bench_samples[i] * batch;
+  r.p50 = bench_samples[n / 2];
+  r.p99 = bench_samples[(n * 99) / 100];
+  bench_print(&r, 0);
+  fprintf(stderr, "\n");
+}
+
+/*
+ * bench_load_base: the results of an earlier -p run, one per line the way
+ * bench_print writes them
+ */
+
+static void bench_load_base(const char *fname) {
+  char line[512], *p, *q;
+  FILE *f;
+
+  if ((f = fopen(fname, "r")) == NULL) {
+    fprintf(stderr, "can't read baseline %s\n", fname);
+    exit(1);
+  }
+  while ((fgets(line, sizeof(line), f)) && (bench_base_count < BENCH_MAX_BASE)) {
+    if (((p = strstr(line, "\"name\": \"")) == NULL) || ((q = strstr(line, "\"ops_per_s\": ")) == NULL))
+      continue;
+    p += 9;
+    snprintf(bench_base[bench_base_count].name, sizeof(bench_base[0].name), "%.*s",
+	     (int)(strcspn(p, "\"")), p);
+    bench_base[bench_base_count].ops_per_s = atof(q + 13);
+    q = strstr(line, "\"noise_pct\": "); // older baselines have none
+    bench_base[bench_base_count++].noise = (q) ? atof(q + 13) : 0;
+  }
+  fclose(f);
+  if (bench_base_count == 0) {
+    fprintf(stderr, "no results in baseline %s\n", fname);
+    exit(1);
+  }
+}
+
+/*
+ * bench_check: r against the baseline. io picks the file tolerance, either
+ * one widens with the noise of either run up to BENCH_NOISE_CAP times itself
+ */
+
+static void bench_check(const struct bench_result *r, int io) {
+  double now = r->ops / r->secs, change, tolerance, noise;
+  double floor = (io) ? bench_file_tolerance : bench_tolerance;
+  int i;
+
+  if (bench_base_count == 0) {
+    fprintf(stderr, "\n");
+    return;
+  }
+  for (i=0; i<bench_base_count; i++)
+    if (strcmp(bench_base[i].name, r->name) == 0)
+      break;
+  if ((i == bench_base_count) || (bench_base[i].ops_per_s <= 0)) {
+    fprintf(stderr, "  not in the baseline, FAIL\n");
+    bench_failed = 1;
+    return;
+  }
+  change = 100 * (now / bench_base[i].ops_per_s - 1);
+  noise = (r->noise > bench_base[i].noise) ? r->noise : bench_base[i].noise;
+  tolerance = BENCH_NOISE_K * noise;
+  if (tolerance > BENCH_NOISE_CAP * floor)
+    tolerance = BENCH_NOISE_CAP * floor;
+  if (tolerance < floor)
+    tolerance = floor;
+  if (change < -tolerance) {
+    fprintf(stderr, "  %+.1f%% REGRESSION, allowed -%.1f%%\n", change, tolerance);
+    bench_failed = 1;
+  } else {
+    fprintf(stderr, "  %+.1f%%\n", change);
+  }
+}
+
+/*
+ * bench_trial_run: -p, a warm-up call then bench_trials trials of ops
+ * calls. the fastest trial is the result, p99 the slowest. io is set for
+ * the file workloads
+ */
+
+static void bench_trial_run(const char *name, uint64_t bytes, uint64_t ops, bench_fn fn, void *arg, int io) {
+  struct bench_result r;
+  double t0;
+  uint64_t i;
+  int n;
+
+  fprintf(stderr, "%-24s", name);
+  fn(arg);
+  if (bench_skip) {
+    fprintf(stderr, "skipped, %s\n", bench_skip);
+    bench_skip = NULL;
+    return;
+  }
+  for (n=0; n<bench_trials; n++) {
+    t0 = bench_now();
+    for (i=0; i<ops; i++)
+      fn(arg);
+    bench_samples[n] = (bench_now() - t0) / ops;
+  }
+  qsort(bench_samples, n, sizeof(double), bench_cmp);
+  snprintf(r.name, sizeof(r.name), "%s", name);
+  r.bytes = bytes;
+  r.ops = ops;
+  r.p50 = bench_samples[n / 2];
+  r.p99 = bench_samples[n - 1];
+  r.secs = bench_samples[0] * ops; // rates are the fastest trial's, the least disturbed
+  r.noise = 100 * (r.p50 / bench_samples[0] - 1);
+  bench_print(&r, n);
+  bench_check(&r, io);
+}
+
+/*
+ * the benchmarks
+ */
+
+struct bench_buf {
+  uint8_t *in;
+  size_t len;
+  uint8_t out[NTRU_PRIVLEN];
+};
+
+static void bench_salsa20(void *arg) {
+  struct bench_buf *b = (struct bench_buf *)arg;
+  uint8_t nonce[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+  s20_crypt(b->out, S20_KEYLEN_256, nonce, 0, b->in, b->len);
+}
+
+static void bench_shake(void *arg) {
+  struct bench_buf *b = (struct bench_buf *)arg;
+
+  FIPS202_SHAKE256(b->in, b->len, b->out, ROTOR_BLOCK);
+}
+
+static void bench_kdf_yescrypt(void *arg) { // needs as much RAM as an unlock does
+  struct bench_buf *b = (struct bench_buf *)arg;
+  yescrypt_local_t local;
+  const char *salt = KDF_SALT;
+
+  yescrypt_init_local(&local);
+  if (yescrypt_kdf(NULL, &local, b->in, b->len, (const uint8_t *)salt, strlen(salt), KDF_YESCRYPT_N,
+		   KDF_YESCRYPT_R, KDF_YESCRYPT_P, KDF_YESCRYPT_T, KDF_YESCRYPT_G, YESCRYPT_RW, b->out, 64))
+    bench_skip = strerror(errno);
+  yescrypt_free_local(&local);
+}
+
+static void bench_kdf_shake(void *arg) { // the rounds rotor_load_armorpriv runs after yescrypt
+  struct bench_buf *b = (struct bench_buf *)arg;
+  uint8_t tmp[NTRU_PRIVLEN];
+  int i;
+
+  FIPS202_SHAKE256(b->in, 170, b->out, NTRU_PRIVLEN);
+  for (i=0; i<KDF_ROUNDS; i++) {
+    FIPS202_SHAKE256(b->out, NTRU_PRIVLEN, tmp, NTRU_PRIVLEN);
+    FIPS202_SHAKE256(tmp, NTRU_PRIVLEN, b->out, NTRU_PRIVLEN);
+  }
+}
+
+struct bench_ntru {
+  NtruEncKeyPair kp;
+  NtruRandContext rand_ctx;
+  uint8_t plain[ROTOR_BLOCK];
+  uint8_t enc[NTRU_ENCLEN];
+  uint8_t dec[NTRU_ENCLEN];
+};
+
+static void bench_ntru_keygen(void *arg) {
+  struct bench_ntru *b = (struct bench_ntru *)arg;
+  NtruEncKeyPair kp;
+
+  if (ntru_gen_key_pair(&EES1087EP2, &kp, &b->rand_ctx) != NTRU_SUCCESS) {
+    fprintf(stderr, "ntru_gen_key_pair failed\n");
+    exit(1);
+  }
+}
+
+static void bench_ntru_encrypt(void *arg) {
+  struct bench_ntru *b = (struct bench_ntru *)arg;
+
+  if (ntru_encrypt(b->plain, ROTOR_BLOCK, &b->kp.pub, &EES1087EP2, &b->rand_ctx, b->enc) != NTRU_SUCCESS) {
+    fprintf(stderr, "ntru_encrypt failed\n");
+    exit(1);
+  }
+}
+
+static void bench_ntru_decrypt(void *arg) {
+  struct bench_ntru *b = (struct bench_ntru *)arg;
+  uint16_t dec_len;
+
+  memcpy(b->dec, b->enc, NTRU_ENCLEN); // ntru_decrypt writes to it
+  if ((ntru_decrypt(b->dec, &b->kp, &EES1087EP2, b->plain, &dec_len) != NTRU_SUCCESS) ||
+      (dec_len != ROTOR_BLOCK)) {
+    fprintf(stderr, "ntru_decrypt failed\n");
+    exit(1);
+  }
+}
+
+struct bench_file {
+  NtruEncKeyPair *kp;
+  char fname[4096];
+  int mode, dec;
+};
+
+static void bench_file(void *arg) {
+  struct bench_file *b = (struct bench_file *)arg;
+  char sfname[4096 + 4];
+  uint64_t in_len;
+
+  snprintf(sfname, sizeof(sfname), "%s%s", b->fname, (b->dec) ? ".enc" : "");
+  if (rotor_crypt_file_batch(b->kp, b->mode, b->dec, 0, sfname, &in_len) != ROTOR_SUCCESS) {
+    fprintf(stderr, "%s failed\n", sfname);
+    exit(1);
+  }
+}
+
+/*
+ * bench_make_file: size bytes of noise in dir, name to fname
+ */
+
+static void bench_make_file(const char *dir, uint64_t size, char *fname, size_t fname_len) {
+  uint8_t *buf = (uint8_t *)malloc(BENCH_MiB);
+  uint64_t done;
+  size_t n;
+  FILE *f;
+
+  snprintf(fname, fname_len, "%s/rotor-bench.%d.%llu", dir, (int)getpid(), (unsigned long long)size);
+  if ((!buf) || ((f = fopen(fname, "wb")) == NULL)) {
+    fprintf(stderr, "can't write %s\n", fname);
+    exit(1);
+  }
+  for (done = 0; done < size; done += n) {
+    n = (size - done < BENCH_MiB) ? size - done : BENCH_MiB;
+    bench_fill(buf, n, (uint32_t)done ^ 0x9e3779b9);
+    if (fwrite(buf, 1, n, f) != n) {
+      fprintf(stderr, "can't write %s\n", fname);
+      exit(1);
+    }
+  }
+  fclose(f);
+  free(buf);
+}
+
+/*
+ * bench_perf: the -p workloads, per trial: 1 GiB of Salsa20, SHAKE-256 at
+ * 64 bytes, 1 KiB and 1 MiB, 10k NTRU encryptions and decryptions, and a
+ * fixed file through each mode. quick is a tenth of each, rates compare
+ * with a full run
+ */
+
+static void bench_perf(struct bench_buf *b, struct bench_ntru *nt, const char *dir, int quick) {
+  struct bench_file bf;
+  char name[64], enc_name[4096 + 16];
+  int div = (quick) ? 10 : 1;
+  int mode;
+
+  b->len = BENCH_MiB;
+  bench_trial_run("salsa20_1MiB", b->len, 1024 / div, bench_salsa20, b, 0);
+  b->len = 64;
+  bench_trial_run("shake256_64", b->len, 30000 / div, bench_shake, b, 0);
+  b->len = 1024;
+  bench_trial_run("shake256_1024", b->len, 4000 / div, bench_shake, b, 0);
+  b->len = BENCH_MiB;
+  bench_trial_run("shake256_1048576", b->len, 10 / div, bench_shake, b, 0);
+  bench_trial_run("ntru_encrypt_ees1087ep2", ROTOR_BLOCK, 10000 / div, bench_ntru_encrypt, nt, 0);
+  bench_trial_run("ntru_decrypt_ees1087ep2", ROTOR_BLOCK, 10000 / div, bench_ntru_decrypt, nt, 0);
+
+  bf.kp = &nt->kp;
+  bf.dec = 0;
+  for (mode=ROTOR_MODE_SYM; mode<=ROTOR_MODE_EXT; mode++) { // ext is about 4x slower
+    bench_make_file(dir, (mode == ROTOR_MODE_SYM) ? 4000000 : 1000000, bf.fname, sizeof(bf.fname));
+    bf.mode = mode;
+    snprintf(name, sizeof(name), "file_%s_enc_%iMB", (mode == ROTOR_MODE_SYM) ? "sym" : "ext",
+	     (mode == ROTOR_MODE_SYM) ? 4 : 1);
+    bench_trial_run(name, (mode == ROTOR_MODE_SYM) ? 4000000 : 1000000, 1, bench_file, &bf, 1);
+    snprintf(enc_name, sizeof(enc_name), "%s.enc", bf.fname);
+    unlink(enc_name);
+    strncat(enc_name, ".key", 5);
+    unlink(enc_name);
+    unlink(bf.fname);
+  }
+}
+
+/*
+ * bench_host: what baselines are kept under, machine, CPU model and CPU
+ * count as one lowercase name. the host name if the model can't be had
+ */
+
+static void bench_host() {
+  char model[256] = "", *p;
+  struct utsname u;
+  int dash = 1;
+#if defined(__linux__)
+  char line[512];
+  FILE *f;
+
+  if ((f = fopen("/proc/cpuinfo", "r")) != NULL) {
+    while (fgets(line, sizeof(line), f))
+      if ((strncmp(line, "model name", 10) == 0) && ((p = strchr(line, ':')) != NULL)) {
+	snprintf(model, sizeof(model), "%s", p + 1);
+	break;
+      }
+    fclose(f);
+  }
+#elif defined(__FreeBSD__) || defined(__NetBSD__) || defined(__APPLE__)
+  size_t len = sizeof(model) - 1;
+
+  if (sysctlbyname("hw.model", model, &len, NULL, 0))
+    model[0] = 0;
+#endif
+  uname(&u);
+  if (model[0] == 0)
+    snprintf(model, sizeof(model), "%s", u.nodename);
+  printf("%s-", u.machine);
+  for (p = model; *p; p++) {
+    if (isalnum((unsigned char)*p)) {
+      putchar(tolower((unsigned char)*p));
+      dash = 0;
+    } else if (!dash) {
+      putchar('-');
+      dash = 1;
+    }
+  }
+  printf("%s%lic\n", (dash) ? "" : "-", sysconf(_SC_NPROCESSORS_ONLN));
+}
+
+static void bench_usage() {
+  fprintf(stderr, "usage: rotor-bench [-t seconds] [-d dir] [-q] [MB ...]\n");
+  fprintf(stderr, "       rotor-bench -p [-n trials] [-b baseline.json] [-T percent] [-F percent] [-d dir] [-q]\n");
+  fprintf(stderr, "       rotor-bench -H\n");
+  fprintf(stderr, "  -t  least time per benchmark, default %.1f\n", BENCH_MIN_SECS);
+  fprintf(stderr, "  -d  where the file benchmarks write, default $TMPDIR or /tmp\n");
+  fprintf(stderr, "  -q  quick: 1 MB files only, a tenth of the time\n");
+  fprintf(stderr, "  MB  file sizes, default 1 100 1024\n");
+  fprintf(stderr, "  -p  regression suite, fixed workloads\n");
+  fprintf(stderr, "  -n  trials per workload, default %i\n", BENCH_TRIALS);
+  fprintf(stderr, "  -b  fail if slower than this earlier -p run on this machine\n");
+  fprintf(stderr, "  -T  slowdown allowed against the baseline, default %.0f%%. %.0fx the noise of\n"
+	  "      either run if that's more, up to %.0fx this\n", BENCH_TOLERANCE, BENCH_NOISE_K, BENCH_NOISE_CAP);
+  fprintf(stderr, "  -F  the same for the file workloads, default %.0f%%\n", BENCH_FILE_TOLERANCE);
+  fprintf(stderr, "  -H  the name baselines for this machine are kept under\n");
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  size_t shake_lens[] = {64, ROTOR_BLOCK, 1024, BENCH_MiB};
+  uint64_t file_mb[16] = {1, 100, 1024};
+  int file_count = 3, sizes = 0, quick = 0, perf = 0, opc, i, mode, dec;
+  const char *dir = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+  const char *modes[] = {"sym", "ext"};
+  NtruRandGen rng = NTRU_RNG_DEFAULT;
+  struct bench_ntru *nt;
+  struct bench_file bf;
+  struct bench_buf b;
+  char name[64], enc_name[4096 + 16];
+
+  for (opc=1; opc<argc; opc++) {
+    if ((strcmp(argv[opc], "-t") == 0) && (opc + 1 < argc)) {
+      bench_min_secs = atof(argv[++opc]);
+    } else if ((strcmp(argv[opc], "-d") == 0) && (opc + 1 < argc)) {
+      dir = argv[++opc];
+    } else if (strcmp(argv[opc], "-q") == 0) {
+      quick = 1;
+    } else if (strcmp(argv[opc], "-p") == 0) {
+      perf = 1;
+    } else if ((strcmp(argv[opc], "-n") == 0) && (opc + 1 < argc)) {
+      bench_trials = atoi(argv[++opc]);
+      if ((bench_trials < 1) || (bench_trials > BENCH_MAX_SAMPLES))
+	bench_usage();
+    } else if ((strcmp(argv[opc], "-b") == 0) && (opc + 1 < argc)) {
+      bench_load_base(argv[++opc]);
+    } else if ((strcmp(argv[opc], "-T") == 0) && (opc + 1 < argc)) {
+      bench_tolerance = atof(argv[++opc]);
+    } else if ((strcmp(argv[opc], "-F") == 0) && (opc + 1 < argc)) {
+      bench_file_tolerance = atof(argv[++opc]);
+    } else if (strcmp(argv[opc], "-H") == 0) {
+      bench_host();
+      return 0;
+    } else if ((argv[opc][0] >= '1') && (argv[opc][0] <= '9')) {
+      if (!sizes) // the first size replaces the defaults
+	file_count = 0;
+      if (file_count >= 16)
+	bench_usage();
+      file_mb[file_count++] = strtoull(argv[opc], NULL, 10);
+      sizes = 1;
+    } else {
+      bench_usage();
+    }
+  }
+  if (quick) {
+    file_mb[0] = 1;
+    file_count = 1;
+    bench_min_secs /= 10;
+  }
+  bench_samples = (double *)malloc(BENCH_MAX_SAMPLES * sizeof(double));
+  b.in = (uint8_t *)malloc(BENCH_MiB);
+  nt = (struct bench_ntru *)calloc(1, sizeof(*nt));
+  if ((!bench_samples) || (!b.in) || (!nt)) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  bench_fill(b.in, BENCH_MiB, 1);
+  bench_fill(b.out, sizeof(b.out), 2);
+  if ((ntru_rand_init(&nt->rand_ctx, &rng) != NTRU_SUCCESS) ||
+      (ntru_gen_key_pair(&EES1087EP2, &nt->kp, &nt->rand_ctx) != NTRU_SUCCESS)) {
+    fprintf(stderr, "ntru_gen_key_pair failed\n");
+    return 1;
+  }
+  bench_fill(nt->plain, ROTOR_BLOCK, 3);
+  if (perf) {
+    printf("{\n  \"rotor_bench\": 1,\n  \"trials\": %i,\n  \"results\": [\n", bench_trials);
+    bench_perf(&b, nt, dir, quick);
+    goto done;
+  }
+  printf("{\n  \"rotor_bench\": 1,\n  \"min_secs\": %.3f,\n  \"results\": [\n", bench_min_secs);
+
+  b.len = BENCH_MiB;
+  bench_run("salsa20_1MiB", b.len, bench_salsa20, &b);
+  for (i=0; i<(int)(sizeof(shake_lens) / sizeof(shake_lens[0])); i++) {
+    b.len = shake_lens[i];
+    snprintf(name, sizeof(name), "shake256_%zu", b.len);
+    bench_run(name, b.len, bench_shake, &b);
+  }
+  b.len = 16;
+  bench_run("kdf_yescrypt", 0, bench_kdf_yescrypt, &b);
+  bench_run("kdf_shake_rounds", 0, bench_kdf_shake, &b);
+
+  bench_run("ntru_keygen_ees1087ep2", 0, bench_ntru_keygen, nt);
+  bench_run("ntru_encrypt_ees1087ep2", ROTOR_BLOCK, bench_ntru_encrypt, nt);
+  bench_run("ntru_decrypt_ees1087ep2", ROTOR_BLOCK, bench_ntru_decrypt, nt);
+
+  bf.kp = &nt->kp;
+  for (i=0; i<file_count; i++) {
+    bench_make_file(dir, file_mb[i] * 1000000, bf.fname, sizeof(bf.fname));
+    snprintf(enc_name, sizeof(enc_name), "%s.enc", bf.fname);
+    for (mode=ROTOR_MODE_SYM; mode<=ROTOR_MODE_EXT; mode++) {
+      bf.mode = mode;
+      for (dec=0; dec<2; dec++) {
+	bf.dec = dec;
+	snprintf(name, sizeof(name), "file_%s_%s_%lluMB", modes[mode], (dec) ? "dec" : "enc",
+		 (unsigned long long)file_mb[i]);
+	bench_run(name, file_mb[i] * 1000000, bench_file, &bf);
+      }
+      unlink(enc_name);
+      strncat(enc_name, ".key", 5);
+      unlink(enc_name);
+      enc_name[strlen(enc_name) - 4] = 0;
+    }
+    unlink(bf.fname);
+  }
+ done:
+  printf("\n  ]\n}\n");
+  ntru_rand_release(&nt->rand_ctx);
+  free(nt);
+  free(b.in);
+  free(bench_samples);
+  if (bench_failed)
+    fprintf(stderr, "slower than the baseline by more than the tolerance\n");
+  return bench_failed;
+}
@@ -0,0 +1,323 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "ntru.h"
+#include "rotor.h"
+#include "rotor-ctx.h"
+
+// rotor-fuzz: rotor_ctx_decrypt_mem over untrusted bytes. an input is one
+// byte whose low bit picks the mode and whose next bit lets files without a
+// MAC through (rotor_ctx_allow_unauth), then a whole file as
+// rotor_ctx_decrypt_mem takes it. the key pair comes from a fixed seed, so inputs made by -s
+// decrypt for real and the fuzzer starts from the far side of the NTRU
+// header.
+//
+// built with -DROTOR_LIBFUZZER it is only LLVMFuzzerTestOneInput for
+// libFuzzer (make fuzz). otherwise main is the replay driver, which AFL can
+// run with @@ as well:
+//
+//   rotor-fuzz -s dir              write the seed corpus to dir
+//   rotor-fuzz file|dir|- ...      run each input once, for crashes
+//   rotor-fuzz -t [-n rounds] [-m ms] file|dir ...
+//                                  throughput: each input -n times, the
+//                                  fastest run counts. totals and the
+//                                  slowest inputs go to stdout, and with -m
+//                                  any input slower than ms fails the run
+
+#define FUZZ_SEED "rotor-fuzz fixed key, not for files"
+#define FUZZ_ROUNDS 3
+#define FUZZ_SLOWEST 5
+#define FUZZ_MAX_INPUT (16*1024*1024)
+
+static NtruEncKeyPair fuzz_kp;
+static rotor_ctx *fuzz_ctx[2];
+static uint8_t *fuzz_out;
+static size_t fuzz_out_len;
+
+static int fuzz_init() {
+  NtruRandGen rng = NTRU_RNG_CTR_DRBG;
+  NtruRandContext rand_ctx;
+
+  if (fuzz_ctx[0])
+    return 0;
+  if ((ntru_rand_init_det(&rand_ctx, &rng, (uint8_t *)FUZZ_SEED, strlen(FUZZ_SEED)) != NTRU_SUCCESS) ||
+      (ntru_gen_key_pair(&EES1087EP2, &fuzz_kp, &rand_ctx) != NTRU_SUCCESS)) {
+    fprintf(stderr, "rotor-fuzz: keygen failed\n");
+    return 1;
+  }
+  ntru_rand_release(&rand_ctx);
+  fuzz_ctx[ROTOR_MODE_SYM] = rotor_ctx_new(&fuzz_kp, ROTOR_MODE_SYM);
+  fuzz_ctx[ROTOR_MODE_EXT] = rotor_ctx_new(&fuzz_kp, ROTOR_MODE_EXT);
+  if ((!fuzz_ctx[0]) || (!fuzz_ctx[1])) {
+    fprintf(stderr, "rotor-fuzz: out of memory\n");
+    return 1;
+  }
+  return 0;
+}
+
+/*
+ * fuzz_one: one input, the rotor_ctx_decrypt_mem result
+ */
+
+static int fuzz_one(const uint8_t *data, size_t size) {
+  size_t out_len;
+
+  if (size < 1)
+    return ROTOR_ERR_FORMAT;
+  if (fuzz_out_len < size) {
+    free(fuzz_out);
+    if ((fuzz_out = (uint8_t *)malloc(size)) == NULL) {
+      fuzz_out_len = 0;
+      return ROTOR_ERR_MEMORY;
+    }
+    fuzz_out_len = size;
+  }
+  rotor_ctx_allow_unauth(fuzz_ctx[data[0] & 1], data[0] & 2);
+  return rotor_ctx_decrypt_mem(fuzz_ctx[data[0] & 1], data + 1, size - 1, fuzz_out, &out_len);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  if (fuzz_init())
+    abort();
+  fuzz_one(data, size);
+  return 0;
+}
+
+#ifndef ROTOR_LIBFUZZER
+
+struct fuzz_input {
+  char name[1024];
+  size_t size;
+  double secs; // fastest run
+  int rc;
+};
+
+static double fuzz_clock() {
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/*
+ * fuzz_seed: encrypt len bytes into dir/name, as an input: mode byte,
+ * header, body, index
+ */
+
+static int fuzz_seed(const char *dir, int mode, uint32_t flags, int stream, size_t len) {
+  static const char *modes[] = {"sym", "ext"};
+  uint8_t head[ROTOR_HEADER_LEN];
+  uint8_t *plain, *enc;
+  const uint8_t *index;
+  char fname[1024];
+  size_t enc_len, n, index_len, i;
+  rotor_ctx *ctx;
+  FILE *f;
+  int rc;
+
+  plain = (uint8_t *)malloc(len + 1);
+  enc = (uint8_t *)malloc((len / ROTOR_BLOCK + 3) * NTRU_ENCLEN + ROTOR_FINAL_MAX);
+  ctx = rotor_ctx_new(&fuzz_kp, mode);
+  if ((!plain) || (!enc) || (!ctx))
+    return 1;
+  for (i=0; i<len; i++)
+    plain[i] = rand();
+  rotor_ctx_set_flags(ctx, flags);
+  if (((rc = rotor_ctx_encrypt_init(ctx, (stream) ? ROTOR_LEN_STREAM : len, head)) == ROTOR_SUCCESS) &&
+      ((rc = rotor_ctx_update(ctx, plain, len, enc, &enc_len)) == ROTOR_SUCCESS) &&
+      ((rc = rotor_ctx_final(ctx, enc + enc_len, &n)) == ROTOR_SUCCESS)) {
+    enc_len += n;
+    index = rotor_ctx_index(ctx, &index_len);
+    snprintf(fname, sizeof(fname), "%s/seed-%s-%s%s%s-%zu", dir, modes[mode], (stream) ? "stream" : "sized",
+	     (flags & ROTOR_FLAG_MAC) ? "-mac" : "", (flags & ROTOR_FLAG_INDEX) ? "-index" : "", len);
+    if ((f = fopen(fname, "wb")) == NULL) {
+      fprintf(stderr, "rotor-fuzz: can't write %s\n", fname);
+      rc = 1;
+    } else {
+      fputc(mode | ((flags & ROTOR_FLAG_MAC) ? 0 : 2), f);
+      fwrite(head, 1, ROTOR_HEADER_LEN, f);
+      fwrite(enc, 1, enc_len, f);
+      if (index)
+	fwrite(index, 1, index_len, f);
+      fclose(f);
+    }
+  }
+  rotor_ctx_free(ctx);
+  free(plain);
+  free(enc);
+  return rc;
+}
+
+static int fuzz_seeds(const char *dir) {
+  uint32_t flags[] = {0, ROTOR_FLAG_MAC, ROTOR_FLAG_MAC | ROTOR_FLAG_INDEX};
+  size_t lens[] = {0, 169, 1000};
+  int mode, stream, i, j, count = 0;
+
+  mkdir(dir, 0755);
+  srand(1);
+  for (mode=ROTOR_MODE_SYM; mode<=ROTOR_MODE_EXT; mode++)
+    for (stream=0; stream<2; stream++)
+      for (i=0; i<(int)(sizeof(flags) / sizeof(flags[0])); i++)
+	for (j=0; j<(int)(sizeof(lens) / sizeof(lens[0])); j++) {
+	  if (fuzz_seed(dir, mode, flags[i], stream, lens[j]))
+	    return 1;
+	  count++;
+	}
+  fprintf(stderr, "%i seeds in %s\n", count, dir);
+  return 0;
+}
+
+/*
+ * fuzz_read: all of fname, "-" for stdin, into *buf
+ */
+
+static int fuzz_read(const char *fname, uint8_t **buf, size_t *size) {
+  FILE *f = (strcmp(fname, "-") == 0) ? stdin : fopen(fname, "rb");
+  size_t n;
+
+  *size = 0;
+  if (f == NULL) {
+    fprintf(stderr, "rotor-fuzz: can't open %s\n", fname);
+    return 1;
+  }
+  *buf = (uint8_t *)malloc(FUZZ_MAX_INPUT);
+  if (*buf == NULL) {
+    fprintf(stderr, "rotor-fuzz: out of memory\n");
+    exit(1);
+  }
+  while ((*size < FUZZ_MAX_INPUT) && ((n = fread(*buf + *size, 1, FUZZ_MAX_INPUT - *size, f)) > 0))
+    *size += n;
+  if (f != stdin)
+    fclose(f);
+  return 0;
+}
+
+/*
+ * fuzz_file: run one input rounds times, the fastest run goes to in
+ */
+
+static int fuzz_file(const char *fname, int rounds, struct fuzz_input *in) {
+  uint8_t *buf;
+  double t0, t;
+  int r;
+
+  if (fuzz_read(fname, &buf, &in->size))
+    return 1;
+  snprintf(in->name, sizeof(in->name), "%s", fname);
+  in->secs = -1;
+  for (r=0; r<rounds; r++) {
+    t0 = fuzz_clock();
+    in->rc = fuzz_one(buf, in->size);
+    t = fuzz_clock() - t0;
+    if ((in->secs < 0) || (t < in->secs))
+      in->secs = t;
+  }
+  free(buf);
+  return 0;
+}
+
+/*
+ * fuzz_slowest: keep the FUZZ_SLOWEST slowest inputs, slowest first
+ */
+
+static void fuzz_slowest(struct fuzz_input *slow, int *count, const struct fuzz_input *in) {
+  int i;
+
+  if ((*count == FUZZ_SLOWEST) && (in->secs <= slow[*count - 1].secs))
+    return;
+  if (*count < FUZZ_SLOWEST)
+    (*count)++;
+  for (i=*count - 1; (i > 0) && (slow[i-1].secs < in->secs); i--)
+    slow[i] = slow[i-1];
+  slow[i] = *in;
+}
+
+int main(int argc, char **argv) {
+  struct fuzz_input in, slow[FUZZ_SLOWEST];
+  char path[1024];
+  struct dirent *de;
+  struct stat st;
+  DIR *d;
+  const char *seed_dir = NULL;
+  uint64_t bytes = 0, inputs = 0;
+  double secs = 0, max_ms = 0;
+  int rounds = FUZZ_ROUNDS, timing = 0, slow_count = 0, failed = 0;
+  int opt, i;
+
+  while ((opt = getopt(argc, argv, "s:tn:m:")) != -1) {
+    switch (opt) {
+    case 's':
+      seed_dir = optarg;
+      break;
+    case 't':
+      timing = 1;
+      break;
+    case 'n':
+      rounds = atoi(optarg);
+      break;
+    case 'm':
+      max_ms = atof(optarg);
+      break;
+    default:
+      fprintf(stderr, "usage: rotor-fuzz -s dir | [-t] [-n rounds] [-m ms] file|dir|- ...\n");
+      return 1;
+    }
+  }
+  if (rounds < 1)
+    rounds = 1;
+  if (!timing)
+    rounds = 1;
+  if (fuzz_init())
+    return 1;
+  if (seed_dir)
+    return fuzz_seeds(seed_dir);
+  for (i=optind; i<argc; i++) {
+    d = NULL;
+    de = NULL;
+    if ((strcmp(argv[i], "-") != 0) && (stat(argv[i], &st) == 0) && (S_ISDIR(st.st_mode)) &&
+	((d = opendir(argv[i])) == NULL)) {
+      fprintf(stderr, "rotor-fuzz: can't read %s\n", argv[i]);
+      return 1;
+    }
+    while ((d == NULL) || ((de = readdir(d)) != NULL)) {
+      if (d) {
+	snprintf(path, sizeof(path), "%s/%s", argv[i], de->d_name);
+	if ((stat(path, &st) != 0) || (!S_ISREG(st.st_mode)))
+	  continue;
+      } else {
+	snprintf(path, sizeof(path), "%s", argv[i]);
+      }
+      if (fuzz_file(path, rounds, &in))
+	return 1;
+      inputs++;
+      bytes += in.size;
+      secs += in.secs;
+      fuzz_slowest(slow, &slow_count, &in);
+      if ((max_ms > 0) && (in.secs * 1e3 > max_ms)) {
+	fprintf(stderr, "%s: %.1fms, over %.1fms\n", in.name, in.secs * 1e3, max_ms);
+	failed = 1;
+      }
+      if (d == NULL)
+	break;
+    }
+    if (d)
+      closedir(d);
+  }
+  if (timing) {
+    printf("%llu inputs, %llu bytes in %.3fs: %.1f inputs/s, %.3f MB/s\n", (unsigned long long)inputs,
+	   (unsigned long long)bytes, secs, (secs > 0) ? inputs / secs : 0, (secs > 0) ? bytes / secs / 1e6 : 0);
+    for (i=0; i<slow_count; i++)
+      printf("  %10.3fms %9zu bytes  %-22s %s\n", slow[i].secs * 1e3, slow[i].size,
+	     rotor_ctx_strerror(slow[i].rc), slow[i].name);
+  }
+  rotor_ctx_free(fuzz_ctx[0]);
+  rotor_ctx_free(fuzz_ctx[1]);
+  free(fuzz_out);
+  return failed;
+}
+
+#endif
@@ -0,0 +1,14 @@
+#include <stdio.h>
+#include <stdint.h>
+#include "test_ctx.h"
+#include "test_digest.h"
+#include "test_keys.h"
+
+int main(int argc, char** argv) {
+  printf("Running tests...\n");
+  uint8_t pass = test_ctx();
+  pass &= test_digest();
+  pass &= test_keys();
+  printf("%s\n", pass?"All tests passed":"One or more tests failed");
+  return pass ? 0 : 1;
+}
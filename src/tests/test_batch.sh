@@ -0,0 +1,36 @@
+#!/bin/sh
+# test_batch: --batch takes the files on the command line and nothing else.
+# option values after the file list are not files. run from src/ after
+# building rotor, the public key is the v1 one armored on the fly
+
+ROTOR=${ROTOR:-./rotor}
+dir=$(mktemp -d /tmp/rotor-batch-XXXXXX) || exit 1
+trap 'rm -rf "$dir"' EXIT
+pass=1
+
+{
+  echo "-----BEGIN NTRU PUBLIC KEY BLOCK-----"
+  od -An -v -tx1 tests/v1/key.pub | tr -d ' \n' | fold -w 72
+  echo
+  echo "-------------------------------------"
+} > "$dir/pub.key"
+echo one > "$dir/a"
+echo two > "$dir/b"
+
+if ! $ROTOR --enc --batch "$dir/a" "$dir/b" --pubkey "$dir/pub.key" --keygen-pubs 1 > "$dir/log" 2>&1; then
+  cat "$dir/log"
+  pass=0
+fi
+for f in a.enc b.enc; do
+  [ -s "$dir/$f" ] || { echo "  $f missing"; pass=0; }
+done
+for f in pub.key.enc 1.enc; do
+  [ -e "$dir/$f" ] && { echo "  $f written, an option value went in the batch"; pass=0; }
+done
+
+if [ $pass = 1 ]; then
+  printf "  %-30s%s\n" test_batch_args OK
+else
+  printf "  %-30s%s\n" test_batch_args FAIL
+fi
+[ $pass = 1 ]
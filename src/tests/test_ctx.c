@@ -0,0 +1,531 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "ntru.h"
+#include "rotor.h"
+#include "rotor-ctx.h"
+#include "test_ctx.h"
+
+// sparse file for the large file test, nothing gets written to it
+#define TEST_SPARSE_SIZE (300ULL*1024*1024*1024)
+
+// v1 files written by rotor 0.78 before the v2 header, relative to src/
+// where make test runs. the plaintext is 200 bytes of i*7
+#define TEST_V1_DIR "tests/v1/"
+
+static NtruEncKeyPair kp;
+
+static void print_result(char *test_name, uint8_t valid) {
+  printf("  %-30s%s\n", test_name, valid?"OK":"FAIL");
+}
+
+/*
+ * test_crypt: run len bytes through ctx in chunks of step, out gets it all
+ */
+
+static uint8_t test_crypt(rotor_ctx *ctx, const uint8_t *in, size_t len, size_t step, uint8_t *out, size_t *out_len) {
+  size_t n, done = 0;
+
+  *out_len = 0;
+  while (done < len) {
+    n = (len - done < step) ? len - done : step;
+    if (rotor_ctx_update(ctx, in + done, n, out + *out_len, &n) != ROTOR_SUCCESS)
+      return 0;
+    done += (len - done < step) ? len - done : step;
+    *out_len += n;
+  }
+  if (rotor_ctx_final(ctx, out + *out_len, &n) != ROTOR_SUCCESS)
+    return 0;
+  *out_len += n;
+  return 1;
+}
+
+static uint8_t test_roundtrip() {
+  size_t sizes[] = {0, 1, 169, 170, 171, 340, 341, 5000};
+  size_t steps[] = {1, 7, 170, 4096};
+  uint8_t head[ROTOR_HEADER_LEN];
+  uint8_t *plain, *enc, *dec;
+  size_t enc_len, dec_len;
+  rotor_ctx *ectx, *dctx;
+  int i, mode, stream;
+  uint8_t valid = 1;
+
+  plain = malloc(5000);
+  enc = malloc(60000);
+  dec = malloc(60000);
+  for (i=0; i<5000; i++)
+    plain[i] = rand();
+  for (mode=ROTOR_MODE_SYM; mode<=ROTOR_MODE_EXT; mode++) {
+    ectx = rotor_ctx_new(&kp, mode);
+    dctx = rotor_ctx_new(&kp, mode);
+    rotor_ctx_allow_unauth(dctx, 1);
+    for (stream=0; stream<2; stream++)
+      for (i=0; i<sizeof(sizes)/sizeof(sizes[0]); i++) {
+	valid &= rotor_ctx_encrypt_init(ectx, stream ? ROTOR_LEN_STREAM : sizes[i], head) == ROTOR_SUCCESS;
+	valid &= test_crypt(ectx, plain, sizes[i], steps[i % 4], enc, &enc_len);
+	valid &= rotor_ctx_header_len(head) == ROTOR_HEADER_LEN;
+	valid &= rotor_ctx_decrypt_init(dctx, head) == ROTOR_SUCCESS;
+	valid &= test_crypt(dctx, enc, enc_len, steps[(i+1) % 4], dec, &dec_len);
+	valid &= (dec_len == sizes[i]) && (memcmp(dec, plain, dec_len) == 0);
+	if (enc_len >= ROTOR_BLOCK) { // cut off the last block
+	  valid &= rotor_ctx_decrypt_init(dctx, head) == ROTOR_SUCCESS;
+	  valid &= !test_crypt(dctx, enc, enc_len - ((mode == ROTOR_MODE_EXT) ? NTRU_ENCLEN : ROTOR_BLOCK), 4096, dec, &dec_len);
+	}
+      }
+    rotor_ctx_free(ectx);
+    rotor_ctx_free(dctx);
+  }
+  free(plain);
+  free(enc);
+  free(dec);
+  print_result("test_roundtrip", valid);
+  return valid;
+}
+
+/*
+ * test_header_sizes: sizes past what the v1 header could hold survive the
+ * v2 header exactly
+ */
+
+static uint8_t test_header_sizes() {
+  uint64_t sizes[] = {0, 169, 170, (1ULL<<32) + 7, 0x7fffffffULL*170 + 171, TEST_SPARSE_SIZE, (1ULL<<50) + 169};
+  uint8_t head[ROTOR_HEADER_LEN];
+  uint64_t size, segments;
+  rotor_ctx *ectx, *dctx;
+  int i, mode;
+  uint8_t valid = 1;
+
+  for (mode=ROTOR_MODE_SYM; mode<=ROTOR_MODE_EXT; mode++) {
+    ectx = rotor_ctx_new(&kp, mode);
+    dctx = rotor_ctx_new(&kp, mode);
+    rotor_ctx_allow_unauth(dctx, 1);
+    for (i=0; i<sizeof(sizes)/sizeof(sizes[0]); i++) {
+      valid &= rotor_ctx_encrypt_init(ectx, sizes[i], head) == ROTOR_SUCCESS;
+      valid &= rotor_ctx_decrypt_init(dctx, head) == ROTOR_SUCCESS;
+      rotor_ctx_info(dctx, &size, &segments);
+      valid &= size == sizes[i];
+      valid &= segments == sizes[i] / 170 + ((sizes[i] % 170) ? 1 : 0) + mode;
+    }
+    rotor_ctx_free(ectx);
+    rotor_ctx_free(dctx);
+  }
+  print_result("test_header_sizes", valid);
+  return valid;
+}
+
+/*
+ * test_header_flags: ROTOR_FLAG_ bits make it through the header, unknown
+ * ones are refused
+ */
+
+static uint8_t test_header_flags() {
+  uint8_t head[ROTOR_HEADER_LEN];
+  rotor_ctx *ectx, *dctx;
+  uint8_t valid = 1;
+
+  ectx = rotor_ctx_new(&kp, ROTOR_MODE_SYM);
+  dctx = rotor_ctx_new(&kp, ROTOR_MODE_SYM);
+  rotor_ctx_allow_unauth(dctx, 1);
+  valid &= rotor_ctx_set_flags(ectx, 0x80) == ROTOR_ERR_PARAM;
+  valid &= rotor_ctx_set_flags(ectx, ROTOR_FLAG_BZIP2) == ROTOR_SUCCESS;
+  valid &= rotor_ctx_encrypt_init(ectx, ROTOR_LEN_STREAM, head) == ROTOR_SUCCESS;
+  valid &= rotor_ctx_decrypt_init(dctx, head) == ROTOR_SUCCESS;
+  valid &= rotor_ctx_flags(dctx) == ROTOR_FLAG_BZIP2;
+  head[8] |= 0x80;
+  valid &= rotor_ctx_decrypt_init(dctx, head) == ROTOR_ERR_FORMAT;
+  valid &= rotor_ctx_set_flags(ectx, 0) == ROTOR_SUCCESS;
+  valid &= rotor_ctx_encrypt_init(ectx, 1000, head) == ROTOR_SUCCESS;
+  valid &= rotor_ctx_decrypt_init(dctx, head) == ROTOR_SUCCESS;
+  valid &= rotor_ctx_flags(dctx) == 0;
+  rotor_ctx_free(ectx);
+  rotor_ctx_free(dctx);
+  print_result("test_header_flags", valid);
+  return valid;
+}
+
+/*
+ * test_sparse_file: a several hundred GB sparse file is sized and read
+ * through off_t cleanly, and its header holds the exact size
+ */
+
+static uint8_t test_sparse_file() {
+  char fname[] = "/tmp/rotor-test-XXXXXX";
+  uint8_t head[ROTOR_HEADER_LEN];
+  uint8_t buf[ROTOR_BLOCK], out[ROTOR_BLOCK];
+  uint64_t size, segments;
+  struct stat st;
+  rotor_ctx *ectx, *dctx;
+  size_t out_len;
+  int fd;
+  uint8_t valid = 1;
+
+  fd = mkstemp(fname);
+  if ((fd < 0) || ftruncate(fd, TEST_SPARSE_SIZE)) {
+    if (fd >= 0) {
+      close(fd);
+      unlink(fname);
+    }
+    print_result("test_sparse_file (skipped)", 1);
+    return 1;
+  }
+  valid &= (fstat(fd, &st) == 0) && ((uint64_t)st.st_size == TEST_SPARSE_SIZE);
+  valid &= pread(fd, buf, sizeof(buf), st.st_size - sizeof(buf)) == sizeof(buf);
+  ectx = rotor_ctx_new(&kp, ROTOR_MODE_SYM);
+  dctx = rotor_ctx_new(&kp, ROTOR_MODE_SYM);
+  rotor_ctx_allow_unauth(dctx, 1);
+  valid &= rotor_ctx_encrypt_init(ectx, st.st_size, head) == ROTOR_SUCCESS;
+  valid &= rotor_ctx_update(ectx, buf, sizeof(buf), out, &out_len) == ROTOR_SUCCESS;
+  valid &= rotor_ctx_final(ectx, out, &out_len) == ROTOR_ERR_LENGTH; // not all there
+  valid &= rotor_ctx_decrypt_init(dctx, head) == ROTOR_SUCCESS;
+  rotor_ctx_info(dctx, &size, &segments);
+  valid &= (size == TEST_SPARSE_SIZE) && (segments == (TEST_SPARSE_SIZE + 169) / 170);
+  rotor_ctx_free(ectx);
+  rotor_ctx_free(dctx);
+  close(fd);
+  unlink(fname);
+  print_result("test_sparse_file", valid);
+  return valid;
+}
+
+/*
+ * test_load: the file TEST_V1_DIR name into buf, 0 if it isn't there or
+ * doesn't fit
+ */
+
+static size_t test_load(const char *name, uint8_t *buf, size_t size) {
+  char fname[256];
+  size_t len;
+  FILE *f;
+
+  snprintf(fname, sizeof(fname), "%s%s", TEST_V1_DIR, name);
+  if ((f = fopen(fname, "rb")) == NULL)
+    return 0;
+  len = fread(buf, 1, size, f);
+  if (fgetc(f) != EOF)
+    len = 0;
+  fclose(f);
+  return len;
+}
+
+/*
+ * test_v1_files: fixed v1 files, sym and ext, still decrypt under their key
+ * pair, through update and from memory, and have no MAC to verify
+ */
+
+static uint8_t test_v1_files() {
+  static const char *names[2][2] = {{"sym.enc", NULL}, {"ext.key", "ext.enc"}};
+  uint8_t plain[200], priv[NTRU_PRIVLEN], pub[NTRU_PUBLEN];
+  uint8_t *file, *dec;
+  NtruEncKeyPair v1kp;
+  size_t len, hlen, dec_len;
+  rotor_ctx *dctx;
+  int i, mode;
+  uint8_t valid = 1;
+
+  file = malloc(4*NTRU_ENCLEN + ROTOR_HEADER_LEN);
+  dec = malloc(4*NTRU_ENCLEN + ROTOR_HEADER_LEN);
+  for (i=0; i<sizeof(plain); i++)
+    plain[i] = i*7;
+  valid &= test_load("key.priv", priv, sizeof(priv)) == sizeof(priv);
+  valid &= test_load("key.pub", pub, sizeof(pub)) == sizeof(pub);
+  ntru_import_priv(priv, &v1kp.priv);
+  valid &= ntru_import_pub(pub, &v1kp.pub) == NTRU_PUBLEN;
+  for (mode=ROTOR_MODE_SYM; (valid) && (mode<=ROTOR_MODE_EXT); mode++) {
+    len = test_load(names[mode][0], file, 4*NTRU_ENCLEN + ROTOR_HEADER_LEN);
+    hlen = rotor_ctx_header_len(file);
+    valid &= (len >= hlen) && (hlen == sizeof(struct fileHeader) + 2*NTRU_ENCLEN);
+    if (names[mode][1])
+      len += test_load(names[mode][1], file + len, 4*NTRU_ENCLEN);
+    dctx = rotor_ctx_new(&v1kp, mode);
+    valid &= rotor_ctx_decrypt_init(dctx, file) == ROTOR_SUCCESS;
+    valid &= rotor_ctx_flags(dctx) == 0;
+    valid &= test_crypt(dctx, file + hlen, len - hlen, 100, dec, &dec_len);
+    valid &= (dec_len == sizeof(plain)) && (memcmp(dec, plain, sizeof(plain)) == 0);
+    valid &= rotor_ctx_decrypt_mem(dctx, file, len, dec, &dec_len) == ROTOR_SUCCESS;
+    valid &= (dec_len == sizeof(plain)) && (memcmp(dec, plain, sizeof(plain)) == 0);
+    valid &= rotor_ctx_verify_init(dctx, file) == ROTOR_ERR_NOMAC;
+    rotor_ctx_free(dctx);
+  }
+  free(file);
+  free(dec);
+  print_result("test_v1_files", valid);
+  return valid;
+}
+
+/*
+ * test_mac: ROTOR_FLAG_MAC files round trip and verify, a flipped bit in the
+ * header or the body fails both, and a file without the flag can't verify
+ * even when it may be decrypted
+ */
+
+static uint8_t test_mac() {
+  uint8_t head[ROTOR_HEADER_LEN], bad[ROTOR_HEADER_LEN];
+  uint8_t *plain, *enc, *dec;
+  size_t enc_len, dec_len;
+  rotor_ctx *ectx, *dctx;
+  int i, mode, stream;
+  uint8_t valid = 1;
+
+  plain = malloc(1000);
+  enc = malloc(20000);
+  dec = malloc(20000);
+  for (i=0; i<1000; i++)
+    plain[i] = rand();
+  for (mode=ROTOR_MODE_SYM; mode<=ROTOR_MODE_EXT; mode++) {
+    ectx = rotor_ctx_new(&kp, mode);
+    dctx = rotor_ctx_new(&kp, mode);
+    valid &= rotor_ctx_set_flags(ectx, ROTOR_FLAG_MAC) == ROTOR_SUCCESS;
+    for (stream=0; stream<2; stream++) {
+      valid &= rotor_ctx_encrypt_init(ectx, stream ? ROTOR_LEN_STREAM : 1000, head) == ROTOR_SUCCESS;
+      valid &= test_crypt(ectx, plain, 1000, 300, enc, &enc_len);
+      valid &= rotor_ctx_decrypt_init(dctx, head) == ROTOR_SUCCESS;
+      valid &= rotor_ctx_flags(dctx) == ROTOR_FLAG_MAC;
+      valid &= test_crypt(dctx, enc, enc_len, 4096, dec, &dec_len);
+      valid &= (dec_len == 1000) && (memcmp(dec, plain, dec_len) == 0);
+      valid &= rotor_ctx_verify_init(dctx, head) == ROTOR_SUCCESS;
+      valid &= test_crypt(dctx, enc, enc_len, 77, dec, &dec_len) && (dec_len == 0);
+      enc[enc_len / 2] ^= 1;
+      valid &= rotor_ctx_verify_init(dctx, head) == ROTOR_SUCCESS;
+      valid &= !test_crypt(dctx, enc, enc_len, 4096, dec, &dec_len);
+      valid &= rotor_ctx_decrypt_init(dctx, head) == ROTOR_SUCCESS;
+      valid &= !test_crypt(dctx, enc, enc_len, 4096, dec, &dec_len);
+      enc[enc_len / 2] ^= 1;
+      memcpy(bad, head, ROTOR_HEADER_LEN);
+      bad[ROTOR_HEADER_LEN - 1] ^= 1;
+      if (rotor_ctx_verify_init(dctx, bad) == ROTOR_SUCCESS)
+	valid &= !test_crypt(dctx, enc, enc_len, 4096, dec, &dec_len);
+    }
+    valid &= rotor_ctx_set_flags(ectx, 0) == ROTOR_SUCCESS;
+    valid &= rotor_ctx_encrypt_init(ectx, 1000, head) == ROTOR_SUCCESS;
+    valid &= rotor_ctx_verify_init(dctx, head) == ROTOR_ERR_NOMAC;
+    rotor_ctx_allow_unauth(dctx, 1);
+    valid &= rotor_ctx_verify_init(dctx, head) == ROTOR_ERR_NOMAC;
+    rotor_ctx_free(ectx);
+    rotor_ctx_free(dctx);
+  }
+  free(plain);
+  free(enc);
+  free(dec);
+  print_result("test_mac", valid);
+  return valid;
+}
+
+/*
+ * test_mac_strip: a MAC file with the MAC and index flags cleared and the
+ * tag cut off is refused, and neither that nor turning it into a v1 file
+ * decrypts it when unauthenticated files are let through
+ */
+
+static uint8_t test_mac_strip() {
+  uint8_t head[ROTOR_HEADER_LEN], bad[ROTOR_HEADER_LEN];
+  struct fileHeader v1;
+  uint8_t *plain, *enc, *dec;
+  size_t enc_len, dec_len;
+  rotor_ctx *ectx, *dctx;
+  int i, mode, stream;
+  uint8_t valid = 1;
+
+  plain = malloc(1000);
+  enc = malloc(20000);
+  dec = malloc(20000);
+  for (i=0; i<1000; i++)
+    plain[i] = rand();
+  for (mode=ROTOR_MODE_SYM; mode<=ROTOR_MODE_EXT; mode++) {
+    ectx = rotor_ctx_new(&kp, mode);
+    dctx = rotor_ctx_new(&kp, mode);
+    for (stream=0; stream<2; stream++) {
+      valid &= rotor_ctx_set_flags(ectx, ROTOR_FLAG_MAC | ((stream) ? 0 : ROTOR_FLAG_INDEX)) == ROTOR_SUCCESS;
+      valid &= rotor_ctx_encrypt_init(ectx, (stream) ? ROTOR_LEN_STREAM : 1000, head) == ROTOR_SUCCESS;
+      valid &= test_crypt(ectx, plain, 1000, 1000, enc, &enc_len);
+      enc_len -= ROTOR_MAC_LEN;
+      memcpy(bad, head, ROTOR_HEADER_LEN);
+      bad[8] &= ~(ROTOR_V2_MAC | ROTOR_V2_INDEX);
+      rotor_ctx_allow_unauth(dctx, 0);
+      valid &= rotor_ctx_decrypt_init(dctx, bad) == ROTOR_ERR_NOMAC;
+      valid &= rotor_ctx_update(dctx, enc, enc_len, dec, &dec_len) == ROTOR_ERR_PARAM;
+      rotor_ctx_allow_unauth(dctx, 1);
+      valid &= rotor_ctx_decrypt_init(dctx, bad) == ROTOR_SUCCESS;
+      valid &= !test_crypt(dctx, enc, enc_len, 4096, dec, &dec_len) || (dec_len != 1000) ||
+	(memcmp(dec, plain, 1000) != 0);
+      if (stream)
+	continue;
+      v1.fileSize = 1000 / ROTOR_BLOCK;
+      v1.cryptMode = mode;
+      memset(bad, 0, sizeof(bad));
+      memcpy(bad, &v1, sizeof(v1));
+      memcpy(bad + sizeof(v1), head + ROTOR_V2_LEN, 2*NTRU_ENCLEN);
+      if (rotor_ctx_decrypt_init(dctx, bad) == ROTOR_SUCCESS) // the v1 remainder comes out of shake_key
+	valid &= !test_crypt(dctx, enc, enc_len, 4096, dec, &dec_len) || (dec_len != 1000) ||
+	  (memcmp(dec, plain, 1000) != 0);
+    }
+    rotor_ctx_free(ectx);
+    rotor_ctx_free(dctx);
+  }
+  free(plain);
+  free(enc);
+  free(dec);
+  print_result("test_mac_strip", valid);
+  return valid;
+}
+
+/*
+ * test_index: every segment of a ROTOR_FLAG_INDEX file checks on its own, a
+ * flipped bit fails only its segment, segments can't trade places and an
+ * altered index or a file without one doesn't get that far
+ */
+
+static uint8_t test_index() {
+  uint8_t head[ROTOR_HEADER_LEN];
+  uint8_t *plain, *enc, *dec, *index;
+  const uint8_t *idx;
+  size_t enc_len, dec_len, index_len, seg_len, len;
+  uint64_t count, body_len, seg;
+  rotor_ctx *ectx, *dctx;
+  int mode, stream;
+  uint8_t valid = 1;
+
+  plain = malloc(2500000);
+  enc = malloc(4000000);
+  dec = malloc(2500000 + ROTOR_FINAL_MAX);
+  for (len=0; len<2500000; len++)
+    plain[len] = rand();
+  for (mode=ROTOR_MODE_SYM; mode<=ROTOR_MODE_EXT; mode++) {
+    len = (mode == ROTOR_MODE_SYM) ? 2500000 : 250000; // three segments either way
+    ectx = rotor_ctx_new(&kp, mode);
+    dctx = rotor_ctx_new(&kp, mode);
+    valid &= rotor_ctx_set_flags(ectx, ROTOR_FLAG_MAC | ROTOR_FLAG_INDEX) == ROTOR_SUCCESS;
+    for (stream=0; stream<2; stream++) {
+      valid &= rotor_ctx_encrypt_init(ectx, stream ? ROTOR_LEN_STREAM : len, head) == ROTOR_SUCCESS;
+      valid &= test_crypt(ectx, plain, len, 65536, enc, &enc_len);
+      valid &= (idx = rotor_ctx_index(ectx, &index_len)) != NULL;
+      if (!idx)
+	break;
+      index = malloc(index_len);
+      memcpy(index, idx, index_len);
+      valid &= rotor_ctx_index_len(dctx, index + index_len - ROTOR_IDX_FOOT, &body_len) == index_len;
+      valid &= body_len == enc_len;
+      valid &= rotor_ctx_index_init(dctx, head, index, index_len) == ROTOR_SUCCESS;
+      rotor_ctx_index_info(dctx, &count, &seg_len, &body_len);
+      valid &= (count == 3) && (body_len == enc_len);
+      for (seg=0; seg<count; seg++)
+	valid &= rotor_ctx_verify_segment(dctx, seg, enc + seg * seg_len,
+					  (seg + 1 < count) ? seg_len : enc_len - seg * seg_len) == ROTOR_SUCCESS;
+      valid &= rotor_ctx_verify_segment(dctx, 0, enc + seg_len, seg_len) == ROTOR_ERR_MAC;
+      valid &= rotor_ctx_verify_segment(dctx, 0, enc, seg_len - 1) == ROTOR_ERR_LENGTH;
+      valid &= rotor_ctx_verify_segment(dctx, count, enc, seg_len) == ROTOR_ERR_PARAM;
+      enc[seg_len + 5] ^= 1;
+      valid &= rotor_ctx_verify_segment(dctx, 0, enc, seg_len) == ROTOR_SUCCESS;
+      valid &= rotor_ctx_verify_segment(dctx, 1, enc + seg_len, seg_len) == ROTOR_ERR_MAC;
+      enc[seg_len + 5] ^= 1;
+      index[ROTOR_IDX_TAG + 3] ^= 1;
+      valid &= rotor_ctx_index_init(dctx, head, index, index_len) == ROTOR_ERR_MAC;
+      valid &= rotor_ctx_verify_segment(dctx, 0, enc, seg_len) == ROTOR_ERR_PARAM;
+      index[ROTOR_IDX_TAG + 3] ^= 1;
+      valid &= rotor_ctx_index_init(dctx, head, index, index_len - ROTOR_IDX_TAG) != ROTOR_SUCCESS;
+      valid &= rotor_ctx_decrypt_init(dctx, head) == ROTOR_SUCCESS; // the index isn't part of the body
+      valid &= test_crypt(dctx, enc, enc_len, 4096, dec, &dec_len);
+      valid &= (dec_len == len) && (memcmp(dec, plain, len) == 0);
+      free(index);
+    }
+    valid &= rotor_ctx_set_flags(ectx, ROTOR_FLAG_MAC) == ROTOR_SUCCESS;
+    valid &= rotor_ctx_encrypt_init(ectx, 1000, head) == ROTOR_SUCCESS;
+    valid &= test_crypt(ectx, plain, 1000, 1000, enc, &enc_len);
+    valid &= rotor_ctx_index(ectx, &index_len) == NULL;
+    valid &= rotor_ctx_index_init(dctx, head, enc, ROTOR_IDX_FOOT) == ROTOR_ERR_FORMAT;
+    rotor_ctx_free(ectx);
+    rotor_ctx_free(dctx);
+  }
+  free(plain);
+  free(enc);
+  free(dec);
+  print_result("test_index", valid);
+  return valid;
+}
+
+/*
+ * test_decrypt_mem: whole files in memory round trip, index and all, and a
+ * body a block short or long is refused before any of it is decrypted
+ */
+
+static uint8_t test_decrypt_mem() {
+  uint8_t *plain, *file, *dec;
+  const uint8_t *idx;
+  size_t len, enc_len, n, index_len, dec_len, cb;
+  rotor_ctx *ectx, *dctx;
+  int mode, stream;
+  uint8_t valid = 1;
+
+  plain = malloc(1000);
+  file = malloc(ROTOR_HEADER_LEN + 20000);
+  dec = malloc(ROTOR_HEADER_LEN + 20000);
+  for (len=0; len<1000; len++)
+    plain[len] = rand();
+  for (mode=ROTOR_MODE_SYM; mode<=ROTOR_MODE_EXT; mode++) {
+    cb = (mode == ROTOR_MODE_EXT) ? NTRU_ENCLEN : ROTOR_BLOCK;
+    ectx = rotor_ctx_new(&kp, mode);
+    dctx = rotor_ctx_new(&kp, mode);
+    for (stream=0; stream<2; stream++) {
+      valid &= rotor_ctx_set_flags(ectx, ROTOR_FLAG_MAC | ((stream) ? 0 : ROTOR_FLAG_INDEX)) == ROTOR_SUCCESS;
+      valid &= rotor_ctx_encrypt_init(ectx, (stream) ? ROTOR_LEN_STREAM : 1000, file) == ROTOR_SUCCESS;
+      valid &= test_crypt(ectx, plain, 1000, 1000, file + ROTOR_HEADER_LEN, &enc_len);
+      len = ROTOR_HEADER_LEN + enc_len;
+      if ((idx = rotor_ctx_index(ectx, &index_len))) {
+	memcpy(file + len, idx, index_len);
+	len += index_len;
+      }
+      valid &= rotor_ctx_decrypt_mem(dctx, file, len, dec, &dec_len) == ROTOR_SUCCESS;
+      valid &= (dec_len == 1000) && (memcmp(dec, plain, 1000) == 0);
+      valid &= rotor_ctx_decrypt_mem(dctx, file, ROTOR_HEADER_LEN - 1, dec, &dec_len) == ROTOR_ERR_FORMAT;
+    }
+    // sized without an index: too short or too long is known from the header
+    rotor_ctx_allow_unauth(dctx, 1);
+    valid &= rotor_ctx_set_flags(ectx, 0) == ROTOR_SUCCESS;
+    valid &= rotor_ctx_encrypt_init(ectx, 1000, file) == ROTOR_SUCCESS;
+    valid &= test_crypt(ectx, plain, 1000, 1000, file + ROTOR_HEADER_LEN, &enc_len);
+    len = ROTOR_HEADER_LEN + enc_len;
+    valid &= rotor_ctx_decrypt_mem(dctx, file, len - cb, dec, &dec_len) == ROTOR_ERR_LENGTH;
+    valid &= dec_len == 0;
+    memcpy(file + len, file + len - cb, cb);
+    valid &= rotor_ctx_decrypt_mem(dctx, file, len + cb, dec, &dec_len) == ROTOR_ERR_LENGTH;
+    valid &= dec_len == 0;
+    // and through update, the block past the end fails when it arrives
+    valid &= rotor_ctx_decrypt_init(dctx, file) == ROTOR_SUCCESS;
+    valid &= rotor_ctx_update(dctx, file + ROTOR_HEADER_LEN, enc_len + cb, dec, &n) == ROTOR_ERR_LENGTH;
+    valid &= rotor_ctx_final(dctx, dec, &n) != ROTOR_SUCCESS;
+    valid &= rotor_ctx_decrypt_mem(dctx, file, len, dec, &dec_len) == ROTOR_SUCCESS;
+    valid &= (dec_len == 1000) && (memcmp(dec, plain, 1000) == 0);
+    rotor_ctx_free(ectx);
+    rotor_ctx_free(dctx);
+  }
+  free(plain);
+  free(file);
+  free(dec);
+  print_result("test_decrypt_mem", valid);
+  return valid;
+}
+
+uint8_t test_ctx() {
+  NtruRandGen rng = NTRU_RNG_DEFAULT;
+  NtruRandContext rand_ctx;
+  uint8_t valid;
+
+  if ((ntru_rand_init(&rand_ctx, &rng) != NTRU_SUCCESS) ||
+      (ntru_gen_key_pair(&EES1087EP2, &kp, &rand_ctx) != NTRU_SUCCESS)) {
+    print_result("test_ctx keygen", 0);
+    return 0;
+  }
+  ntru_rand_release(&rand_ctx);
+  valid = test_roundtrip();
+  valid &= test_header_sizes();
+  valid &= test_header_flags();
+  valid &= test_sparse_file();
+  valid &= test_v1_files();
+  valid &= test_mac();
+  valid &= test_mac_strip();
+  valid &= test_index();
+  valid &= test_decrypt_mem();
+  return valid;
+}
@@ -0,0 +1,8 @@
+#ifndef TEST_CTX_H
+#define TEST_CTX_H
+
+#include <stdint.h>
+
+uint8_t test_ctx();
+
+#endif
@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include "rotor-digest.h"
+#include "test_digest.h"
+
+static void print_result(char *test_name, uint8_t valid) {
+  printf("  %-30s%s\n", test_name, valid?"OK":"FAIL");
+}
+
+/*
+ * test_digest_kat: 3000 bytes, leaf 1, fanout 1, against Skein_TreeHash in
+ * skein_test.c
+ */
+
+static uint8_t test_digest_kat() {
+  static const uint8_t kat[ROTOR_DIGEST_LEN] = {
+    0x1f, 0x73, 0xdf, 0x5f, 0xff, 0xa5, 0x2c, 0xb0, 0xe8, 0x50, 0xa0, 0xd5,
+    0xf3, 0x9d, 0x92, 0x59, 0xe7, 0x17, 0xd0, 0x83, 0xad, 0x5a, 0x64, 0x16,
+    0xac, 0x15, 0x9f, 0x76, 0x08, 0xda, 0x7f, 0x1e, 0xfb, 0xe8, 0x6e, 0xaa,
+    0x44, 0xf0, 0xbd, 0xc3, 0xe5, 0x30, 0x0f, 0xd9, 0xe3, 0xc3, 0xbd, 0x6f,
+    0x3b, 0x96, 0x01, 0x7d, 0x25, 0xef, 0x8b, 0xd9, 0xbe, 0x9c, 0x6e, 0x05,
+    0xf6, 0xad, 0x54, 0x25};
+  uint8_t msg[3000], digest[ROTOR_DIGEST_LEN];
+  uint8_t valid;
+  int i;
+
+  for (i=0; i<sizeof(msg); i++)
+    msg[i] = i*7;
+  valid = rotor_digest_mem(msg, sizeof(msg), 1, 1, 1, digest) == 0;
+  valid &= memcmp(digest, kat, ROTOR_DIGEST_LEN) == 0;
+  print_result("test_digest_kat", valid);
+  return valid;
+}
+
+/*
+ * test_digest_threads: thread count and spans never change the digest, the
+ * file version agrees with the memory one, parameters and data do
+ */
+
+static uint8_t test_digest_threads() {
+  size_t sizes[] = {0, 1, 65536, 65537, ROTOR_DIGEST_SPAN, 3*ROTOR_DIGEST_SPAN + 12345};
+  uint8_t one[ROTOR_DIGEST_LEN], many[ROTOR_DIGEST_LEN], other[ROTOR_DIGEST_LEN];
+  char fname[] = "/tmp/rotor-test-XXXXXX";
+  uint64_t len;
+  uint8_t *buf;
+  size_t n = 3*ROTOR_DIGEST_SPAN + 12345;
+  int fd, i;
+  uint8_t valid = 1;
+
+  buf = malloc(n);
+  for (i=0; i<n; i++)
+    buf[i] = rand();
+  for (i=0; i<sizeof(sizes)/sizeof(sizes[0]); i++) {
+    valid &= rotor_digest_mem(buf, sizes[i], ROTOR_DIGEST_LEAF, ROTOR_DIGEST_FANOUT, 1, one) == 0;
+    valid &= rotor_digest_mem(buf, sizes[i], ROTOR_DIGEST_LEAF, ROTOR_DIGEST_FANOUT, 3, many) == 0;
+    valid &= memcmp(one, many, ROTOR_DIGEST_LEN) == 0;
+  }
+  valid &= rotor_digest_mem(buf, n, ROTOR_DIGEST_LEAF, ROTOR_DIGEST_FANOUT + 1, 1, other) == 0;
+  valid &= memcmp(one, other, ROTOR_DIGEST_LEN) != 0;
+  fd = mkstemp(fname);
+  if (fd >= 0) {
+    valid &= write(fd, buf, n) == n;
+    close(fd);
+    valid &= rotor_digest_file(fname, ROTOR_DIGEST_LEAF, ROTOR_DIGEST_FANOUT, other, &len) == 0;
+    valid &= (len == n) && (memcmp(one, other, ROTOR_DIGEST_LEN) == 0);
+    unlink(fname);
+  }
+  buf[n / 2] ^= 1;
+  valid &= rotor_digest_mem(buf, n, ROTOR_DIGEST_LEAF, ROTOR_DIGEST_FANOUT, 2, other) == 0;
+  valid &= memcmp(one, other, ROTOR_DIGEST_LEN) != 0;
+  valid &= rotor_digest_mem(buf, n, 0, ROTOR_DIGEST_FANOUT, 1, other) != 0;
+  free(buf);
+  print_result("test_digest_threads", valid);
+  return valid;
+}
+
+uint8_t test_digest() {
+  uint8_t valid;
+
+  valid = test_digest_kat();
+  valid &= test_digest_threads();
+  return valid;
+}
@@ -0,0 +1,8 @@
+#ifndef TEST_DIGEST_H
+#define TEST_DIGEST_H
+
+#include <stdint.h>
+
+uint8_t test_digest();
+
+#endif
@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include "ntru.h"
+#include "yescrypt.h"
+#include "rotor.h"
+#include "rotor-keys.h"
+#include "rotor-hex.h"
+#include "test_keys.h"
+
+static void print_result(char *test_name, uint8_t valid) {
+  printf("  %-30s%s\n", test_name, valid?"OK":"FAIL");
+}
+
+/*
+ * test_read: an exported key file into buf, 0 if it can't be read
+ */
+
+static size_t test_read(const char *fname, char *buf, size_t size) {
+  size_t len;
+  FILE *f;
+
+  if ((f = fopen(fname, "rb")) == NULL)
+    return 0;
+  fseek(f, strlen(PRIVATE_KEYTAG), SEEK_SET);
+  len = fread(buf, 1, size, f);
+  fclose(f);
+  return len;
+}
+
+/*
+ * test_keys_batch_pad: two keys exported under one armor stream the way
+ * rotor_batch_keygen does are xored with different pads, and both come
+ * back through rotor_dearmor_priv. an unsalted key still loads
+ */
+
+static uint8_t test_keys_batch_pad() {
+  char fname[2][32] = {"/tmp/rotor-key-XXXXXX", "/tmp/rotor-key-XXXXXX"};
+  uint8_t stream[NTRU_PRIVLEN], priv[2][NTRU_PRIVLEN], salt[2][ROTOR_ARMOR_SALT];
+  uint8_t enc[2][NTRU_PRIVLEN], out[NTRU_PRIVLEN];
+  char buf[2][(NTRU_PRIVLEN+ROTOR_ARMOR_SALT)*3];
+  size_t len[2];
+  int i, k, same;
+  uint8_t valid = 1;
+
+  for (i=0; i<NTRU_PRIVLEN; i++) {
+    stream[i] = i*13;
+    priv[0][i] = i*7;
+    priv[1][i] = i*7 + (i == 100); // one bit apart
+  }
+  for (k=0; k<2; k++) {
+    memset(salt[k], k + 1, ROTOR_ARMOR_SALT);
+    close(mkstemp(fname[k]));
+    rotor_exp_armorpriv_stream(priv[k], stream, salt[k], fname[k]);
+    len[k] = test_read(fname[k], buf[k], sizeof(buf[k]));
+    valid &= rotor_hex_dearmor(buf[k], len[k], enc[k], NTRU_PRIVLEN) == NTRU_PRIVLEN;
+    valid &= rotor_dearmor_priv(buf[k], len[k], stream, out) == 0;
+    valid &= memcmp(out, priv[k], NTRU_PRIVLEN) == 0;
+  }
+  // a shared pad cancels out: enc0 ^ enc1 would be priv0 ^ priv1
+  same = 1;
+  for (i=0; i<NTRU_PRIVLEN; i++)
+    same &= (enc[0][i] ^ enc[1][i]) == (priv[0][i] ^ priv[1][i]);
+  valid &= !same;
+  valid &= rotor_dearmor_priv(buf[0], len[0] / 2, stream, out) == -1; // cut short
+
+  rotor_exp_armorpriv_stream(priv[0], stream, NULL, fname[0]);
+  len[0] = test_read(fname[0], buf[0], sizeof(buf[0]));
+  valid &= rotor_hex_dearmor(buf[0], len[0], enc[0], NTRU_PRIVLEN) == NTRU_PRIVLEN;
+  same = 1;
+  for (i=0; i<NTRU_PRIVLEN; i++)
+    same &= enc[0][i] == (priv[0][i] ^ stream[i]);
+  valid &= same;
+  valid &= rotor_dearmor_priv(buf[0], len[0], stream, out) == 0;
+  valid &= memcmp(out, priv[0], NTRU_PRIVLEN) == 0;
+  unlink(fname[0]);
+  unlink(fname[1]);
+  print_result("test_keys_batch_pad", valid);
+  return valid;
+}
+
+uint8_t test_keys() {
+  return test_keys_batch_pad();
+}
@@ -0,0 +1,8 @@
+#ifndef TEST_KEYS_H
+#define TEST_KEYS_H
+
+#include <stdint.h>
+
+uint8_t test_keys();
+
+#endif
@@ -183,3 +183,41 @@ yescrypt_free_local(yescrypt_local_t * local)
 {
 	return free_region(local);
 }
+
+int
+yescrypt_reserve_local(yescrypt_local_t * local, size_t size,
+    yescrypt_local_flags_t flags)
+{
+	volatile uint8_t * p;
+	size_t i;
+
+	if (local->aligned_size >= size)
+		return 0;
+	if (free_region(local) || !alloc_region(local, size))
+		return -1;
+
+#if defined(MADV_HUGEPAGE) && defined(HUGEPAGE_SIZE)
+/*
+ * If MAP_HUGETLB wasn't available (no preallocated huge pages), at least ask
+ * for transparent huge pages before the region gets faulted in.
+ */
+	if (size >= HUGEPAGE_THRESHOLD && local->base_size == size)
+		madvise(local->base, local->base_size, MADV_HUGEPAGE);
+#endif
+
+	if (flags & YESCRYPT_LOCAL_PREFAULT) {
+		p = local->base;
+		for (i = 0; i < local->base_size; i += 4096)
+			p[i] = 0;
+	}
+
+	if ((flags & YESCRYPT_LOCAL_MLOCK) &&
+	    mlock(local->base, local->base_size)) {
+		int save_errno = errno;
+		free_region(local);
+		errno = save_errno;
+		return -1;
+	}
+
+	return 0;
+}
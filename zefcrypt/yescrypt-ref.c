@@ -744,6 +744,42 @@ free_V:
 	return retval;
 }
 
+/**
+ * yescrypt_local_size(N, r, p, g, flags):
+ * Return the size of the memory that yescrypt_kdf_body() allocates for the
+ * largest of the g + 1 passes made by yescrypt_kdf(), mirroring the
+ * allocations above.  This implementation allocates it afresh on every call.
+ */
+size_t
+yescrypt_local_size(uint64_t N, uint32_t r, uint32_t p, uint32_t g,
+    yescrypt_flags_t flags)
+{
+	size_t B_size, V_size, XY_size, need;
+
+	if (g > 31 || N > (UINT32_MAX >> (2 * g)))
+		return 0;
+	N <<= 2 * g;
+	if (!N || !r || !p || (r > SIZE_MAX / 256 / p) ||
+	    (N > SIZE_MAX / 128 / r))
+		return 0;
+
+	V_size = (size_t)128 * r * N;
+	B_size = (size_t)128 * r * p;
+	XY_size = (size_t)256 * r;
+	need = V_size + B_size;
+	if (need < B_size || need + XY_size < XY_size)
+		return 0;
+	need += XY_size;
+	if (flags & YESCRYPT_RW) {
+		if (p > SIZE_MAX / Sbytes ||
+		    need + (size_t)Sbytes * p < need)
+			return 0;
+		need += (size_t)Sbytes * p;
+	}
+
+	return need;
+}
+
 /**
  * yescrypt_kdf(shared, local, passwd, passwdlen, salt, saltlen,
  *     N, r, p, t, g, flags, buf, buflen):
@@ -876,3 +912,16 @@ yescrypt_free_local(yescrypt_local_t * local)
 /* The reference implementation frees its memory in yescrypt_kdf() */
 	return 0;
 }
+
+int
+yescrypt_reserve_local(yescrypt_local_t * local, size_t size,
+    yescrypt_local_flags_t flags)
+{
+/*
+ * The reference implementation allocates its memory in yescrypt_kdf() and
+ * frees it before returning, so there is nothing to reserve, prefault or lock
+ * ahead of time.  Succeed and leave local as it is, so that callers work
+ * unchanged.
+ */
+	return 0;
+}
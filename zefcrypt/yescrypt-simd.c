@@ -1320,6 +1320,52 @@ yescrypt_kdf_body(const yescrypt_shared_t * shared, yescrypt_local_t * local,
 	return 0;
 }
 
+/**
+ * yescrypt_local_size(N, r, p, g, flags):
+ * Return the size of the thread-local (RAM) data structure that
+ * yescrypt_kdf_body() allocates for the largest of the g + 1 passes made by
+ * yescrypt_kdf(), mirroring the computation of "need" above.
+ */
+size_t
+yescrypt_local_size(uint64_t N, uint32_t r, uint32_t p, uint32_t g,
+    yescrypt_flags_t flags)
+{
+	size_t B_size, V_size, XY_size, need;
+
+	if (g > 31 || N > (UINT32_MAX >> (2 * g)))
+		return 0;
+	N <<= 2 * g;
+	if (!N || !r || !p || (r > SIZE_MAX / 256 / p) ||
+	    (N > SIZE_MAX / 128 / r))
+		return 0;
+
+	V_size = (size_t)128 * r * N;
+#ifdef _OPENMP
+	if (!(flags & YESCRYPT_RW)) {
+		if (N > SIZE_MAX / 128 / (r * p))
+			return 0;
+		V_size *= p;
+	}
+#endif
+	B_size = (size_t)128 * r * p;
+	XY_size = (size_t)256 * r;
+#ifdef _OPENMP
+	XY_size *= p;
+#endif
+	need = V_size + B_size;
+	if (need < B_size || need + XY_size < XY_size)
+		return 0;
+	need += XY_size;
+	if (flags & YESCRYPT_RW) {
+		if (p > SIZE_MAX / Salloc ||
+		    need + (size_t)Salloc * p < need)
+			return 0;
+		need += (size_t)Salloc * p;
+	}
+
+	return need;
+}
+
 /**
  * yescrypt_kdf(shared, local, passwd, passwdlen, salt, saltlen,
  *     N, r, p, t, g, flags, buf, buflen):